@@ -0,0 +1,593 @@
+#include "bench_circuits.h"
+
+#include <algorithm>
+#include <cmath>
+
+using Signal  = CircuitGenerator::Signal;
+using Signals = CircuitGenerator::Signals;
+using Bits    = std::vector<uint8_t>;
+
+#define ADDER_BITS        1024
+#define MULTIPLIER_BITS   64
+#define LFSR_COUNT        256
+#define LFSR_WIDTH        16
+#define LFSR_RESET_CYCLES 4
+#define LATCH_WORDS       256
+#define LATCH_WIDTH       32
+
+static void drive(const std::vector<net_id_t>& nets, const Bits& bits, std::vector<NetDrive>& drives)
+{
+	for (size_t i = 0; i < nets.size(); ++i)
+		drives.push_back({ nets[i], to_logic_value(bits[i]) });
+}
+
+// false if any of the nets is not 0 or 1
+static bool read(const std::vector<net_id_t>& nets, const std::vector<uint8_t>& net_values, Bits& bits)
+{
+	bits.resize(nets.size());
+
+	for (size_t i = 0; i < nets.size(); ++i) {
+		auto value = (LogicValue)net_values[nets[i]];
+
+		if (value != Logic_0 && value != Logic_1) return false;
+
+		bits[i] = value == Logic_1;
+	}
+
+	return true;
+}
+
+static Bits random_bits(std::mt19937& rng, size_t width)
+{
+	Bits bits(width);
+
+	for (auto& bit : bits)
+		bit = rng() & 1;
+
+	return bits;
+}
+
+// a + b + carry, one bit longer than the longer operand
+static Bits add_bits(const Bits& a, const Bits& b, uint8_t carry)
+{
+	Bits sum(std::max(a.size(), b.size()) + 1);
+
+	for (size_t i = 0; i + 1 < sum.size(); ++i) {
+		uint32_t total = carry + (i < a.size() ? a[i] : 0) + (i < b.size() ? b[i] : 0);
+
+		sum[i] = total & 1;
+		carry  = total >> 1;
+	}
+
+	sum.back() = carry;
+
+	return sum;
+}
+
+static void full_adder(CircuitGenerator& gen, const Signal& a, const Signal& b, const Signal& c, Signal& sum, Signal& carry)
+{
+	auto x = gen.xorGate(a, b);
+
+	sum   = gen.xorGate(x, c);
+	carry = gen.orGate(gen.andGate(a, b), gen.andGate(x, c));
+}
+
+static void half_adder(CircuitGenerator& gen, const Signal& a, const Signal& b, Signal& sum, Signal& carry)
+{
+	sum   = gen.xorGate(a, b);
+	carry = gen.andGate(a, b);
+}
+
+// ripple carry sum of two buses, one bit longer than the longer one
+static Signals add_buses(CircuitGenerator& gen, const Signals& a, const Signals& b)
+{
+	Signals sum;
+	Signal  carry;
+	bool    has_carry = false;
+
+	for (size_t i = 0; i < std::max(a.size(), b.size()); ++i) {
+		Signal bits[3];
+		uint32_t count = 0;
+
+		if (i < a.size()) bits[count++] = a[i];
+		if (i < b.size()) bits[count++] = b[i];
+		if (has_carry)    bits[count++] = carry;
+
+		auto& out = sum.emplace_back();
+
+		if (count == 3) {
+			full_adder(gen, bits[0], bits[1], bits[2], out, carry);
+		} else if (count == 2) {
+			half_adder(gen, bits[0], bits[1], out, carry);
+		} else {
+			out = bits[0];
+			has_carry = false;
+			continue;
+		}
+
+		has_carry = true;
+	}
+
+	if (has_carry)
+		sum.emplace_back(carry);
+
+	return sum;
+}
+
+// a + b + cin, the adders only differ in how the carries are made
+class AdderCircuit : public BenchCircuit {
+public:
+	AdderCircuit(uint32_t bits) :
+		bits(bits)
+	{}
+
+	void resolve(const CircuitGenerator& gen) override {
+		a_nets   = gen.getNets(a);
+		b_nets   = gen.getNets(b);
+		cin_net  = gen.getNet(cin);
+		sum_nets = gen.getNets(sum);
+	}
+
+	void stimulate(uint64_t cycle, std::mt19937& rng, std::vector<NetDrive>& drives) override {
+		a_bits = random_bits(rng, bits);
+		b_bits = random_bits(rng, bits);
+		carry  = rng() & 1;
+
+		drive(a_nets, a_bits, drives);
+		drive(b_nets, b_bits, drives);
+		drives.push_back({ cin_net, to_logic_value(carry) });
+	}
+
+	bool check(uint64_t cycle, const std::vector<uint8_t>& net_values) override {
+		Bits result;
+		return read(sum_nets, net_values, result) && result == add_bits(a_bits, b_bits, carry);
+	}
+
+protected:
+	uint32_t bits;
+	Signals  a;
+	Signals  b;
+	Signal   cin;
+	Signals  sum; // with the carry out as the last bit
+
+private:
+	std::vector<net_id_t> a_nets;
+	std::vector<net_id_t> b_nets;
+	net_id_t              cin_net;
+	std::vector<net_id_t> sum_nets;
+	Bits                  a_bits;
+	Bits                  b_bits;
+	uint8_t               carry;
+};
+
+class RippleAdder : public AdderCircuit {
+public:
+	using AdderCircuit::AdderCircuit;
+
+	std::string getName() const override {
+		return "ripple-adder-" + std::to_string(bits);
+	}
+
+	void generate(CircuitGenerator& gen) override {
+		a   = gen.input(bits);
+		b   = gen.input(bits);
+		cin = gen.input();
+
+		auto carry = cin;
+
+		for (uint32_t i = 0; i < bits; ++i) {
+			Signal out;
+			full_adder(gen, a[i], b[i], carry, out, carry);
+			sum.emplace_back(out);
+		}
+
+		sum.emplace_back(carry);
+	}
+
+	uint64_t getCycleTicks() const override {
+		return 2 * (uint64_t)bits + 8;
+	}
+};
+
+// kogge-stone prefix network, log2(bits) levels of group generate and propagate
+class LookaheadAdder : public AdderCircuit {
+public:
+	using AdderCircuit::AdderCircuit;
+
+	std::string getName() const override {
+		return "lookahead-adder-" + std::to_string(bits);
+	}
+
+	void generate(CircuitGenerator& gen) override {
+		a   = gen.input(bits);
+		b   = gen.input(bits);
+		cin = gen.input();
+
+		Signals p, g, group_p, group_g;
+
+		for (uint32_t i = 0; i < bits; ++i) {
+			p.emplace_back(gen.xorGate(a[i], b[i]));
+			g.emplace_back(gen.andGate(a[i], b[i]));
+		}
+
+		group_p = p;
+		group_g = g;
+
+		// the carry in is generated into bit 0
+		group_g[0] = gen.orGate(g[0], gen.andGate(p[0], cin));
+
+		for (uint32_t dist = 1; dist < bits; dist *= 2) {
+			auto prev_p = group_p;
+			auto prev_g = group_g;
+
+			for (uint32_t i = dist; i < bits; ++i) {
+				group_g[i] = gen.orGate(prev_g[i], gen.andGate(prev_p[i], prev_g[i - dist]));
+
+				if (i >= 2 * dist)
+					group_p[i] = gen.andGate(prev_p[i], prev_p[i - dist]);
+			}
+		}
+
+		sum.emplace_back(gen.xorGate(p[0], cin));
+
+		for (uint32_t i = 1; i < bits; ++i)
+			sum.emplace_back(gen.xorGate(p[i], group_g[i - 1]));
+
+		sum.emplace_back(group_g[bits - 1]);
+	}
+
+	uint64_t getCycleTicks() const override {
+		return 4 * (uint64_t)std::log2(bits) + 16;
+	}
+};
+
+// a row of and gates per bit of b, summed by ripple carry adders
+class ArrayMultiplier : public BenchCircuit {
+public:
+	ArrayMultiplier(uint32_t bits) :
+		bits(bits)
+	{}
+
+	std::string getName() const override {
+		return "array-multiplier-" + std::to_string(bits);
+	}
+
+	void generate(CircuitGenerator& gen) override {
+		a = gen.input(bits);
+		b = gen.input(bits);
+
+		Signals high;
+
+		for (uint32_t row = 0; row < bits; ++row) {
+			Signals partial;
+
+			for (uint32_t i = 0; i < bits; ++i)
+				partial.emplace_back(gen.andGate(a[i], b[row]));
+
+			auto sum = row ? add_buses(gen, high, partial) : partial;
+
+			product.emplace_back(sum[0]);
+			high.assign(sum.begin() + 1, sum.end());
+		}
+
+		product.insert(product.end(), high.begin(), high.end());
+	}
+
+	void resolve(const CircuitGenerator& gen) override {
+		a_nets       = gen.getNets(a);
+		b_nets       = gen.getNets(b);
+		product_nets = gen.getNets(product);
+	}
+
+	uint64_t getCycleTicks() const override {
+		return 8 * (uint64_t)bits + 16;
+	}
+
+	void stimulate(uint64_t cycle, std::mt19937& rng, std::vector<NetDrive>& drives) override {
+		a_bits = random_bits(rng, bits);
+		b_bits = random_bits(rng, bits);
+
+		drive(a_nets, a_bits, drives);
+		drive(b_nets, b_bits, drives);
+	}
+
+	bool check(uint64_t cycle, const std::vector<uint8_t>& net_values) override {
+		Bits result;
+
+		if (!read(product_nets, net_values, result)) return false;
+
+		Bits expected(2 * bits, 0);
+
+		for (uint32_t row = 0; row < bits; ++row) {
+			if (!b_bits[row]) continue;
+
+			uint8_t carry = 0;
+
+			for (uint32_t i = 0; i < bits; ++i) {
+				uint32_t total = expected[row + i] + a_bits[i] + carry;
+
+				expected[row + i] = total & 1;
+				carry             = total >> 1;
+			}
+
+			for (auto i = row + bits; carry && i < 2 * bits; ++i) {
+				carry       = expected[i];
+				expected[i] = !expected[i];
+			}
+		}
+
+		return result == expected;
+	}
+
+private:
+	uint32_t              bits;
+	Signals               a;
+	Signals               b;
+	Signals               product;
+	std::vector<net_id_t> a_nets;
+	std::vector<net_id_t> b_nets;
+	std::vector<net_id_t> product_nets;
+	Bits                  a_bits;
+	Bits                  b_bits;
+};
+
+// nand d latch, transparent while enable is 1
+static Signal d_latch(CircuitGenerator& gen, const Signal& d, const Signal& enable)
+{
+	auto q_inv = gen.forward();
+
+	auto set   = gen.nandGate(d, enable);
+	auto reset = gen.nandGate(set, enable);
+	auto q     = gen.nandGate(set, q_inv);
+
+	gen.connect(q_inv, gen.nandGate(reset, q));
+
+	return q;
+}
+
+// master slave flip flop taking d on the rising edge of clock
+static Signal d_flip_flop(CircuitGenerator& gen, const Signal& d, const Signal& clock, const Signal& clock_inv)
+{
+	return d_latch(gen, d_latch(gen, d, clock_inv), clock);
+}
+
+// xnor lfsrs with the feedback of each one also taking the last bit of the one before.
+// a cycle is half a clock period, the registers are cleared while reset_inv is 0
+class LfsrChain : public BenchCircuit {
+public:
+	LfsrChain(uint32_t count) :
+		count(count)
+	{}
+
+	std::string getName() const override {
+		return "lfsr-chain-" + std::to_string(count) + "x" + std::to_string(LFSR_WIDTH);
+	}
+
+	void generate(CircuitGenerator& gen) override {
+		clock     = gen.input();
+		clock_inv = gen.input();
+		reset_inv = gen.input();
+
+		for (uint32_t lfsr = 0; lfsr < count; ++lfsr) {
+			Signals d;
+
+			for (uint32_t i = 0; i < LFSR_WIDTH; ++i)
+				d.emplace_back(gen.forward());
+
+			for (uint32_t i = 0; i < LFSR_WIDTH; ++i)
+				q.emplace_back(d_flip_flop(gen, d[i], clock, clock_inv));
+
+			auto* reg = &q[(size_t)lfsr * LFSR_WIDTH];
+
+			// x^16 + x^14 + x^13 + x^11 + 1
+			auto feedback = gen.xorGate(gen.xorGate(reg[15], reg[13]), gen.xorGate(reg[12], reg[10]));
+
+			if (lfsr > 0)
+				feedback = gen.xorGate(feedback, q[(size_t)lfsr * LFSR_WIDTH - 1]);
+
+			gen.connect(d[0], gen.andGate(reset_inv, gen.notGate(feedback)));
+
+			for (uint32_t i = 1; i < LFSR_WIDTH; ++i)
+				gen.connect(d[i], gen.andGate(reset_inv, reg[i - 1]));
+		}
+	}
+
+	void resolve(const CircuitGenerator& gen) override {
+		clock_net     = gen.getNet(clock);
+		clock_inv_net = gen.getNet(clock_inv);
+		reset_inv_net = gen.getNet(reset_inv);
+		q_nets        = gen.getNets(q);
+
+		state.assign(q.size(), 0);
+	}
+
+	uint64_t getCycleTicks() const override {
+		return 16;
+	}
+
+	void stimulate(uint64_t cycle, std::mt19937& rng, std::vector<NetDrive>& drives) override {
+		bool rising = cycle & 1;
+
+		drives.push_back({ clock_net, to_logic_value(rising) });
+		drives.push_back({ clock_inv_net, to_logic_value(!rising) });
+		drives.push_back({ reset_inv_net, to_logic_value(cycle >= LFSR_RESET_CYCLES) });
+
+		if (!rising) return;
+
+		auto prev  = state;
+		bool reset = cycle < LFSR_RESET_CYCLES;
+
+		for (uint32_t lfsr = 0; lfsr < count; ++lfsr) {
+			auto* reg  = &prev[(size_t)lfsr * LFSR_WIDTH];
+			auto* next = &state[(size_t)lfsr * LFSR_WIDTH];
+
+			uint8_t feedback = reg[15] ^ reg[13] ^ reg[12] ^ reg[10];
+
+			if (lfsr > 0)
+				feedback ^= prev[(size_t)lfsr * LFSR_WIDTH - 1];
+
+			next[0] = !reset && !feedback;
+
+			for (uint32_t i = 1; i < LFSR_WIDTH; ++i)
+				next[i] = !reset && reg[i - 1];
+		}
+	}
+
+	bool check(uint64_t cycle, const std::vector<uint8_t>& net_values) override {
+		Bits result;
+		return !(cycle & 1) || (read(q_nets, net_values, result) && result == state);
+	}
+
+private:
+	uint32_t              count;
+	Signal                clock;
+	Signal                clock_inv;
+	Signal                reset_inv;
+	Signals               q;
+	net_id_t              clock_net;
+	net_id_t              clock_inv_net;
+	net_id_t              reset_inv_net;
+	std::vector<net_id_t> q_nets;
+	Bits                  state;
+};
+
+// words of d latches behind an address decoder, read through an and-or tree. a write sets
+// the address and data, pulses write enable and then reads a random word back
+class LatchArray : public BenchCircuit {
+public:
+	LatchArray(uint32_t words) :
+		words(std::max(words, 2u)),
+		address_bits(0)
+	{
+		while ((1u << address_bits) < this->words)
+			++address_bits;
+	}
+
+	std::string getName() const override {
+		return "latch-array-" + std::to_string(words) + "x" + std::to_string(LATCH_WIDTH);
+	}
+
+	void generate(CircuitGenerator& gen) override {
+		address      = gen.input(address_bits);
+		data         = gen.input(LATCH_WIDTH);
+		write_enable = gen.input();
+
+		Signals address_inv;
+
+		for (const auto& bit : address)
+			address_inv.emplace_back(gen.notGate(bit));
+
+		std::vector<Signals> columns(LATCH_WIDTH);
+
+		for (uint32_t word = 0; word < words; ++word) {
+			auto select = word & 1 ? address[0] : address_inv[0];
+
+			for (uint32_t bit = 1; bit < address_bits; ++bit)
+				select = gen.andGate(select, (word >> bit) & 1 ? address[bit] : address_inv[bit]);
+
+			auto enable = gen.andGate(select, write_enable);
+
+			for (uint32_t bit = 0; bit < LATCH_WIDTH; ++bit)
+				columns[bit].emplace_back(gen.andGate(d_latch(gen, data[bit], enable), select));
+		}
+
+		for (auto& column : columns) {
+			while (column.size() > 1) {
+				Signals reduced;
+
+				for (size_t i = 0; i + 1 < column.size(); i += 2)
+					reduced.emplace_back(gen.orGate(column[i], column[i + 1]));
+
+				if (column.size() & 1)
+					reduced.emplace_back(column.back());
+
+				column = std::move(reduced);
+			}
+
+			output.emplace_back(column[0]);
+		}
+	}
+
+	void resolve(const CircuitGenerator& gen) override {
+		address_nets     = gen.getNets(address);
+		data_nets        = gen.getNets(data);
+		write_enable_net = gen.getNet(write_enable);
+		output_nets      = gen.getNets(output);
+
+		memory.assign(words, {});
+	}
+
+	uint64_t getCycleTicks() const override {
+		return 4 * (uint64_t)address_bits + 16;
+	}
+
+	void stimulate(uint64_t cycle, std::mt19937& rng, std::vector<NetDrive>& drives) override {
+		switch (cycle % 4) {
+		case 0:
+			word      = rng() % words;
+			word_bits = random_bits(rng, LATCH_WIDTH);
+
+			driveAddress(drives);
+			drive(data_nets, word_bits, drives);
+			drives.push_back({ write_enable_net, Logic_0 });
+			break;
+		case 1:
+			drives.push_back({ write_enable_net, Logic_1 });
+			memory[word] = word_bits;
+			break;
+		case 2:
+			drives.push_back({ write_enable_net, Logic_0 });
+			break;
+		case 3:
+			word = rng() % words;
+			driveAddress(drives);
+			break;
+		}
+	}
+
+	bool check(uint64_t cycle, const std::vector<uint8_t>& net_values) override {
+		Bits result;
+
+		// words never written are unknown
+		if (cycle % 4 != 3 || memory[word].empty()) return true;
+
+		return read(output_nets, net_values, result) && result == memory[word];
+	}
+
+private:
+	void driveAddress(std::vector<NetDrive>& drives) {
+		for (uint32_t bit = 0; bit < address_bits; ++bit)
+			drives.push_back({ address_nets[bit], to_logic_value((word >> bit) & 1) });
+	}
+
+	uint32_t              words;
+	uint32_t              address_bits;
+	Signals               address;
+	Signals               data;
+	Signal                write_enable;
+	Signals               output;
+	std::vector<net_id_t> address_nets;
+	std::vector<net_id_t> data_nets;
+	net_id_t              write_enable_net;
+	std::vector<net_id_t> output_nets;
+	std::vector<Bits>     memory;
+	uint32_t              word;
+	Bits                  word_bits;
+};
+
+std::vector<std::unique_ptr<BenchCircuit>> create_bench_circuits(uint32_t scale)
+{
+	scale = std::max(scale, 1u);
+
+	auto multiplier_bits = (uint32_t)std::lround(MULTIPLIER_BITS * std::sqrt((double)scale));
+
+	std::vector<std::unique_ptr<BenchCircuit>> circuits;
+
+	circuits.emplace_back(std::make_unique<RippleAdder>(ADDER_BITS * scale));
+	circuits.emplace_back(std::make_unique<LookaheadAdder>(ADDER_BITS * scale));
+	circuits.emplace_back(std::make_unique<ArrayMultiplier>(multiplier_bits));
+	circuits.emplace_back(std::make_unique<LfsrChain>(LFSR_COUNT * scale));
+	circuits.emplace_back(std::make_unique<LatchArray>(LATCH_WORDS * scale));
+
+	return circuits;
+}
\ No newline at end of file
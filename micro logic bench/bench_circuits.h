@@ -0,0 +1,30 @@
+#pragma once
+
+#include "circuit_generator.h"
+#include "simulation/logic_value.h"
+#include <memory>
+#include <random>
+#include <string>
+
+struct NetDrive {
+	net_id_t   net;
+	LogicValue value;
+};
+
+// a generated circuit and the stimulus it is benchmarked with. every cycle stimulate drives
+// the inputs, the simulation runs getCycleTicks() ticks and check compares the outputs to a
+// model of the circuit
+class BenchCircuit {
+public:
+	virtual ~BenchCircuit() = default;
+
+	virtual std::string getName() const = 0;
+	virtual void generate(CircuitGenerator& gen) = 0;
+	virtual void resolve(const CircuitGenerator& gen) = 0; // the netlist of the sheet is built
+	virtual uint64_t getCycleTicks() const = 0;
+	virtual void stimulate(uint64_t cycle, std::mt19937& rng, std::vector<NetDrive>& drives) = 0;
+	virtual bool check(uint64_t cycle, const std::vector<uint8_t>& net_values) = 0;
+};
+
+// the circuits at about 5000 to 50000 gates times scale, the same scale builds the same sheets
+std::vector<std::unique_ptr<BenchCircuit>> create_bench_circuits(uint32_t scale);
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "circuit_generator.h"
+
+#include <cassert>
+
+CircuitGenerator::CircuitGenerator(SchematicSheet& sheet, const std::vector<LogicGate>& logic_gates) :
+	sheet(sheet),
+	and_gate(find(logic_gates, "2-input AND")),
+	or_gate(find(logic_gates, "2-input OR")),
+	xor_gate(find(logic_gates, "2-input XOR")),
+	nand_gate(find(logic_gates, "2-input NAND")),
+	nor_gate(find(logic_gates, "2-input NOR")),
+	slot(0),
+	gate_count(0),
+	wire_count(0)
+{}
+
+bool CircuitGenerator::isValid() const
+{
+	return and_gate && or_gate && xor_gate && nand_gate && nor_gate;
+}
+
+CircuitGenerator::Signal CircuitGenerator::input()
+{
+	auto pos   = nextSlot();
+	auto& wire = addWire(pos, pos + vec2(0.f, 1.f));
+
+	return { pos, &wire, UINT32_MAX };
+}
+
+CircuitGenerator::Signals CircuitGenerator::input(uint32_t width)
+{
+	Signals bus;
+
+	for (uint32_t bit = 0; bit < width; ++bit)
+		bus.emplace_back(input());
+
+	return bus;
+}
+
+CircuitGenerator::Signal CircuitGenerator::forward()
+{
+	return { nextSlot(), nullptr, UINT32_MAX };
+}
+
+void CircuitGenerator::connect(const Signal& forward, const Signal& source)
+{
+	assert(!forward.elem);
+
+	addWire(source.pos, forward.pos);
+}
+
+CircuitGenerator::Signal CircuitGenerator::andGate(const Signal& a, const Signal& b)
+{
+	return place(and_gate, a, b);
+}
+
+CircuitGenerator::Signal CircuitGenerator::orGate(const Signal& a, const Signal& b)
+{
+	return place(or_gate, a, b);
+}
+
+CircuitGenerator::Signal CircuitGenerator::xorGate(const Signal& a, const Signal& b)
+{
+	return place(xor_gate, a, b);
+}
+
+CircuitGenerator::Signal CircuitGenerator::nandGate(const Signal& a, const Signal& b)
+{
+	return place(nand_gate, a, b);
+}
+
+CircuitGenerator::Signal CircuitGenerator::norGate(const Signal& a, const Signal& b)
+{
+	return place(nor_gate, a, b);
+}
+
+CircuitGenerator::Signal CircuitGenerator::notGate(const Signal& a)
+{
+	return place(nand_gate, a, a);
+}
+
+net_id_t CircuitGenerator::getNet(const Signal& signal) const
+{
+	::Net* net;
+
+	if (!signal.elem)
+		return INVALID_NET_ID;
+	else if (signal.pin == UINT32_MAX)
+		net = static_cast<WireElement*>(signal.elem)->net;
+	else
+		net = static_cast<LogicElement*>(signal.elem)->pins[signal.pin].net;
+
+	return net ? net->id : INVALID_NET_ID;
+}
+
+std::vector<net_id_t> CircuitGenerator::getNets(const Signals& bus) const
+{
+	std::vector<net_id_t> nets;
+
+	for (const auto& signal : bus)
+		nets.emplace_back(getNet(signal));
+
+	return nets;
+}
+
+size_t CircuitGenerator::getGateCount() const
+{
+	return gate_count;
+}
+
+size_t CircuitGenerator::getWireCount() const
+{
+	return wire_count;
+}
+
+const LogicGate* CircuitGenerator::find(const std::vector<LogicGate>& logic_gates, const char* name) const
+{
+	for (const auto& gate : logic_gates)
+		if (gate.shared->name == name)
+			return &gate;
+
+	return nullptr;
+}
+
+// the gates are 2 input gates with the output as first pin
+CircuitGenerator::Signal CircuitGenerator::place(const LogicGate* gate, const Signal& a, const Signal& b)
+{
+	auto new_elem = gate->clone();
+	auto& elem    = static_cast<LogicGate&>(*new_elem);
+
+	elem.pos = nextSlot();
+	elem.dir = Direction::Up;
+
+	Signal output = { elem.pos, &elem, 0 };
+	uint32_t input_idx = 0;
+
+	for (const auto& layout : elem.shared->pin_layouts) {
+		auto pos = rotate_vector(layout.pos, elem.dir) + elem.pos;
+
+		if (layout.io == PinLayout::Output) {
+			output.pos = pos;
+			output.pin = layout.pinout - 1;
+		} else if (layout.io == PinLayout::Input) {
+			addWire((input_idx++ == 0 ? a : b).pos, pos);
+		}
+	}
+
+	elem.id   = sheet.id_counter++;
+	elem.iter = sheet.bvh.insert(elem.getAABB(), std::move(new_elem));
+
+	++gate_count;
+
+	return output;
+}
+
+vec2 CircuitGenerator::nextSlot()
+{
+	auto x = (float)(slot % GENERATOR_ROW_SLOTS);
+	auto y = (float)(slot / GENERATOR_ROW_SLOTS);
+
+	++slot;
+
+	return vec2(x, y) * GENERATOR_SLOT_SIZE;
+}
+
+Wire& CircuitGenerator::addWire(const vec2& p0, const vec2& p1)
+{
+	auto new_elem = std::make_unique<Wire>(p0, p1);
+	auto& wire    = *new_elem;
+
+	wire.id   = sheet.id_counter++;
+	wire.iter = sheet.bvh.insert(wire.getAABB(), std::move(new_elem));
+
+	++wire_count;
+
+	return wire;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "schematic_sheet.h"
+
+#define GENERATOR_ROW_SLOTS 128
+#define GENERATOR_SLOT_SIZE 4.f
+
+// builds circuits out of library gates and wires as if they were drawn, so the sheet goes
+// through the same netlist build as a loaded one. gates are placed on a grid in creation
+// order and every connection is a wire from the driving point to the input pin
+class CircuitGenerator {
+public:
+	// a point wires start from, the output pin of a gate or the stub of an input
+	struct Signal {
+		vec2            pos;
+		CircuitElement* elem;
+		uint32_t        pin; // index of LogicElement::pins, UINT32_MAX for an input stub
+	};
+
+	using Signals = std::vector<Signal>;
+
+	CircuitGenerator(SchematicSheet& sheet, const std::vector<LogicGate>& logic_gates);
+
+	// false if a gate the generator uses is missing from the library
+	bool isValid() const;
+
+	Signal input();
+	Signals input(uint32_t width);
+
+	// a point gate inputs can be wired to before their source exists, for feedback loops
+	Signal forward();
+	void connect(const Signal& forward, const Signal& source);
+
+	Signal andGate(const Signal& a, const Signal& b);
+	Signal orGate(const Signal& a, const Signal& b);
+	Signal xorGate(const Signal& a, const Signal& b);
+	Signal nandGate(const Signal& a, const Signal& b);
+	Signal norGate(const Signal& a, const Signal& b);
+	Signal notGate(const Signal& a);
+
+	// nets of the signals, valid once the netlist of the sheet is built
+	net_id_t getNet(const Signal& signal) const;
+	std::vector<net_id_t> getNets(const Signals& bus) const;
+
+	size_t getGateCount() const;
+	size_t getWireCount() const;
+
+private:
+	const LogicGate* find(const std::vector<LogicGate>& logic_gates, const char* name) const;
+	Signal place(const LogicGate* gate, const Signal& a, const Signal& b);
+	vec2 nextSlot();
+	Wire& addWire(const vec2& p0, const vec2& p1);
+
+	SchematicSheet& sheet;
+
+	const LogicGate* and_gate;
+	const LogicGate* or_gate;
+	const LogicGate* xor_gate;
+	const LogicGate* nand_gate;
+	const LogicGate* nor_gate;
+
+	size_t slot;
+	size_t gate_count;
+	size_t wire_count;
+};
\ No newline at end of file
@@ -0,0 +1,285 @@
+#include "bench_circuits.h"
+#include "circuit_element_loader.h"
+#include "simulation/parallel_simulator.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#define DEFAULT_ELEMENTS_PATH "resources/elements.xml"
+#define DEFAULT_CYCLES 200
+#define BENCH_SEED     1
+
+struct Options {
+	std::string elements_path = DEFAULT_ELEMENTS_PATH;
+	std::string filter;
+	uint64_t    cycles        = DEFAULT_CYCLES;
+	uint32_t    scale         = 1;
+	uint32_t    thread_count  = 1;
+	bool        csv           = false;
+};
+
+struct BenchResult {
+	std::string name;
+	size_t      gates;
+	size_t      nets;
+	double      place_ms;   // creating the elements of the sheet
+	double      netlist_ms;
+	double      build_ms;   // building the simulator from the netlist
+	double      sheet_bytes_per_gate;
+	double      sim_bytes_per_gate;
+	uint64_t    ticks;
+	uint64_t    evaluations;
+	uint64_t    net_changes;
+	double      seconds;
+	uint64_t    errors;     // cycles the outputs did not match the model
+};
+
+// live bytes of the global allocator, the memory numbers do not depend on the platform's
+// allocator or page sizes so they stay comparable between runs
+static std::atomic<int64_t> allocated_bytes(0);
+
+void* operator new(std::size_t size)
+{
+	auto* block = static_cast<std::max_align_t*>(std::malloc(size + sizeof(std::max_align_t)));
+
+	if (!block) throw std::bad_alloc();
+
+	*reinterpret_cast<std::size_t*>(block) = size;
+	allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	return block + 1;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	if (!ptr) return;
+
+	auto* block = static_cast<std::max_align_t*>(ptr) - 1;
+
+	allocated_bytes.fetch_sub(*reinterpret_cast<std::size_t*>(block), std::memory_order_relaxed);
+	std::free(block);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	operator delete(ptr);
+}
+
+static void print_usage()
+{
+	std::printf(
+		"usage: micro_logic_bench [options]\n"
+		"  -e, --elements <path>  element library (default " DEFAULT_ELEMENTS_PATH ")\n"
+		"  -s, --scale <n>        multiplies the circuit sizes (default 1)\n"
+		"  -n, --cycles <n>       stimulus cycles per circuit (default %d)\n"
+		"  -j, --threads <n>      simulation threads\n"
+		"  -c, --circuit <name>   only the circuits whose name contains name\n"
+		"      --csv              comma separated output\n",
+		DEFAULT_CYCLES);
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		auto value = [&](std::string& out) {
+			if (i + 1 >= argc) return false;
+			out = argv[++i];
+			return true;
+		};
+
+		auto number = [&](std::string& out) {
+			return value(out) && !out.empty() && out.find_first_not_of("0123456789") == std::string::npos;
+		};
+
+		std::string str;
+
+		if (arg == "-e" || arg == "--elements") {
+			if (!value(options.elements_path)) return false;
+		} else if (arg == "-s" || arg == "--scale") {
+			if (!number(str)) return false;
+			options.scale = std::max((uint32_t)std::stoul(str), 1u);
+		} else if (arg == "-n" || arg == "--cycles") {
+			if (!number(str)) return false;
+			options.cycles = std::stoull(str);
+		} else if (arg == "-j" || arg == "--threads") {
+			if (!number(str)) return false;
+			options.thread_count = std::max((uint32_t)std::stoul(str), 1u);
+		} else if (arg == "-c" || arg == "--circuit") {
+			if (!value(options.filter)) return false;
+		} else if (arg == "--csv") {
+			options.csv = true;
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+template <class Sim>
+static void run(Sim& sim, BenchCircuit& circuit, const Options& options, BenchResult& result)
+{
+	using clock_t = std::chrono::steady_clock;
+
+	std::mt19937 rng(BENCH_SEED);
+	std::vector<NetDrive> drives;
+
+	result.seconds = 0.0;
+	result.errors  = 0;
+
+	for (uint64_t cycle = 0; cycle < options.cycles; ++cycle) {
+		drives.clear();
+		circuit.stimulate(cycle, rng, drives);
+
+		auto begin = clock_t::now();
+
+		for (const auto& drive : drives)
+			sim.setNet(drive.net, drive.value);
+
+		sim.advance(circuit.getCycleTicks());
+
+		result.seconds += std::chrono::duration<double>(clock_t::now() - begin).count();
+
+		if (!circuit.check(cycle, sim.getNetValues()))
+			++result.errors;
+	}
+
+	result.ticks       = sim.getTick();
+	result.evaluations = sim.getEventCount();
+	result.net_changes = sim.getNetChangeCount();
+}
+
+static bool bench(BenchCircuit& circuit, const std::vector<LogicGate>& logic_gates, const Options& options, BenchResult& result)
+{
+	using clock_t = std::chrono::steady_clock;
+
+	auto ms_since = [](clock_t::time_point begin) {
+		return std::chrono::duration<double, std::milli>(clock_t::now() - begin).count();
+	};
+
+	auto base_bytes = allocated_bytes.load();
+
+	SchematicSheet sheet;
+	CircuitGenerator gen(sheet, logic_gates);
+
+	if (!gen.isValid()) return false;
+
+	auto begin = clock_t::now();
+	circuit.generate(gen);
+	result.place_ms = ms_since(begin);
+
+	begin = clock_t::now();
+	sheet.updateNetlist();
+	result.netlist_ms = ms_since(begin);
+
+	circuit.resolve(gen);
+
+	auto sheet_bytes = allocated_bytes.load() - base_bytes;
+
+	Simulator         simulator;
+	ParallelSimulator parallel_simulator;
+
+	begin = clock_t::now();
+	simulator.build(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount());
+
+	bool parallel = options.thread_count > 1 && !simulator.hasDelays();
+
+	if (parallel) {
+		parallel_simulator.build(simulator, options.thread_count);
+		simulator.clear();
+	}
+
+	result.build_ms = ms_since(begin);
+
+	auto sim_bytes = allocated_bytes.load() - base_bytes - sheet_bytes;
+	auto gates     = std::max<size_t>(gen.getGateCount(), 1);
+
+	result.name                 = circuit.getName();
+	result.gates                = gen.getGateCount();
+	result.nets                 = sheet.netlist.getNetCount();
+	result.sheet_bytes_per_gate = (double)sheet_bytes / gates;
+	result.sim_bytes_per_gate   = (double)sim_bytes / gates;
+
+	if (parallel)
+		run(parallel_simulator, circuit, options, result);
+	else
+		run(simulator, circuit, options, result);
+
+	return true;
+}
+
+static void print_result(const BenchResult& result, bool csv)
+{
+	auto per_second = [&](uint64_t count) {
+		return result.seconds > 0.0 ? count / result.seconds : 0.0;
+	};
+
+	const char* format = csv ?
+		"%s,%zu,%zu,%.2f,%.2f,%.2f,%.1f,%.1f,%llu,%.0f,%.0f,%llu\n" :
+		"%-24s %8zu %8zu %9.2f %10.2f %9.2f %8.1f %8.1f %9llu %12.0f %12.0f %6llu\n";
+
+	std::printf(format,
+		result.name.c_str(),
+		result.gates,
+		result.nets,
+		result.place_ms,
+		result.netlist_ms,
+		result.build_ms,
+		result.sheet_bytes_per_gate,
+		result.sim_bytes_per_gate,
+		(unsigned long long)result.ticks,
+		per_second(result.evaluations),
+		per_second(result.net_changes),
+		(unsigned long long)result.errors);
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	if (!parse_options(argc, argv, options)) {
+		print_usage();
+		return 1;
+	}
+
+	CircuitElementLoader loader;
+	loader.load(options.elements_path.c_str());
+
+	for (const auto& error : loader.errors)
+		std::fprintf(stderr, "%s\n", error.c_str());
+
+	if (loader.logic_gates.empty()) return 1;
+
+	std::vector<LogicUnit> logic_units;
+	CircuitElement::setLibrary(&loader.logic_gates, &logic_units);
+
+	if (options.csv)
+		std::printf("circuit,gates,nets,place_ms,netlist_ms,build_ms,sheet_bytes_per_gate,sim_bytes_per_gate,ticks,evals_per_s,events_per_s,errors\n");
+	else
+		std::printf("%-24s %8s %8s %9s %10s %9s %8s %8s %9s %12s %12s %6s\n",
+			"circuit", "gates", "nets", "place ms", "netlist ms", "build ms", "sheet B", "sim B", "ticks", "evals/s", "events/s", "errors");
+
+	bool failed = false;
+
+	for (auto& circuit : create_bench_circuits(options.scale)) {
+		if (circuit->getName().find(options.filter) == std::string::npos) continue;
+
+		BenchResult result;
+
+		if (!bench(*circuit, loader.logic_gates, options, result)) {
+			std::fprintf(stderr, "the element library is missing the 2-input gates\n");
+			return 1;
+		}
+
+		print_result(result, options.csv);
+		std::fflush(stdout);
+
+		failed |= result.errors > 0;
+	}
+
+	return failed ? 2 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,433 @@
+#include "stimulus.h"
+#include "circuit_element_loader.h"
+#include "schematic_sheet.h"
+#include "simulation/parallel_simulator.h"
+#include "simulation/pattern_simulator.h"
+#include "simulation/unit_module.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <memory>
+
+#define DEFAULT_ELEMENTS_PATH "resources/elements.xml"
+#define DEFAULT_CYCLES 1000
+#define MAX_SWEEP_INPUTS 24
+
+struct Options {
+	std::string              sheet_path;
+	std::string              elements_path = DEFAULT_ELEMENTS_PATH;
+	std::string              stimulus_path;
+	std::string              vcd_path;
+	std::vector<std::string> unit_paths;
+	std::vector<std::string> breakpoints;
+	uint64_t                 cycles        = DEFAULT_CYCLES;
+	uint32_t                 thread_count  = 1;
+	bool                     all_nets      = false;
+	bool                     truth_table   = false;
+};
+
+// a probed net and the name it is dumped, recorded and stimulated by
+struct Probe {
+	std::string name;
+	net_id_t    net;
+};
+
+static void print_usage()
+{
+	std::printf(
+		"usage: micro_logic_cli [options] <sheet.mls>\n"
+		"  -e, --elements <path>  element library (default " DEFAULT_ELEMENTS_PATH ")\n"
+		"  -u, --unit <path>      unit sheet, repeat in the order of the project's units\n"
+		"  -s, --stimulus <path>  '<tick> <name> <value>' lines, names are in<n>, out<n> or net<n>\n"
+		"  -n, --cycles <n>       ticks to run (default %d)\n"
+		"  -j, --threads <n>      simulation threads, circuits with delays run on one\n"
+		"  -o, --vcd <path>       record the dumped nets to a VCD file\n"
+		"  -a, --all-nets         dump every net instead of the unit ports\n"
+		"  -t, --truth-table      print the unit outputs for every input combination\n"
+		"  -b, --break <cond>     stop at '<name>[,<name>...] <op> [value]', op is rise, fall,\n"
+		"                         unknown, == or !=, the first name is bit 0 of the value\n",
+		DEFAULT_CYCLES);
+}
+
+// a decimal count no larger than max
+static bool parse_count(const std::string& str, uint64_t max, uint64_t& count)
+{
+	if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos) return false;
+
+	char* end;
+	errno = 0;
+	count = std::strtoull(str.c_str(), &end, 10);
+
+	return !*end && errno != ERANGE && count <= max;
+}
+
+static bool parse_options(int argc, char** argv, Options& options)
+{
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+
+		auto value = [&](std::string& out) {
+			if (i + 1 >= argc) return false;
+			out = argv[++i];
+			return true;
+		};
+
+		std::string str;
+
+		if (arg == "-e" || arg == "--elements") {
+			if (!value(options.elements_path)) return false;
+		} else if (arg == "-u" || arg == "--unit") {
+			if (!value(str)) return false;
+			options.unit_paths.emplace_back(str);
+		} else if (arg == "-s" || arg == "--stimulus") {
+			if (!value(options.stimulus_path)) return false;
+		} else if (arg == "-n" || arg == "--cycles") {
+			if (!value(str) || !parse_count(str, UINT64_MAX, options.cycles)) return false;
+		} else if (arg == "-j" || arg == "--threads") {
+			uint64_t count;
+			if (!value(str) || !parse_count(str, UINT32_MAX, count)) return false;
+			options.thread_count = std::max((uint32_t)count, 1u);
+		} else if (arg == "-o" || arg == "--vcd") {
+			if (!value(options.vcd_path)) return false;
+		} else if (arg == "-b" || arg == "--break") {
+			if (!value(str)) return false;
+			options.breakpoints.emplace_back(str);
+		} else if (arg == "-a" || arg == "--all-nets") {
+			options.all_nets = true;
+		} else if (arg == "-t" || arg == "--truth-table") {
+			options.truth_table = true;
+		} else if (arg[0] == '-' || !options.sheet_path.empty()) {
+			return false;
+		} else {
+			options.sheet_path = arg;
+		}
+	}
+
+	return !options.sheet_path.empty();
+}
+
+static bool load_sheet(const std::string& path, SchematicSheet& sheet)
+{
+	std::ifstream file(path, std::ios::binary);
+
+	if (!file.is_open()) {
+		std::fprintf(stderr, "cannot open '%s'\n", path.c_str());
+		return false;
+	}
+
+	sheet.unserialize(file);
+	sheet.updateNetlist();
+
+	return true;
+}
+
+static bool load_unit(const std::string& path, std::vector<LogicUnit>& logic_units)
+{
+	SchematicSheet sheet;
+
+	if (!load_sheet(path, sheet)) return false;
+
+	auto module = std::make_shared<UnitModule>();
+
+	std::string error;
+	if (!module->build(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount(), true, error)) {
+		std::fprintf(stderr, "cannot create a unit from '%s': %s\n", path.c_str(), error.c_str());
+		return false;
+	}
+
+	auto shared = create_unit_shared(std::move(module), sheet.name, logic_units.size());
+
+	auto& unit = logic_units.emplace_back();
+	unit.shared = std::move(shared);
+	unit.pos    = {};
+	unit.dir    = Direction::Up;
+	unit.pins.resize(unit.shared->pin_layouts.size(), {});
+
+	return true;
+}
+
+// in<n> and out<n> in port order, empty if the sheet is not a unit
+static std::vector<Probe> get_ports(SchematicSheet& sheet)
+{
+	std::vector<Probe> probes;
+
+	UnitModule module;
+	std::string error;
+
+	if (!module.build(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount(), true, error)) return probes;
+
+	uint32_t input = 0, output = 0;
+
+	for (const auto& port : module.ports) {
+		if (port.kind == LogicElement::Shared::Port::Input)
+			probes.push_back({ "in" + std::to_string(input++), port.net });
+		else
+			probes.push_back({ "out" + std::to_string(output++), port.net });
+	}
+
+	return probes;
+}
+
+static std::vector<Probe> get_nets(SchematicSheet& sheet)
+{
+	std::vector<Probe> probes;
+
+	const auto& netlist = sheet.netlist;
+
+	for (net_id_t net = 0; net < netlist.getNetCount(); ++net)
+		if (netlist.net_sizes[net])
+			probes.push_back({ "net" + std::to_string(net), net });
+
+	return probes;
+}
+
+static bool parse_breakpoint(
+	const std::string& str,
+	const std::unordered_map<std::string, net_id_t>& names,
+	Breakpoints::Breakpoint& breakpoint,
+	std::string& error)
+{
+	std::istringstream ss(str);
+	std::string name_list, op, value, rest;
+
+	if (!(ss >> name_list >> op) || (ss >> value && ss >> rest)) {
+		error = "'" + str + "': expected '<name>[,<name>...] <op> [value]'";
+		return false;
+	}
+
+	breakpoint = { Breakpoints::Equals, {}, 0, 0 };
+
+	std::istringstream names_ss(name_list);
+	std::string name;
+
+	while (std::getline(names_ss, name, ',')) {
+		auto iter = names.find(name);
+
+		if (iter == names.end()) {
+			error = "'" + str + "': unknown name '" + name + "'";
+			return false;
+		}
+
+		breakpoint.nets.emplace_back(iter->second);
+	}
+
+	if (op == "rise" || op == "fall" || op == "unknown") {
+		breakpoint.condition = op == "rise" ? Breakpoints::Rising : op == "fall" ? Breakpoints::Falling : Breakpoints::Unknown;
+
+		if (value.empty()) return true;
+	} else if (op == "==" || op == "!=") {
+		breakpoint.condition = op == "==" ? Breakpoints::Equals : Breakpoints::NotEquals;
+
+		if (parse_bus_value(value, (uint32_t)breakpoint.nets.size(), breakpoint.value, breakpoint.known)) return true;
+	}
+
+	error = "'" + str + "': bad condition";
+	return false;
+}
+
+template <class Sim>
+static void run(Sim& sim, const Options& options, const Stimulus& stimulus, const Breakpoints& breakpoints)
+{
+	auto event = stimulus.events.begin();
+
+	for (uint64_t tick = 0; tick < options.cycles; ++tick) {
+		for (; event != stimulus.events.end() && event->tick == tick; ++event)
+			sim.setNet(event->net, event->value);
+
+		if (breakpoints.isHit()) break;
+
+		sim.step();
+
+		if (breakpoints.isHit()) break;
+	}
+}
+
+// sweeps the input ports PATTERN_WORD_BITS combinations at a time, one line per combination
+// with the input bits then the output bits, both in port order
+static bool print_truth_table(const Simulator& simulator, const std::vector<Probe>& ports)
+{
+	std::vector<net_id_t> inputs, outputs;
+
+	for (const auto& probe : ports)
+		(probe.name.compare(0, 2, "in") == 0 ? inputs : outputs).emplace_back(probe.net);
+
+	if (ports.empty() || inputs.size() > MAX_SWEEP_INPUTS) {
+		std::fprintf(stderr, "a truth table needs a unit sheet with at most %d inputs\n", MAX_SWEEP_INPUTS);
+		return false;
+	}
+
+	PatternSimulator pattern_simulator;
+	std::string error;
+
+	if (!pattern_simulator.build(simulator, error)) {
+		std::fprintf(stderr, "cannot sweep the sheet: %s\n", error.c_str());
+		return false;
+	}
+
+	uint64_t combinations = 1ull << inputs.size();
+	std::string line;
+
+	for (uint64_t base = 0; base < combinations; base += PATTERN_WORD_BITS) {
+		pattern_simulator.reset();
+
+		for (uint32_t i = 0; i < inputs.size(); ++i)
+			pattern_simulator.setNet(inputs[i], PatternWord::counter(i, base));
+
+		bool stable = pattern_simulator.settle();
+		auto count  = (uint32_t)std::min<uint64_t>(PATTERN_WORD_BITS, combinations - base);
+
+		for (uint32_t pattern = 0; pattern < count; ++pattern) {
+			line.clear();
+
+			for (auto net : inputs)
+				line += pattern_simulator.getNet(net).get(pattern) ? '1' : '0';
+
+			line += ' ';
+
+			for (auto net : outputs)
+				line += pattern_simulator.getNet(net).get(pattern) ? '1' : '0';
+
+			std::printf("%s%s\n", line.c_str(), stable ? "" : " unstable");
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Options options;
+
+	if (!parse_options(argc, argv, options)) {
+		print_usage();
+		return 1;
+	}
+
+	CircuitElementLoader loader;
+	loader.load(options.elements_path.c_str());
+
+	for (const auto& error : loader.errors)
+		std::fprintf(stderr, "%s\n", error.c_str());
+
+	if (loader.logic_gates.empty()) return 1;
+
+	std::vector<LogicUnit> logic_units;
+	CircuitElement::setLibrary(&loader.logic_gates, &logic_units);
+
+	// a unit sheet only sees the units before it, as in a project
+	for (const auto& path : options.unit_paths)
+		if (!load_unit(path, logic_units)) return 1;
+
+	SchematicSheet sheet;
+
+	if (!load_sheet(options.sheet_path, sheet)) return 1;
+
+	auto ports = get_ports(sheet);
+	auto nets  = get_nets(sheet);
+
+	// the unit ports are dumped unless there are none
+	const auto& probes = options.all_nets || ports.empty() ? nets : ports;
+
+	std::unordered_map<std::string, net_id_t> names;
+
+	for (const auto& probe : ports)
+		names.emplace(probe.name, probe.net);
+
+	for (const auto& probe : nets)
+		names.emplace(probe.name, probe.net);
+
+	Stimulus stimulus;
+	std::string error;
+
+	if (!options.stimulus_path.empty() && !stimulus.load(options.stimulus_path, names, error)) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	Breakpoints breakpoints;
+
+	for (const auto& str : options.breakpoints) {
+		Breakpoints::Breakpoint breakpoint;
+
+		if (!parse_breakpoint(str, names, breakpoint, error) || !breakpoints.add(breakpoint)) {
+			std::fprintf(stderr, "%s\n", error.empty() ? ("'" + str + "': bad breakpoint").c_str() : error.c_str());
+			return 1;
+		}
+	}
+
+	Simulator         simulator;
+	ParallelSimulator parallel_simulator;
+	WaveformRecorder  recorder;
+	VcdWriter         vcd_writer;
+
+	simulator.build(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount());
+
+	if (options.truth_table)
+		return print_truth_table(simulator, ports) ? 0 : 1;
+
+	bool parallel = options.thread_count > 1 && !simulator.hasDelays();
+
+	if (parallel) {
+		parallel_simulator.build(simulator, options.thread_count);
+		simulator.clear();
+	}
+
+	auto with_simulator = [&](auto&& func) {
+		return parallel ? func(parallel_simulator) : func(simulator);
+	};
+
+	if (!options.vcd_path.empty()) {
+		std::vector<net_id_t>    probe_nets;
+		std::vector<std::string> names;
+		std::vector<uint32_t>    vars;
+
+		for (const auto& probe : probes)
+			probe_nets.emplace_back(probe.net);
+
+		recorder.probe(probe_nets, with_simulator([](auto& sim) { return sim.getNetCount(); }));
+
+		// ports on one net, an input wired to an output or tied outputs, are one recorder probe
+		for (const auto& probe : probes) {
+			auto var = recorder.getProbe(probe.net);
+			if (var == NO_PROBE) continue;
+
+			names.emplace_back(probe.name);
+			vars.emplace_back(var);
+		}
+
+		if (!vcd_writer.open(options.vcd_path, names, vars)) {
+			std::fprintf(stderr, "cannot write '%s'\n", options.vcd_path.c_str());
+			return 1;
+		}
+
+		recorder.setWriter(&vcd_writer);
+
+		with_simulator([&](auto& sim) {
+			recorder.captureAll(sim.getTick(), sim.getNetValues());
+			sim.setRecorder(&recorder);
+		});
+	}
+
+	with_simulator([&](auto& sim) {
+		if (breakpoints.getCount()) {
+			breakpoints.sync(sim.getNetValues());
+			sim.setBreakpoints(&breakpoints);
+		}
+
+		run(sim, options, stimulus, breakpoints);
+
+		if (breakpoints.isHit())
+			std::printf("break %u at tick %llu\n", breakpoints.getHit() + 1, (unsigned long long)breakpoints.getHitTick());
+
+		std::printf("tick %llu%s\n", (unsigned long long)sim.getTick(), sim.isStable() ? "" : " unstable");
+
+		for (const auto& probe : probes)
+			std::printf("%s %s\n", probe.name.c_str(), to_string(sim.getNet(probe.net)));
+	});
+
+	vcd_writer.close();
+
+	return 0;
+}
\ No newline at end of file
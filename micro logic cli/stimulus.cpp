@@ -0,0 +1,78 @@
+#include "stimulus.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+static bool parse_logic_value(const std::string& str, LogicValue& value)
+{
+	if (str.size() != 1) return false;
+
+	switch (str[0]) {
+	case '0':           value = Logic_0; return true;
+	case '1':           value = Logic_1; return true;
+	case 'x': case 'X': value = Logic_X; return true;
+	case 'z': case 'Z': value = Logic_Z; return true;
+	default:            return false;
+	}
+}
+
+bool Stimulus::load(const std::string& path, const std::unordered_map<std::string, net_id_t>& names, std::string& error)
+{
+	std::ifstream file(path);
+
+	if (!file.is_open()) {
+		error = "cannot open '" + path + "'";
+		return false;
+	}
+
+	events.clear();
+
+	std::string line;
+	uint32_t line_number = 0;
+
+	while (std::getline(file, line)) {
+		++line_number;
+
+		line = line.substr(0, line.find('#'));
+
+		std::istringstream ss(line);
+		std::string tick_str, name, value_str, rest;
+
+		if (!(ss >> tick_str)) continue;
+
+		auto where = path + ":" + std::to_string(line_number) + ": ";
+
+		if (!(ss >> name >> value_str) || (ss >> rest)) {
+			error = where + "expected '<tick> <name> <value>'";
+			return false;
+		}
+
+		if (tick_str.find_first_not_of("0123456789") != std::string::npos) {
+			error = where + "bad tick '" + tick_str + "'";
+			return false;
+		}
+
+		auto iter = names.find(name);
+
+		if (iter == names.end()) {
+			error = where + "unknown name '" + name + "'";
+			return false;
+		}
+
+		LogicValue value;
+
+		if (!parse_logic_value(value_str, value)) {
+			error = where + "bad value '" + value_str + "'";
+			return false;
+		}
+
+		events.push_back({ std::stoull(tick_str), iter->second, value });
+	}
+
+	std::stable_sort(events.begin(), events.end(), [](const Event& lhs, const Event& rhs) {
+		return lhs.tick < rhs.tick;
+	});
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "simulation/logic_value.h"
+#include "net.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// text file of "<tick> <name> <value>" lines, value is 0, 1, x or z and # starts a comment.
+// names are resolved against the map given to load, events are kept sorted by tick
+class Stimulus {
+public:
+	struct Event {
+		uint64_t   tick;
+		net_id_t   net;
+		LogicValue value;
+	};
+
+	bool load(const std::string& path, const std::unordered_map<std::string, net_id_t>& names, std::string& error);
+
+	std::vector<Event> events;
+};
\ No newline at end of file
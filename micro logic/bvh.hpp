@@ -2,12 +2,31 @@
 
 #include "aabb.hpp"
 
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
 #include <vector>
 #include <stack>
+#include <utility>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#define BVH_USE_SSE
+#include <xmmintrin.h>
+#endif
 
 #define BVH_CONTINUE return false
 #define BVH_BREAK    return true
 
+#define BVH_BUILD_BINS          16
+#define BVH_BUILD_PARALLEL_SIZE 4096
+#define BVH_NODE_SLAB_SIZE      1024
+#define BVH_REFIT_MAX_GROWTH    2.f
+#define BVH_FLAT_REBUILD_COST   4 // pointer tree node visits a flat rebuild costs per element
+
 template <class Ty>
 struct _BVH_Node {
 	using key_type      = AABB;
@@ -68,6 +87,114 @@ struct _BVH_Node {
 	};
 };
 
+// nodes of one tree are carved out of slabs, freed nodes are kept in a free list and
+// reused before the slabs grow. the slabs are only returned to the heap all at once
+template <class Ty>
+class _BVH_Node_Pool {
+public:
+	_BVH_Node_Pool() noexcept :
+		free_list(nullptr),
+		slab_used(BVH_NODE_SLAB_SIZE)
+	{}
+
+	_BVH_Node_Pool(_BVH_Node_Pool&& rhs) noexcept :
+		slabs(std::move(rhs.slabs)),
+		free_list(std::exchange(rhs.free_list, nullptr)),
+		slab_used(std::exchange(rhs.slab_used, BVH_NODE_SLAB_SIZE))
+	{}
+
+	_BVH_Node_Pool& operator=(_BVH_Node_Pool&& rhs) noexcept {
+		slabs     = std::move(rhs.slabs);
+		free_list = std::exchange(rhs.free_list, nullptr);
+		slab_used = std::exchange(rhs.slab_used, BVH_NODE_SLAB_SIZE);
+		return *this;
+	}
+
+	template <class... Args>
+	_BVH_Node<Ty>* allocate(Args&&... args) {
+		_Slot* slot;
+
+		if (free_list) {
+			slot      = free_list;
+			free_list = slot->next;
+		} else {
+			if (slab_used == BVH_NODE_SLAB_SIZE) {
+				slabs.emplace_back(new _Slot[BVH_NODE_SLAB_SIZE]);
+				slab_used = 0;
+			}
+
+			slot = &slabs.back()[slab_used++];
+		}
+
+		return new (slot->storage) _BVH_Node<Ty>(std::forward<Args>(args)...);
+	}
+
+	void deallocate(_BVH_Node<Ty>* node) {
+		node->~_BVH_Node();
+
+		auto* slot = reinterpret_cast<_Slot*>(node);
+		slot->next = free_list;
+		free_list  = slot;
+	}
+
+	// drops every node without destroying them
+	void release() {
+		slabs.clear();
+		free_list = nullptr;
+		slab_used = BVH_NODE_SLAB_SIZE;
+	}
+
+	void swap(_BVH_Node_Pool& rhs) noexcept {
+		std::swap(slabs, rhs.slabs);
+		std::swap(free_list, rhs.free_list);
+		std::swap(slab_used, rhs.slab_used);
+	}
+
+private:
+	union _Slot {
+		_Slot* next;
+		alignas(_BVH_Node<Ty>) unsigned char storage[sizeof(_BVH_Node<Ty>)];
+	};
+
+	std::vector<std::unique_ptr<_Slot[]>> slabs;
+	_Slot*                                free_list;
+	size_t                                slab_used;
+};
+
+// four children of a node of the flattened tree side by side, one node is tested against a
+// query with a single compare per bound. empty slots have an inverted aabb and never pass
+struct alignas(16) _BVH_Flat_Node {
+	float   min_x[4];
+	float   min_y[4];
+	float   max_x[4];
+	float   max_y[4];
+	int32_t childs[4]; // index of a flat node, ~index of a leaf
+};
+
+// bit i is set if slot i of node overlaps aabb
+inline int _bvh_flat_overlap(const _BVH_Flat_Node& node, const AABB& aabb) {
+#ifdef BVH_USE_SSE
+	auto hit_x = _mm_and_ps(
+		_mm_cmple_ps(_mm_load_ps(node.min_x), _mm_set1_ps(aabb.max.x)),
+		_mm_cmpge_ps(_mm_load_ps(node.max_x), _mm_set1_ps(aabb.min.x)));
+	auto hit_y = _mm_and_ps(
+		_mm_cmple_ps(_mm_load_ps(node.min_y), _mm_set1_ps(aabb.max.y)),
+		_mm_cmpge_ps(_mm_load_ps(node.max_y), _mm_set1_ps(aabb.min.y)));
+
+	return _mm_movemask_ps(_mm_and_ps(hit_x, hit_y));
+#else
+	int mask = 0;
+
+	for (int i = 0; i < 4; ++i) {
+		if (node.min_x[i] <= aabb.max.x && node.max_x[i] >= aabb.min.x &&
+			node.min_y[i] <= aabb.max.y && node.max_y[i] >= aabb.min.y)
+			mask |= 1 << i;
+	}
+
+	return mask;
+#endif
+}
+
 template <class Ty>
 class _BVH_Const_Iterator {	
 	template <class>
@@ -196,28 +323,49 @@ public:
 
 	BVH() noexcept :
 		root(nullptr),
-		node_size(0) 
+		node_size(0),
+		flat_valid(false),
+		flat_stale_cost(0)
 	{}
 
 	BVH(BVH&& rhs) noexcept :
 		root(std::exchange(rhs.root, nullptr)),
-		node_size(std::exchange(rhs.node_size, 0))
-	{}
+		node_size(std::exchange(rhs.node_size, 0)),
+		pool(std::move(rhs.pool)),
+		flat_valid(false),
+		flat_stale_cost(0)
+	{
+		rhs._invalidate_flat();
+	}
 
 	template <class Iter>
-	BVH(Iter first, Iter last) {
+	BVH(Iter first, Iter last) :
+		root(nullptr),
+		node_size(0),
+		flat_valid(false),
+		flat_stale_cost(0)
+	{
 		insert(first, last);
 	}
+
+	~BVH() {
+		clear();
+	}
 	
 	BVH& operator=(BVH&& rhs) noexcept {
+		clear();
+
 		root      = std::exchange(rhs.root, nullptr);
 		node_size = std::exchange(rhs.node_size, 0);
+		pool      = std::move(rhs.pool);
+		rhs._invalidate_flat();
+		return *this;
 	}
 
 private:
 	_BVH_Node<Ty>* _find_best(const AABB& aabb) {
 		auto   cost_best = aabb.union_of(root->aabb).area();
-		auto** node_best = &root;
+		auto*  node_best = root;
 
 		find_stack.emplace_back(root, 0.f);
 
@@ -232,7 +380,7 @@ private:
 
 			if (cost_total < cost_best) {
 				cost_best = cost_total;
-				node_best = &curr_node;
+				node_best = curr_node;
 			}
 
 			cost_inherit += cost_direct - curr_node->aabb.area();
@@ -249,7 +397,7 @@ private:
 
 		find_stack.clear();
 
-		return *node_best;
+		return node_best;
 	}
 
 	void _refit(_BVH_Node<Ty>* node) {
@@ -259,14 +407,132 @@ private:
 		}
 	}
 
+	// swaps a child of node with a grandchild under the other child when that shrinks the
+	// other child the most (Kopta et al. 2012). the area of node itself does not change
+	void _rotate(_BVH_Node<Ty>* node) {
+		_BVH_Node<Ty>* best_child  = nullptr;
+		_BVH_Node<Ty>* best_grand  = nullptr;
+		float          best_shrink = 0.f;
+
+		for (int i = 0; i < 2; ++i) {
+			auto* child = node->childs[i];
+			auto* other = node->childs[!i];
+
+			if (other->is_leaf()) continue;
+
+			float area = other->aabb.area();
+
+			for (int j = 0; j < 2; ++j) {
+				float shrink = area - child->aabb.union_of(other->childs[!j]->aabb).area();
+
+				if (shrink > best_shrink) {
+					best_child  = child;
+					best_grand  = other->childs[j];
+					best_shrink = shrink;
+				}
+			}
+		}
+
+		if (!best_child) return;
+
+		auto* other = best_grand->parent;
+
+		(node->childs[0] == best_child ? node->childs[0] : node->childs[1]) = best_grand;
+		(other->childs[0] == best_grand ? other->childs[0] : other->childs[1]) = best_child;
+
+		best_grand->parent = node;
+		best_child->parent = other;
+		other->update_AABB();
+	}
+
+	// a branch waiting for refit has its aabb inverted, which no leaf or refit branch can have
+	static bool _is_marked(const _BVH_Node<Ty>* node) {
+		return node->aabb.min.x > node->aabb.max.x;
+	}
+
+	static void _mark_refit(_BVH_Node<Ty>* node) {
+		constexpr float inf = std::numeric_limits<float>::infinity();
+
+		while (node && !_is_marked(node)) {
+			node->aabb = AABB(inf, inf, -inf, -inf);
+			node = node->parent;
+		}
+	}
+
+	// post-order over the marked branches with a rotation at each, disjoint subtrees are
+	// refit concurrently
+	void _refit_marked(_BVH_Node<Ty>* node, uint32_t parallel_depth) {
+		auto* left  = node->childs[0];
+		auto* right = node->childs[1];
+
+		bool refit_left  = _is_marked(left);
+		bool refit_right = _is_marked(right);
+
+		if (parallel_depth && refit_left && refit_right) {
+			auto future = std::async(std::launch::async, [this, left, parallel_depth] { _refit_marked(left, parallel_depth - 1); });
+
+			_refit_marked(right, parallel_depth - 1);
+			future.get();
+		} else {
+			if (refit_left) _refit_marked(left, parallel_depth);
+			if (refit_right) _refit_marked(right, parallel_depth);
+		}
+
+		node->update_AABB();
+		_rotate(node);
+	}
+
+	// unlinks a leaf and frees its parent, the branch the sibling moves up to is marked
+	// for refit instead of refitting right away
+	void _detach(_BVH_Node<Ty>* node) {
+		auto* parent = std::exchange(node->parent, nullptr);
+
+		--node_size;
+
+		if (!parent) {
+			root = nullptr;
+			return;
+		}
+
+		auto* sibling = parent->childs[parent->childs[0] == node];
+		auto* grand   = parent->parent;
+
+		sibling->parent = grand;
+
+		if (grand) {
+			(grand->childs[0] == parent ? grand->childs[0] : grand->childs[1]) = sibling;
+			_mark_refit(grand);
+		} else {
+			root = sibling;
+		}
+
+		pool.deallocate(parent);
+	}
+
+	// refits the ancestors of a leaf that changed in place, rotating on the way up
+	void _refit_rotate(_BVH_Node<Ty>* node) {
+		while (node) {
+			auto old_aabb = node->aabb;
+
+			node->update_AABB();
+			_rotate(node);
+
+			if (node->aabb == old_aabb) break;
+
+			node = node->parent;
+		}
+	}
+
 	iterator _insert_one_impl(_BVH_Node<Ty>* new_node) {
+		_invalidate_flat();
+
 		if (empty()) {
 			new_node->parent = nullptr;
 			root      = new_node;
 		} else {
 			auto* sibling    = _find_best(new_node->aabb);
 			auto* old_parent = sibling->parent;
-			auto* new_parent = new _BVH_Node<Ty>();
+			auto* new_parent = pool.allocate();
 
 			sibling->parent       = new_parent;
 			new_node->parent      = new_parent;
@@ -291,35 +557,232 @@ private:
 		return iterator(new_node);
 	}
 
+	using _Build_Leaf = std::pair<point_type, _BVH_Node<Ty>*>;
+
+	template <class Val>
+	_Build_Leaf _make_leaf(Val&& val) {
+		auto* node = pool.allocate(val.first, std::forward<Val>(val).second);
+		return { node->aabb.center(), node };
+	}
+
+	// top-down binned sah build over the centroids of the leaves, the halves of large
+	// ranges are built concurrently until there are enough tasks for every core. a range
+	// of n leaves takes its n - 1 branches from the front of branches in depth-first order
+	static _BVH_Node<Ty>* _build(_Build_Leaf* first, _Build_Leaf* last, _BVH_Node<Ty>** branches, uint32_t parallel_depth) {
+		auto count = last - first;
+
+		if (count == 1) return first->second;
+
+		AABB bounds(first->first, first->first);
+
+		for (auto* leaf = first + 1; leaf != last; ++leaf)
+			bounds = bounds.union_of(AABB(leaf->first, leaf->first));
+
+		bool axis_y = bounds.width() < bounds.height();
+
+		auto coord = [axis_y](const point_type& v) {
+			return axis_y ? v.y : v.x;
+		};
+
+		float lower  = coord(bounds.min);
+		float extent = coord(bounds.max) - lower;
+
+		_Build_Leaf* mid = nullptr;
+
+		if (extent > 0.f) {
+			auto bin_of = [&](const _Build_Leaf& leaf) {
+				return std::min((int)((coord(leaf.first) - lower) / extent * BVH_BUILD_BINS), BVH_BUILD_BINS - 1);
+			};
+
+			AABB   bin_aabbs[BVH_BUILD_BINS];
+			size_t bin_counts[BVH_BUILD_BINS] = {};
+
+			for (auto* leaf = first; leaf != last; ++leaf) {
+				auto  bin   = bin_of(*leaf);
+				auto& aabb  = leaf->second->aabb;
+
+				bin_aabbs[bin] = bin_counts[bin]++ ? bin_aabbs[bin].union_of(aabb) : aabb;
+			}
+
+			// sweep from the right for the area and count above each plane, then from the
+			// left picking the plane with the least area * count on both sides
+			float  right_areas[BVH_BUILD_BINS];
+			size_t right_counts[BVH_BUILD_BINS];
+			AABB   right_aabb;
+			size_t right_count = 0;
+
+			for (int i = BVH_BUILD_BINS - 1; i > 0; --i) {
+				if (bin_counts[i])
+					right_aabb = right_count ? right_aabb.union_of(bin_aabbs[i]) : bin_aabbs[i];
+
+				right_count    += bin_counts[i];
+				right_areas[i]  = right_count ? right_aabb.area() : 0.f;
+				right_counts[i] = right_count;
+			}
+
+			AABB   left_aabb;
+			size_t left_count = 0;
+			float  cost_best  = std::numeric_limits<float>::max();
+			int    split_best = -1;
+
+			for (int i = 0; i < BVH_BUILD_BINS - 1; ++i) {
+				if (bin_counts[i])
+					left_aabb = left_count ? left_aabb.union_of(bin_aabbs[i]) : bin_aabbs[i];
+
+				left_count += bin_counts[i];
+
+				if (!left_count || !right_counts[i + 1]) continue;
+
+				float cost = left_aabb.area() * left_count + right_areas[i + 1] * right_counts[i + 1];
+
+				if (cost < cost_best) {
+					cost_best  = cost;
+					split_best = i;
+				}
+			}
+
+			if (split_best != -1) {
+				mid = std::partition(first, last, [&](const _Build_Leaf& leaf) {
+					return bin_of(leaf) <= split_best;
+				});
+			}
+		}
+
+		// every centroid in one place, split by count
+		if (mid == nullptr || mid == first || mid == last) {
+			mid = first + count / 2;
+			std::nth_element(first, mid, last, [&](const _Build_Leaf& lhs, const _Build_Leaf& rhs) {
+				return coord(lhs.first) < coord(rhs.first);
+			});
+		}
+
+		auto*  node           = branches[0];
+		auto** left_branches  = branches + 1;
+		auto** right_branches = branches + (mid - first);
+
+		if (parallel_depth && count >= BVH_BUILD_PARALLEL_SIZE) {
+			auto future = std::async(std::launch::async, _build, first, mid, left_branches, parallel_depth - 1);
+
+			node->childs[1] = _build(mid, last, right_branches, parallel_depth - 1);
+			node->childs[0] = future.get();
+		} else {
+			node->childs[0] = _build(first, mid, left_branches, 0);
+			node->childs[1] = _build(mid, last, right_branches, 0);
+		}
+
+		node->childs[0]->parent = node;
+		node->childs[1]->parent = node;
+		node->update_AABB();
+
+		return node;
+	}
+
+	// levels of a tree to split into concurrent tasks before every core has one
+	static uint32_t _parallel_depth() {
+		uint32_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+		uint32_t depth   = 0;
+
+		while ((1u << depth) < threads)
+			++depth;
+
+		return depth;
+	}
+
+	void _insert_many_impl(std::vector<_Build_Leaf>& leaves) {
+		if (leaves.empty()) return;
+
+		auto new_count = leaves.size();
+
+		// a batch as large as the tree is cheaper to build together with the tree
+		if (new_count >= node_size) {
+			_release_leaves(leaves);
+			new_count = leaves.size();
+			node_size = 0;
+		}
+
+		// the pool is not shared with the build threads
+		std::vector<_BVH_Node<Ty>*> branches(new_count - 1);
+
+		for (auto& branch : branches)
+			branch = pool.allocate();
+
+		auto* subtree = _build(leaves.data(), leaves.data() + leaves.size(), branches.data(), _parallel_depth());
+
+		// the subtree is linked in like a single leaf
+		_insert_one_impl(subtree);
+		node_size += new_count - 1;
+	}
+
+	// deletes the branches of the tree and appends its leaves
+	void _release_leaves(std::vector<_Build_Leaf>& leaves) {
+		if (!root) return;
+
+		stack.push_back(std::exchange(root, nullptr));
+
+		while (!stack.empty()) {
+			auto* node = stack.back();
+			stack.pop_back();
+
+			if (node->is_leaf()) {
+				node->parent = nullptr;
+				leaves.emplace_back(node->aabb.center(), node);
+			} else {
+				stack.push_back(node->childs[0]);
+				stack.push_back(node->childs[1]);
+				pool.deallocate(node);
+			}
+		}
+	}
+
 public:
 	iterator insert(const value_type& val) {
-		auto* new_node = new _BVH_Node<Ty>(val.first, val.second);
+		auto* new_node = pool.allocate(val.first, val.second);
 		return _insert_one_impl(new_node);
 	}
 
 	iterator insert(value_type&& val) {
-		auto* new_node = new _BVH_Node<Ty>(val.first, std::move(val.second));
+		auto* new_node = pool.allocate(val.first, std::move(val.second));
 		return _insert_one_impl(new_node);
 	}
 
 	iterator insert(const AABB& aabb, const Ty& item) {
-		auto* new_node = new _BVH_Node<Ty>(aabb, item);
+		auto* new_node = pool.allocate(aabb, item);
 		return _insert_one_impl(new_node);
 	}
 
 	iterator insert(const AABB& aabb, Ty&& item) {
-		auto* new_node = new _BVH_Node<Ty>(aabb, std::move(item));
+		auto* new_node = pool.allocate(aabb, std::move(item));
 		return _insert_one_impl(new_node);
 	}
 
 	template <class Iter>
 	void insert(Iter first, Iter last) {
-		static_assert("not implemented");
+		std::vector<_Build_Leaf> leaves;
+
+		for (; first != last; ++first)
+			leaves.push_back(_make_leaf(*first));
+
+		_insert_many_impl(leaves);
+	}
+
+	// same as above, writes the iterator of each inserted element to out in input order
+	template <class Iter, class OutIter>
+	OutIter insert(Iter first, Iter last, OutIter out) {
+		std::vector<_Build_Leaf> leaves;
+
+		for (; first != last; ++first) {
+			leaves.push_back(_make_leaf(*first));
+			*out++ = iterator(leaves.back().second);
+		}
+
+		_insert_many_impl(leaves);
+
+		return out;
 	}
 
 	template <class... Args>  
 	iterator emplace(const AABB& aabb, Args&&... args) {
-		return _insert_one_impl(new value_type(aabb, Ty(std::forward<Args>(args)...)));
+		return _insert_one_impl(pool.allocate(aabb, Ty(std::forward<Args>(args)...)));
 	}
 
 private:
@@ -329,6 +792,8 @@ private:
 		auto* node   = iter.ptr;
 		auto* parent = node->parent;
 
+		_invalidate_flat();
+
 		--node_size;
 
 		if (parent != nullptr) {
@@ -341,7 +806,7 @@ private:
 					erased = parent->erase_and_merge(1);
 				}
 
-				delete parent;
+				pool.deallocate(parent);
 
 				_refit(branch_parent);
 			} else {
@@ -353,7 +818,7 @@ private:
 					erased = std::exchange(parent->childs[1], nullptr);
 				}
 
-				delete std::exchange(root->parent, nullptr);
+				pool.deallocate(std::exchange(root->parent, nullptr));
 			}
 		} else {
 			erased = std::exchange(root, nullptr);
@@ -364,7 +829,11 @@ private:
 
 public:
 	void erase(iterator iter) {
-		delete _erase_impl(iter);
+		auto* node = _erase_impl(iter);
+
+		// only a leaf holds a value, branches hold their aabb in the same storage
+		node->value.~value_type();
+		pool.deallocate(node);
 	}
 
 	template <class Iter>
@@ -373,39 +842,101 @@ public:
 			erase(iter);
 	}
 
+	// small moves are refit in place, an aabb that grows its parent too much is reinserted
 	void update_element(iterator iter, const AABB aabb) {
-		auto* node = _erase_impl(iter);
-		node->aabb = aabb;
-		_insert_one_impl(node);
+		auto* node   = iter.ptr;
+		auto* parent = node->parent;
+
+		if (parent && parent->aabb.union_of(aabb).area() <= parent->aabb.area() * BVH_REFIT_MAX_GROWTH) {
+			node->aabb = aabb;
+			_refit_rotate(parent);
+			_invalidate_flat();
+		} else {
+			node = _erase_impl(iter);
+			node->aabb = aabb;
+			_insert_one_impl(node);
+		}
+	}
+
+	// moves the leaves of (iterator, aabb) pairs at once. leaves that stay near their parent
+	// are refit in place with every touched branch refit once, the others are taken out and
+	// built back in as one subtree
+	template <class Iter>
+	void update_elements(Iter first, Iter last) {
+		std::vector<_BVH_Node<Ty>*> near_leaves;
+		std::vector<_Build_Leaf>    far_leaves;
+
+		_invalidate_flat();
+
+		// sorted against the bounds before the move, marking overwrites them
+		for (; first != last; ++first) {
+			auto*       node   = first->first.ptr;
+			auto*       parent = node->parent;
+			const AABB& aabb   = first->second;
+
+			if (parent && parent->aabb.union_of(aabb).area() <= parent->aabb.area() * BVH_REFIT_MAX_GROWTH)
+				near_leaves.push_back(node);
+			else
+				far_leaves.emplace_back(aabb.center(), node);
+
+			node->aabb = aabb;
+		}
+
+		for (auto* node : near_leaves)
+			_mark_refit(node->parent);
+
+		for (auto& leaf : far_leaves)
+			_detach(leaf.second);
+
+		if (root && _is_marked(root)) {
+			auto parallel_depth = near_leaves.size() + far_leaves.size() >= BVH_BUILD_PARALLEL_SIZE ? _parallel_depth() : 0;
+			_refit_marked(root, parallel_depth);
+		}
+
+		_insert_many_impl(far_leaves);
 	}
 
 	void swap(BVH& rhs) noexcept {
 		std::swap(root, rhs.root);
 		std::swap(node_size, rhs.node_size);
+		pool.swap(rhs.pool);
+
+		_invalidate_flat();
+		rhs._invalidate_flat();
 	}
 
 	void clear() {
+		_invalidate_flat();
+
 		if (!root) return;
 
-		stack.push_back(root);
+		// only the values of the leaves need destroying, the nodes go with their slabs
+		if constexpr (!std::is_trivially_destructible_v<value_type>) {
+			stack.push_back(root);
 
-		while (!stack.empty()) {
-			auto* node = stack.back();
-			stack.pop_back();
+			while (!stack.empty()) {
+				auto* node = stack.back();
+				stack.pop_back();
 
-			if (!node->is_leaf()) {
-				stack.push_back(node->childs[0]);
-				stack.push_back(node->childs[1]);
+				if (node->is_leaf()) {
+					node->value.~value_type();
+				} else {
+					stack.push_back(node->childs[0]);
+					stack.push_back(node->childs[1]);
+				}
 			}
-
-			delete node;
 		}
 
+		pool.release();
+
+		root      = nullptr;
 		node_size = 0;
 	}
 
 	template <class Pred>
 	bool query(const point_type& pos, Pred func) {
+		if (_use_flat()) return _query_flat(AABB(pos, pos), func);
+
 		if (!root || !root->aabb.contain(pos)) {
 			return false;
 		}
@@ -416,6 +947,8 @@ public:
 			auto* node = stack.back();
 			stack.pop_back();
 
+			++flat_stale_cost;
+
 			if (node->is_leaf()) {
 				if (func(iterator(node))) {
 					stack.clear();
@@ -434,6 +967,8 @@ public:
 
 	template <class Pred>
 	bool query(const rect_type& rect, Pred func) {
+		if (_use_flat()) return _query_flat(AABB(rect), func);
+
 		if (!root || !root->aabb.overlap(rect)) {
 			return false;
 		}
@@ -444,6 +979,8 @@ public:
 			auto* node = stack.back();
 			stack.pop_back();
 
+			++flat_stale_cost;
+
 			if (node->is_leaf()) {
 				if (func(iterator(node))) {
 					stack.clear();
@@ -482,6 +1019,137 @@ public:
 	}
 
 private:
+	void _invalidate_flat() {
+		flat_valid = false;
+	}
+
+	// after an edit queries go through the pointer tree until they have visited about as
+	// many nodes as rebuilding the flat tree costs, so a few hovers between edits never
+	// wait for a rebuild and heavy querying pays for one at most twice
+	bool _use_flat() {
+		if (flat_valid) return true;
+
+		if (flat_stale_cost >= node_size * BVH_FLAT_REBUILD_COST) {
+			_flatten();
+			return true;
+		}
+
+		return false;
+	}
+
+	// collapses two levels of the tree into each flat node, depth-first
+	void _flatten() {
+		flat_nodes.clear();
+		flat_leaves.clear();
+		flat_nodes.reserve(node_size / 2 + 1);
+		flat_leaves.reserve(node_size);
+
+		if (root && root->is_branch()) {
+			_flatten_branch(root);
+		} else if (root) {
+			const _BVH_Node<Ty>* slots[4] = { root };
+			_emit_flat_node(slots, 1);
+		}
+
+		flat_valid      = true;
+		flat_stale_cost = 0;
+	}
+
+	int32_t _flatten_branch(const _BVH_Node<Ty>* node) {
+		const _BVH_Node<Ty>* slots[4] = { node->childs[0], node->childs[1] };
+		int                  count    = 2;
+
+		// open up the largest branch among the slots until they are full. the childs of an
+		// opened branch stay next to each other so the slots keep the order of the tree
+		while (count < 4) {
+			int   best      = -1;
+			float best_area = -1.f;
+
+			for (int i = 0; i < count; ++i) {
+				if (slots[i]->is_branch() && slots[i]->aabb.area() > best_area) {
+					best      = i;
+					best_area = slots[i]->aabb.area();
+				}
+			}
+
+			if (best == -1) break;
+
+			auto* opened = slots[best];
+
+			for (int i = count++; i > best + 1; --i)
+				slots[i] = slots[i - 1];
+
+			slots[best]     = opened->childs[0];
+			slots[best + 1] = opened->childs[1];
+		}
+
+		return _emit_flat_node(slots, count);
+	}
+
+	int32_t _emit_flat_node(const _BVH_Node<Ty>* const* slots, int count) {
+		constexpr float inf = std::numeric_limits<float>::infinity();
+
+		auto index = (int32_t)flat_nodes.size();
+		flat_nodes.emplace_back();
+
+		for (int i = 0; i < 4; ++i) {
+			AABB    aabb(inf, inf, -inf, -inf);
+			int32_t child = 0;
+
+			if (i < count) {
+				aabb = slots[i]->aabb;
+
+				if (slots[i]->is_leaf()) {
+					child = ~(int32_t)flat_leaves.size();
+					flat_leaves.push_back(const_cast<_BVH_Node<Ty>*>(slots[i]));
+				} else {
+					child = _flatten_branch(slots[i]);
+				}
+			}
+
+			auto& node = flat_nodes[index];
+			node.min_x[i]  = aabb.min.x;
+			node.min_y[i]  = aabb.min.y;
+			node.max_x[i]  = aabb.max.x;
+			node.max_y[i]  = aabb.max.y;
+			node.childs[i] = child;
+		}
+
+		return index;
+	}
+
+	template <class Pred>
+	bool _query_flat(const AABB& aabb, Pred& func) {
+		if (flat_nodes.empty()) return false;
+
+		flat_stack.push_back(0);
+
+		while (!flat_stack.empty()) {
+			auto index = flat_stack.back();
+			flat_stack.pop_back();
+
+			// leaves go through the stack too, so they are visited in the same order as
+			// the pointer tree visits them
+			if (index < 0) {
+				if (func(iterator(flat_leaves[~index]))) {
+					flat_stack.clear();
+					return true;
+				}
+
+				continue;
+			}
+
+			const auto& node = flat_nodes[index];
+			int         mask = _bvh_flat_overlap(node, aabb);
+
+			for (int i = 0; mask; ++i, mask >>= 1) {
+				if (mask & 1) flat_stack.push_back(node.childs[i]);
+			}
+		}
+
+		return false;
+	}
+
 	_BVH_Node<Ty>* _find_first() const {
 		if (!root) return nullptr;
 
@@ -530,6 +1198,15 @@ private:
 	_BVH_Node<Ty>* root;
 	size_type node_size;
 
+	_BVH_Node_Pool<Ty> pool;
+
+	// read-only copy of the tree for queries, rebuilt lazily after edits
+	std::vector<_BVH_Flat_Node> flat_nodes;
+	std::vector<_BVH_Node<Ty>*> flat_leaves;
+	std::vector<int32_t>        flat_stack;
+	bool                        flat_valid;
+	size_t                      flat_stale_cost;
+
 	std::vector<std::pair<_BVH_Node<Ty>*, float>> find_stack;
 	std::vector<_BVH_Node<Ty>*> stack;
 };
\ No newline at end of file
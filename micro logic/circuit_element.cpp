@@ -1,10 +1,9 @@
 #include "circuit_element.h"
 
-#include "main_window.h"
 #include "math_utils.h"
 #include "sdf.h"
 
-#define TEXTURE_ID_OFF 2
+#define TEXTURE_ID_OFF 3
 
 static inline bool on_same_line(const vec2& pa0, const vec2& pa1, const vec2& pb0, const vec2& pb1) {
 	if (std::abs((pa1.y - pa0.y) * (pb1.x - pb0.x) - (pb1.y - pb0.y) * (pa1.x - pa0.x)) > 1e-7) return false;
@@ -28,16 +27,25 @@ static inline uint32_t  get_intersection_code(const AABB& aabb, const vec2& p) {
 	return code;
 }
 
+static const std::vector<LogicGate>* library_gates = nullptr;
+static const std::vector<LogicUnit>* library_units = nullptr;
+
 Pin::Pin() :
 	net(nullptr)
 {}
 
+void CircuitElement::setLibrary(const std::vector<::LogicGate>* logic_gates, const std::vector<::LogicUnit>* logic_units)
+{
+	library_gates = logic_gates;
+	library_units = logic_units;
+}
+
 std::unique_ptr<CircuitElement> CircuitElement::create(std::istream& is)
 {
 	Type type;
 	read_binary(is, type);
-	
-	auto& main_window = MainWindow::get();
+
+	assert(library_gates && library_units);
 
 	switch (type) {
 	case Type::LogicGate: {
@@ -51,7 +59,10 @@ std::unique_ptr<CircuitElement> CircuitElement::create(std::istream& is)
 		read_binary(is, elem->pos);
 		read_binary(is, elem->dir);
 
-		elem->shared = main_window.logic_gates[shared_id].shared;
+		if (shared_id >= library_gates->size()) return nullptr;
+
+		elem->shared = (*library_gates)[shared_id].shared;
+		elem->pins.resize(elem->shared->pin_layouts.size());
 
 		return elem;
 	}
@@ -66,7 +77,11 @@ std::unique_ptr<CircuitElement> CircuitElement::create(std::istream& is)
 		read_binary(is, elem->pos);
 		read_binary(is, elem->dir);
 
-		elem->shared = main_window.logic_units[shared_id].shared;
+		// units are created in order on load, the sheet of a unit only sees the ones before it
+		if (shared_id >= library_units->size()) return nullptr;
+
+		elem->shared = (*library_units)[shared_id].shared;
+		elem->pins.resize(elem->shared->pin_layouts.size());
 
 		return elem;
 	}
@@ -87,8 +102,40 @@ std::unique_ptr<CircuitElement> CircuitElement::create(std::istream& is)
 		return elem;
 	}
 	case Type::Net: {
-		//auto elem = std::make_unique<::Net>();
+		auto elem = std::make_unique<::Bus>();
 
+		read_binary(is, elem->id);
+		read_binary(is, elem->style);
+		read_binary(is, elem->p0);
+		read_binary(is, elem->p1);
+		read_binary(is, elem->dot0);
+		read_binary(is, elem->dot1);
+		read_binary(is, elem->select_p0);
+		read_binary(is, elem->select_p1);
+		read_binary(is, elem->hover_p0);
+		read_binary(is, elem->hover_p1);
+		read_binary(is, elem->width);
+
+		if (elem->width == 0 || elem->width > MAX_BUS_WIDTH) return nullptr;
+
+		elem->nets.resize(elem->width);
+
+		return elem;
+	}
+	case Type::Splitter: {
+		auto elem = std::make_unique<::Splitter>();
+
+		read_binary(is, elem->id);
+		read_binary(is, elem->style);
+		read_binary(is, elem->pos);
+		read_binary(is, elem->dir);
+		read_binary(is, elem->width);
+
+		if (elem->width == 0 || elem->width > MAX_BUS_WIDTH) return nullptr;
+
+		elem->pins.resize(elem->width);
+
+		return elem;
 	}
 	default:
 		return nullptr;
@@ -188,6 +235,10 @@ bool LogicElement::hit(const AABB& aabb) const
 
 bool LogicElement::hit(const vec2& pos) const
 {
+#ifdef MICRO_LOGIC_HEADLESS
+	// no image mask without textures
+	return shared->extent.contain(rotate_vector(pos - this->pos, invert_dir(dir)));
+#else
 	auto rect  = shared->extent;
 	auto& mask = shared->image_mask;
 	auto size  = mask.size();
@@ -198,6 +249,7 @@ bool LogicElement::hit(const vec2& pos) const
 	if (p.x < 0 || size.x <= p.x || p.y < 0 || size.y <= p.y) return false;
 
 	return mask.getPixel((uint32_t)p.x, (uint32_t)p.y).a != 0;
+#endif
 }
 
 Pin* LogicElement::getPin(const vec2& pos)
@@ -228,6 +280,7 @@ std::unique_ptr<CircuitElement> LogicGate::clone(int32_t new_id) const
 	return std::move(new_one);
 }
 
+#ifndef MICRO_LOGIC_HEADLESS
 void LogicGate::draw(vk2d::DrawList& draw_list) const
 {
 	if (style & Style::Hidden) return;
@@ -309,6 +362,7 @@ void LogicGate::draw(vk2d::DrawList& draw_list) const
 		cmd.indices.emplace_back(idx + 2);
 	}
 }
+#endif
 
 CircuitElement::Type LogicGate::getType() const
 {
@@ -317,6 +371,18 @@ CircuitElement::Type LogicGate::getType() const
 
 void LogicUnit::serialize(std::ostream& os) const
 {
+	write_binary(os, Type::LogicUnit);
+	write_binary(os, id);
+	write_binary(os, style);
+	write_binary(os, shared->shared_id);
+	write_binary(os, pos);
+	write_binary(os, dir);
+}
+
+bool LogicUnit::hit(const vec2& pos) const
+{
+	auto p = rotate_vector(pos - this->pos, invert_dir(dir));
+	return shared->extent.contain(p);
 }
 
 std::unique_ptr<CircuitElement> LogicUnit::clone(int32_t new_id) const
@@ -326,10 +392,58 @@ std::unique_ptr<CircuitElement> LogicUnit::clone(int32_t new_id) const
 	return std::move(new_one);
 }
 
+#ifndef MICRO_LOGIC_HEADLESS
 void LogicUnit::draw(vk2d::DrawList& draw_list) const
 {
+	if (style & Style::Hidden) return;
+
+	auto& cmd = draw_list[2];
+	auto rect = shared->extent;
+	auto a    = style & Style::Cut ? 128 : 255;
+
+	vk2d::Color color(55, 55, 55, a);
+	vk2d::Color pin_color(195, 195, 195, a);
+
+	// units have no texture, the body sits half a grid inside the pin columns
+	vec2 p0(rect.left + 0.5f, rect.top);
+	vec2 p1(rect.left + rect.width - 0.5f, rect.top);
+	vec2 p2(rect.left + rect.width - 0.5f, rect.top + rect.height);
+	vec2 p3(rect.left + 0.5f, rect.top + rect.height);
+
+	p0 = rotate_vector(p0, dir) + pos;
+	p1 = rotate_vector(p1, dir) + pos;
+	p2 = rotate_vector(p2, dir) + pos;
+	p3 = rotate_vector(p3, dir) + pos;
+
+	for (const auto& layout : shared->pin_layouts) {
+		vec2 end(layout.pos.x < 0.f ? layout.pos.x + 0.5f : layout.pos.x - 0.5f, layout.pos.y);
+
+		cmd.addLine(
+			rotate_vector(layout.pos, dir) + pos,
+			rotate_vector(end, dir) + pos,
+			6 / DEFAULT_GRID_SIZE,
+			pin_color);
+	}
 
+	cmd.addFilledTriangle(p0, p1, p2, color);
+	cmd.addFilledTriangle(p0, p2, p3, color);
+
+	if (!(style & (Style::Hovered | Style::Selected | Style::Blocked))) return;
+
+	vk2d::Color mask_color;
+
+	if (style & Style::Blocked) {
+		mask_color = vk2d::Color(255, 0, 0, 48);
+	} else if (style & Style::Hovered) {
+		mask_color = vk2d::Color(255, 255, 255, 32);
+	} else if (style & Style::Selected) {
+		mask_color = vk2d::Color(0, 255, 0, 16);
+	}
+
+	cmd.addFilledTriangle(p0, p1, p2, mask_color);
+	cmd.addFilledTriangle(p0, p2, p3, mask_color);
 }
+#endif
 
 CircuitElement::Type LogicUnit::getType() const
 {
@@ -344,7 +458,8 @@ WireElement::WireElement() :
 	select_p0(false),
 	select_p1(false),
 	hover_p0(false),
-	hover_p1(false)
+	hover_p1(false),
+	net(nullptr)
 {}
 
 WireElement::WireElement(const vec2& p0, const vec2& p1) :
@@ -355,7 +470,8 @@ WireElement::WireElement(const vec2& p0, const vec2& p1) :
 	select_p0(false),
 	select_p1(false),
 	hover_p0(false),
-	hover_p1(false)
+	hover_p1(false),
+	net(nullptr)
 {}
 
 void WireElement::transform(const vec2& delta, const vec2& origin, Direction rotation)
@@ -511,11 +627,12 @@ void Wire::serialize(std::ostream & os) const
 	write_binary(os, hover_p1);
 }
 
+#ifndef MICRO_LOGIC_HEADLESS
 void Wire::draw(vk2d::DrawList& draw_list) const
 {
 	if (style & Style::Hidden) return;
 
-	auto& cmd = draw_list[1];
+	auto& cmd = draw_list[2];
 
 	vk2d::Color color(50, 177, 108, style & Style::Cut ? 128 : 255);
 
@@ -554,6 +671,7 @@ void Wire::draw(vk2d::DrawList& draw_list) const
 	if (dot0) cmd.addFilledCircle(p0, 6 / DEFAULT_GRID_SIZE, color);
 	if (dot1) cmd.addFilledCircle(p1, 6 / DEFAULT_GRID_SIZE, color);
 }
+#endif
 
 std::unique_ptr<CircuitElement> Wire::clone(int32_t new_id) const
 {
@@ -603,4 +721,183 @@ bool Wire::hit(const vec2& pos) const
 CircuitElement::Type Wire::getType() const
 {
 	return CircuitElement::Wire;
+}
+
+Bus::Bus() :
+	width(DEFAULT_BUS_WIDTH),
+	nets(DEFAULT_BUS_WIDTH, nullptr)
+{}
+
+Bus::Bus(const vec2& p0, const vec2& p1, uint32_t width) :
+	Wire(p0, p1),
+	width(width),
+	nets(width, nullptr)
+{}
+
+void Bus::serialize(std::ostream& os) const
+{
+	write_binary(os, Type::Net);
+	write_binary(os, id);
+	write_binary(os, style);
+	write_binary(os, p0);
+	write_binary(os, p1);
+	write_binary(os, dot0);
+	write_binary(os, dot1);
+	write_binary(os, select_p0);
+	write_binary(os, select_p1);
+	write_binary(os, hover_p0);
+	write_binary(os, hover_p1);
+	write_binary(os, width);
+}
+
+#ifndef MICRO_LOGIC_HEADLESS
+void Bus::draw(vk2d::DrawList& draw_list) const
+{
+	if (style & Style::Hidden) return;
+
+	auto& cmd = draw_list[2];
+
+	vk2d::Color color(58, 132, 214, style & Style::Cut ? 128 : 255);
+
+	if (style & Style::Selected) {
+		vk2d::Color color_select(163, 212, 255);
+
+		if (select_p0 && select_p1)
+			cmd.addFilledCapsule(p0, p1, 8 / DEFAULT_GRID_SIZE, color_select);
+		else {
+			vec2 mid = (p0 + p1) / 2.f;
+
+			cmd.addFilledHalfCapsule(p0, mid, 8 / DEFAULT_GRID_SIZE, select_p0 ? color_select : color, color);
+			cmd.addFilledHalfCapsule(p1, mid, 8 / DEFAULT_GRID_SIZE, select_p1 ? color_select : color, color);
+		}
+	} else if (style & Style::Hovered) {
+		vk2d::Color color_hovered(124, 186, 241);
+
+		if (hover_p0)
+			cmd.addFilledCircle(p0, 10 / DEFAULT_GRID_SIZE, color_hovered);
+		if (hover_p1)
+			cmd.addFilledCircle(p1, 10 / DEFAULT_GRID_SIZE, color_hovered);
+
+		cmd.addFilledCapsule(p0, p1, 8 / DEFAULT_GRID_SIZE, hover_p0 && hover_p1 ? color_hovered : color);
+	} else {
+		cmd.addFilledCapsule(p0, p1, 8 / DEFAULT_GRID_SIZE, color);
+	}
+
+	if (dot0) cmd.addFilledCircle(p0, 10 / DEFAULT_GRID_SIZE, color);
+	if (dot1) cmd.addFilledCircle(p1, 10 / DEFAULT_GRID_SIZE, color);
+}
+#endif
+
+std::unique_ptr<CircuitElement> Bus::clone(int32_t new_id) const
+{
+	auto new_one = std::make_unique<Bus>(*this);
+	if (new_id != -1) new_one->id = new_id;
+	return std::move(new_one);
+}
+
+CircuitElement::Type Bus::getType() const
+{
+	return CircuitElement::Net;
+}
+
+Splitter::Splitter() :
+	width(DEFAULT_BUS_WIDTH),
+	pins(DEFAULT_BUS_WIDTH)
+{}
+
+Splitter::Splitter(uint32_t width) :
+	width(width),
+	pins(width)
+{}
+
+void Splitter::serialize(std::ostream& os) const
+{
+	write_binary(os, Type::Splitter);
+	write_binary(os, id);
+	write_binary(os, style);
+	write_binary(os, pos);
+	write_binary(os, dir);
+	write_binary(os, width);
+}
+
+#ifndef MICRO_LOGIC_HEADLESS
+void Splitter::draw(vk2d::DrawList& draw_list) const
+{
+	if (style & Style::Hidden) return;
+
+	auto& cmd = draw_list[2];
+	auto a    = style & Style::Cut ? 128 : 255;
+
+	vk2d::Color bus_color(58, 132, 214, a);
+	vk2d::Color bit_color(50, 177, 108, a);
+
+	if (style & Style::Blocked)
+		bus_color = vk2d::Color(255, 0, 0, a);
+	else if (style & Style::Selected)
+		bus_color = vk2d::Color(163, 212, 255, a);
+	else if (style & Style::Hovered)
+		bus_color = vk2d::Color(124, 186, 241, a);
+
+	auto spine = pos + rotate_vector(vec2(0.5f, 0.f), dir);
+
+	for (uint32_t bit = 0; bit < width; ++bit) {
+		auto p = getBitPosition(bit);
+		cmd.addFilledCapsule(p - rotate_vector(vec2(0.5f, 0.f), dir), p, 4 / DEFAULT_GRID_SIZE, bit_color);
+	}
+
+	cmd.addFilledCapsule(pos, spine, 8 / DEFAULT_GRID_SIZE, bus_color);
+	cmd.addFilledCapsule(spine, spine + rotate_vector(vec2(0.f, width - 1.f), dir), 8 / DEFAULT_GRID_SIZE, bus_color);
+}
+#endif
+
+std::unique_ptr<CircuitElement> Splitter::clone(int32_t new_id) const
+{
+	auto new_one = std::make_unique<Splitter>(*this);
+	if (new_id != -1) new_one->id = new_id;
+	return std::move(new_one);
+}
+
+AABB Splitter::getAABB() const
+{
+	float thickness = 0.25f;
+
+	auto p0 = pos;
+	auto p1 = getBitPosition(width - 1);
+
+	AABB aabb;
+	aabb.min.x = std::min(p0.x, p1.x) - thickness;
+	aabb.min.y = std::min(p0.y, p1.y) - thickness;
+	aabb.max.x = std::max(p0.x, p1.x) + thickness;
+	aabb.max.y = std::max(p0.y, p1.y) + thickness;
+	return aabb;
+}
+
+bool Splitter::hit(const AABB& aabb) const
+{
+	return getAABB().overlap(aabb);
+}
+
+bool Splitter::hit(const vec2& pos) const
+{
+	return getAABB().contain(pos);
+}
+
+CircuitElement::Type Splitter::getType() const
+{
+	return CircuitElement::Splitter;
+}
+
+Pin* Splitter::getPin(const vec2& pos)
+{
+	for (uint32_t bit = 0; bit < width; ++bit)
+		if (equal(pos, getBitPosition(bit)))
+			return &pins[bit];
+
+	return nullptr;
+}
+
+// the bus side is at pos, the bits one grid over and stacked from bit 0
+vec2 Splitter::getBitPosition(uint32_t bit) const
+{
+	return pos + rotate_vector(vec2(1.f, (float)bit), dir);
 }
\ No newline at end of file
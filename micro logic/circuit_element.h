@@ -5,11 +5,21 @@
 #include "aabb.hpp"
 #include "bvh.hpp"
 #include "net.h"
+#include "simulation/logic_program.h"
+#ifndef MICRO_LOGIC_HEADLESS
 #include <vk2d/graphics/image.h>
 #include <vk2d/graphics/draw_list.h>
+#endif
+#include <climits>
 #include <memory>
 
 #define DEFAULT_GRID_SIZE (30.f)
+#define DEFAULT_BUS_WIDTH 8
+#define MAX_BUS_WIDTH     64
+
+class UnitModule;
+class LogicGate;
+class LogicUnit;
 
 struct PinLayout {
 	enum IO : uint16_t {
@@ -23,6 +33,7 @@ struct PinLayout {
 	vec2     pos;
 	IO       io;
 	uint16_t pinout;
+	uint32_t delay; // output delay in ticks, 0 uses the gate delay
 };
 
 class Pin {
@@ -47,18 +58,23 @@ public:
 		LogicGate,
 		LogicUnit,
 		Wire,
-		Net
+		Net,
+		Splitter
 	};
 
 	using bvh_iterator_t = typename BVH<std::unique_ptr<CircuitElement>>::iterator;
 	using StyleFlags     = uint32_t;
 
+	// create() resolves the shared ids of gates and units against these
+	static void setLibrary(const std::vector<::LogicGate>* logic_gates, const std::vector<::LogicUnit>* logic_units);
 	static std::unique_ptr<CircuitElement> create(std::istream& is);
 
 	CircuitElement();
 	virtual ~CircuitElement();
 
+#ifndef MICRO_LOGIC_HEADLESS
 	virtual void draw(vk2d::DrawList& draw_list) const = 0;
+#endif
 	virtual std::unique_ptr<CircuitElement> clone(int32_t new_id = -1) const = 0;
 	virtual AABB getAABB() const = 0;
 	virtual bool hit(const AABB& aabb) const = 0;
@@ -83,7 +99,7 @@ public:
 	bvh_iterator_t iter;
 };
 
-class RigidElement abstract : public CircuitElement {
+class RigidElement : public CircuitElement {
 public:
 	RigidElement();
 
@@ -111,6 +127,14 @@ public:
 
 public:
 	struct Shared {
+		using evaluate_t = uint64_t(*)(const Shared& shared, uint64_t pins);
+
+		enum class Port : uint8_t {
+			None,
+			Input,
+			Output
+		};
+
 		std::string name;
 		std::string category;
 		std::string description;
@@ -118,6 +142,7 @@ public:
 		uint64_t    element_id;
 		Rect        extent;
 
+#ifndef MICRO_LOGIC_HEADLESS
 		const vk2d::Texture* texture;
 		const vk2d::Texture* texture_mask;
 		uint64_t             texture_id;
@@ -126,8 +151,20 @@ public:
 		uvec2                texture_extent;
 		
 		vk2d::Image image_mask;
+#endif
 
 		std::vector<PinLayout> pin_layouts;
+
+		uint64_t     input_mask;  // bit n is pins[n]
+		uint64_t     output_mask;
+		uint64_t     vcc_mask;    // pins driving a constant 1
+		uint64_t     gnd_mask;    // pins driving a constant 0
+		uint32_t     delay;       // ticks from an input change to the outputs
+		LogicProgram logic;
+		evaluate_t   evaluate;
+		Port         port;        // boundary pin of a unit sheet
+
+		std::shared_ptr<UnitModule> module; // compiled sheet of a unit, shared by its instances
 	};
 
 	std::shared_ptr<Shared> shared;
@@ -140,7 +177,9 @@ public:
 	void serialize(std::ostream& os) const override;
 
 	std::unique_ptr<CircuitElement> clone(int32_t new_id = -1) const override;
+#ifndef MICRO_LOGIC_HEADLESS
 	void draw(vk2d::DrawList& draw_list) const override;
+#endif
 	Type getType() const override;
 
 public:
@@ -148,16 +187,22 @@ public:
 
 class LogicUnit : public LogicElement {
 public:
+	using LogicElement::hit;
+
 	void serialize(std::ostream& os) const override;
 
+	bool hit(const vec2& pos) const override;
+
 	std::unique_ptr<CircuitElement> clone(int32_t new_id = -1) const override;
+#ifndef MICRO_LOGIC_HEADLESS
 	void draw(vk2d::DrawList& draw_list) const override;
+#endif
 	Type getType() const override;
 
 public:
 };
 
-class WireElement abstract : public CircuitElement {
+class WireElement : public CircuitElement {
 public:
 	WireElement();
 	WireElement(const vec2& p0, const vec2& p1);
@@ -181,6 +226,8 @@ public:
 	bool select_p1;
 	bool hover_p0;
 	bool hover_p1;
+
+	::Net* net;
 };
 
 class Wire : public WireElement {
@@ -190,10 +237,59 @@ public:
 
 	void serialize(std::ostream& os) const override;
 
+#ifndef MICRO_LOGIC_HEADLESS
 	void draw(vk2d::DrawList& draw_list) const override;
+#endif
 	std::unique_ptr<CircuitElement> clone(int32_t new_id = -1) const override;
 	AABB getAABB() const override;
 	bool hit(const AABB& aabb) const override;
 	bool hit(const vec2& pos) const override;
 	Type getType() const override;
+};
+
+// wire of width bits, carries nets[n] for bit n. buses only connect to buses and the bus
+// side of splitters, bit n to bit n. the engines pack its bit nets into one word, a tick
+// fans out the bits of the bus that changed in a single pass
+class Bus : public Wire {
+public:
+	Bus();
+	Bus(const vec2& p0, const vec2& p1, uint32_t width);
+
+	void serialize(std::ostream& os) const override;
+
+#ifndef MICRO_LOGIC_HEADLESS
+	void draw(vk2d::DrawList& draw_list) const override;
+#endif
+	std::unique_ptr<CircuitElement> clone(int32_t new_id = -1) const override;
+	Type getType() const override;
+
+	uint32_t width;
+
+	std::vector<::Net*> nets;
+};
+
+// joins bit n of the bus ending at pos to the wires and pins at getBitPosition(n)
+class Splitter : public RigidElement {
+public:
+	Splitter();
+	Splitter(uint32_t width);
+
+	void serialize(std::ostream& os) const override;
+
+#ifndef MICRO_LOGIC_HEADLESS
+	void draw(vk2d::DrawList& draw_list) const override;
+#endif
+	std::unique_ptr<CircuitElement> clone(int32_t new_id = -1) const override;
+	AABB getAABB() const override;
+	bool hit(const AABB& aabb) const override;
+	bool hit(const vec2& pos) const override;
+	Type getType() const override;
+
+	Pin* getPin(const vec2& pos) override;
+
+	vec2 getBitPosition(uint32_t bit) const;
+
+	uint32_t width;
+
+	std::vector<Pin> pins; // pins[n] is bit n
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "circuit_element_loader.h"
 
+#ifndef MICRO_LOGIC_HEADLESS
 #include "vk2d/graphics/vertex_buffer.h"
+#endif
 #include <tinyxml2.h>
 #include <regex>
 
@@ -34,6 +36,7 @@ static float parse_float(const tinyxml2::XMLElement* element, const char* name)
 	return element->FloatAttribute(name);
 }
 
+#ifndef MICRO_LOGIC_HEADLESS
 static vk2d::Color parse_color(const tinyxml2::XMLElement* element, const char* name)
 {
 	static const std::regex re("^#(?:[0-9a-fA-F]{3,4}){2}$", std::regex::optimize);
@@ -55,12 +58,23 @@ static vk2d::Color parse_color(const tinyxml2::XMLElement* element, const char*
 
 	return color;
 }
+#endif
 
 static std::string parse_string(const tinyxml2::XMLElement* element, const char* name) {
 	const char* str = element->Attribute(name);
 	return str ? std::string(str) : std::string();
 }
 
+static uint64_t evaluate_logic_program(const LogicElement::Shared& shared, uint64_t pins)
+{
+	return shared.logic.evaluate(pins);
+}
+
+static uint64_t evaluate_logic_table(const LogicElement::Shared& shared, uint64_t pins)
+{
+	return shared.logic.evaluateTables(pins);
+}
+
 static std::string to_lower(const char* c_str) {
 	std::string result;
 
@@ -71,54 +85,49 @@ static std::string to_lower(const char* c_str) {
 	return result;
 }
 
+#ifdef MICRO_LOGIC_HEADLESS
+void CircuitElementLoader::load(const char* dir)
+{
+	logic_gates.clear();
+	errors.clear();
+
+	tinyxml2::XMLDocument doc;
+
+	if (doc.LoadFile(dir) != tinyxml2::XML_SUCCESS) {
+		errors.emplace_back("cannot load '" + std::string(dir) + "'");
+		return;
+	}
+
+	createGates(doc.RootElement());
+}
+#else
 void CircuitElementLoader::load(const char* dir, const vk2d::Font& font)
 {
 	logic_gates.clear();
 	textures.clear();
 	texture_datas.clear();
+	errors.clear();
 
 	this->font = &font;
 
 	tinyxml2::XMLDocument doc;
-	doc.LoadFile(dir);
 
-	auto* root = doc.RootElement();
-
-	grid_pixel_size = parse_float(root, "grid_pixel_size");
-	grid_scale      = DEFAULT_GRID_SIZE / grid_pixel_size;
-	scailing        = parse_float(root, "scailing");
+	if (doc.LoadFile(dir) != tinyxml2::XML_SUCCESS) {
+		errors.emplace_back("cannot load '" + std::string(dir) + "'");
+		return;
+	}
 
-	uint32_t id = 0;
+	auto* root = doc.RootElement();
 
-	{ // create gates and get extent
-		auto* elem = root->FirstChildElement("LogicGate");
-		for (; elem; elem = elem->NextSiblingElement("LogicGate"), id++) {
-			auto& gate  = logic_gates.emplace_back();
-			auto extent = getExtent(elem);
-			
-			gate.shared                 = std::make_shared<LogicGate::Shared>();
-			gate.shared->name           = parse_string(elem, "name");
-			gate.shared->category       = parse_string(elem, "category");
-			gate.shared->description    = parse_string(elem, "description");
-			gate.shared->element_id     = id;
-			gate.shared->shared_id      = id;
-			gate.shared->extent         = scale_rect(extent, 1.f / grid_pixel_size);
-			gate.shared->texture_coord  = scale_rect(extent, scailing);
-			gate.shared->texture_extent = gate.shared->texture_coord.getSize();
-
-			getPinLayouts(elem, gate.shared->pin_layouts);
-
-			gate.pos = {};
-			gate.dir = Direction::Up;
-			gate.pins.resize(gate.shared->pin_layouts.size(), {});
-		}
-	}
+	if (!createGates(root)) return;
 
 	calculatePacking();
 
 	{ // load elements
+		uint32_t id = 0;
+
 		auto* elem = root->FirstChildElement("LogicGate");
-		for (id = 0; elem; elem = elem->NextSiblingElement("LogicGate"), id++)
+		for (; elem; elem = elem->NextSiblingElement("LogicGate"), id++)
 			renderTexture(elem->FirstChildElement("Appearance")->FirstChildElement(), id);
 
 		for (auto& data : texture_datas) {
@@ -146,7 +155,66 @@ void CircuitElementLoader::load(const char* dir, const vk2d::Font& font)
 		}
 	}
 }
+#endif
 
+bool CircuitElementLoader::createGates(tinyxml2::XMLElement* root)
+{
+	if (!root) {
+		errors.emplace_back("elements file has no root element");
+		return false;
+	}
+
+	grid_pixel_size = parse_float(root, "grid_pixel_size");
+	grid_scale      = DEFAULT_GRID_SIZE / grid_pixel_size;
+	scailing        = parse_float(root, "scailing");
+
+	uint32_t id = 0;
+
+	auto* elem = root->FirstChildElement("LogicGate");
+	for (; elem; elem = elem->NextSiblingElement("LogicGate"), id++) {
+		auto& gate  = logic_gates.emplace_back();
+		auto extent = getExtent(elem);
+		
+		gate.shared                 = std::make_shared<LogicGate::Shared>();
+		gate.shared->name           = parse_string(elem, "name");
+		gate.shared->category       = parse_string(elem, "category");
+		gate.shared->description    = parse_string(elem, "description");
+		gate.shared->element_id     = id;
+		gate.shared->shared_id      = id;
+		gate.shared->extent         = scale_rect(extent, 1.f / grid_pixel_size);
+		gate.shared->delay          = std::max(elem->UnsignedAttribute("delay", 1), 1u);
+		gate.shared->port           = getPort(elem);
+#ifndef MICRO_LOGIC_HEADLESS
+		gate.shared->texture_coord  = scale_rect(extent, scailing);
+		gate.shared->texture_extent = gate.shared->texture_coord.getSize();
+#endif
+
+		getPinLayouts(elem, gate.shared->pin_layouts);
+
+		for (const auto& layout : gate.shared->pin_layouts) {
+			assert(0 < layout.pinout && layout.pinout <= 64);
+
+			if (layout.io == PinLayout::Input)
+				gate.shared->input_mask |= 1ull << (layout.pinout - 1);
+			else if (layout.io == PinLayout::Output)
+				gate.shared->output_mask |= 1ull << (layout.pinout - 1);
+			else if (layout.io == PinLayout::VCC)
+				gate.shared->vcc_mask |= 1ull << (layout.pinout - 1);
+			else if (layout.io == PinLayout::GND)
+				gate.shared->gnd_mask |= 1ull << (layout.pinout - 1);
+		}
+
+		compileLogic(elem, *gate.shared);
+
+		gate.pos = {};
+		gate.dir = Direction::Up;
+		gate.pins.resize(gate.shared->pin_layouts.size(), {});
+	}
+
+	return true;
+}
+
+#ifndef MICRO_LOGIC_HEADLESS
 void CircuitElementLoader::calculatePacking()
 {
 	const auto max_size = vk2d::Texture::getMaximumSize();
@@ -239,6 +307,7 @@ void CircuitElementLoader::renderTexture(tinyxml2::XMLElement* drawings, uint64_
 		}
 	}
 }
+#endif
 
 void CircuitElementLoader::getPinLayouts(tinyxml2::XMLElement* elem, std::vector<PinLayout>& pin_layouts)
 {
@@ -262,9 +331,38 @@ void CircuitElementLoader::getPinLayouts(tinyxml2::XMLElement* elem, std::vector
 
 		layout.pinout = atoi(elem->Attribute("pinout"));
 		layout.pos    = parse_vec2(elem, "pos");
+		layout.delay  = elem->UnsignedAttribute("delay", 0);
 	}
 }
 
+void CircuitElementLoader::compileLogic(tinyxml2::XMLElement* elem, LogicElement::Shared& shared)
+{
+	auto* logic = elem->FirstChildElement("Logic");
+
+	if (!logic || !logic->GetText()) return;
+
+	std::string error;
+
+	if (!shared.logic.compile(logic->GetText(), shared.input_mask, shared.output_mask, error))
+		errors.emplace_back("'" + shared.name + "' <Logic>: " + error);
+	else if (shared.logic.tabulated())
+		shared.evaluate = &evaluate_logic_table;
+	else
+		shared.evaluate = &evaluate_logic_program;
+}
+
+LogicElement::Shared::Port CircuitElementLoader::getPort(tinyxml2::XMLElement* elem)
+{
+	auto port = to_lower(parse_string(elem, "port").c_str());
+
+	if (port == "input")
+		return LogicElement::Shared::Port::Input;
+	else if (port == "output")
+		return LogicElement::Shared::Port::Output;
+
+	return LogicElement::Shared::Port::None;
+}
+
 Rect CircuitElementLoader::getExtent(tinyxml2::XMLElement* elem)
 {
 	auto drawings = elem->FirstChildElement("Appearance")->FirstChildElement();
@@ -1,8 +1,10 @@
 #pragma once
 
+#ifndef MICRO_LOGIC_HEADLESS
 #include <vk2d/graphics/render_texture.h>
 #include <vk2d/graphics/draw_list.h>
 #include <vk2d/system/font.h>
+#endif
 
 #include "circuit_element.h"
 
@@ -12,24 +14,38 @@ class XMLElement;
 
 class CircuitElementLoader {
 public:
+#ifdef MICRO_LOGIC_HEADLESS
+	void load(const char* dir);
+#else
 	void load(const char* dir, const vk2d::Font& font);
+#endif
 
 private:
+	bool createGates(tinyxml2::XMLElement* root);
+#ifndef MICRO_LOGIC_HEADLESS
 	void calculatePacking();
 	void renderTexture(tinyxml2::XMLElement* drawings, uint64_t id);
+#endif
 	void getPinLayouts(tinyxml2::XMLElement* elem, std::vector<PinLayout>& pin_layouts);
+	void compileLogic(tinyxml2::XMLElement* elem, LogicElement::Shared& shared);
+	LogicElement::Shared::Port getPort(tinyxml2::XMLElement* elem);
 
 	Rect getExtent(tinyxml2::XMLElement* elem);
 
 public:
 	std::vector<LogicGate>     logic_gates;
+#ifndef MICRO_LOGIC_HEADLESS
 	std::vector<vk2d::Texture> textures;
+#endif
+	std::vector<std::string>   errors;
 	
 private:
+	float grid_pixel_size;
+	float grid_scale;
+	float scailing;
+
+#ifndef MICRO_LOGIC_HEADLESS
 	const vk2d::Font* font;
-	float             grid_pixel_size;
-	float             grid_scale;
-	float             scailing;
 
 	struct TextureData {
 		vk2d::DrawList      drawlist;
@@ -38,4 +54,5 @@ private:
 	};
 
 	std::vector<TextureData> texture_datas;
+#endif
 };
\ No newline at end of file
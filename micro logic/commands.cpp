@@ -13,6 +13,26 @@ static AABB transform_AABB(const AABB& aabb, const vec2& delta, const vec2& orig
 	return result;
 }
 
+// takes the selection out of the netlist, transforms it and moves it in the bvh at once
+template <class Func>
+static void transform_selections(SchematicSheet& sheet, Func transform) {
+	std::vector<std::pair<bvh_iterator_t, AABB>> moves;
+	moves.reserve(sheet.selections.size());
+
+	for (auto selection : sheet.selections)
+		sheet.netlist.erase(*selection->second);
+
+	for (auto selection : sheet.selections) {
+		auto& elem = *selection->second;
+
+		transform(elem);
+		moves.emplace_back(selection, elem.getAABB());
+	}
+
+	sheet.bvh.update_elements(moves.begin(), moves.end());
+	sheet.netlist.insert(sheet.selections);
+}
+
 CommandGroup::CommandGroup() :
 	modifying(true)
 {}
@@ -69,16 +89,26 @@ void Command_Add::redo(SchematicSheet& sheet)
 
 	refs.reserve(item_count);
 
-	for (auto& elem_ptr : elements) {
-		auto& elem = *elem_ptr;
-		
-		auto iter = sheet.bvh.insert(elem.getAABB(), std::move(elem_ptr));
+	std::vector<std::pair<AABB, std::unique_ptr<CircuitElement>>> new_elems;
+	new_elems.reserve(item_count);
+
+	for (auto& elem_ptr : elements)
+		new_elems.emplace_back(elem_ptr->getAABB(), std::move(elem_ptr));
+
+	sheet.bvh.insert(
+		std::make_move_iterator(new_elems.begin()),
+		std::make_move_iterator(new_elems.end()),
+		std::back_inserter(refs));
+
+	for (auto& iter : refs) {
+		auto& elem = *iter->second;
+
 		elem.id   = sheet.id_counter++;
 		elem.iter = iter;
-
-		refs.emplace_back(iter);
 	}
 
+	sheet.netlist.insert(refs);
+
 	elements.clear();
 	elements.shrink_to_fit();
 }
@@ -95,6 +125,7 @@ void Command_Add::undo(SchematicSheet& sheet)
 	for (auto iter : refs) {
 		elements.emplace_back(std::move(iter->second));
 		sheet.bvh.erase(iter);
+		sheet.netlist.erase(*elements.back());
 	}
 
 	refs.clear();
@@ -298,23 +329,17 @@ void Command_Move::onPush(SchematicSheet& sheet)
 
 void Command_Move::redo(SchematicSheet& sheet)
 {
-	for (auto& selection : sheet.selections) {
-		auto& elem = static_cast<CircuitElement&>(*selection->second);
-
+	transform_selections(sheet, [&](CircuitElement& elem) {
 		elem.transform(delta, origin, dir);
-		sheet.bvh.update_element(selection, elem.getAABB());
-	}
+	});
 }
 
 void Command_Move::undo(SchematicSheet& sheet)
 {
-	for (auto& selection : sheet.selections) {
-		auto& elem = static_cast<CircuitElement&>(*selection->second);
-
+	transform_selections(sheet, [&](CircuitElement& elem) {
 		elem.transform({}, origin, invert_dir(dir));
 		elem.transform(-delta, {}, Direction::Up);
-		sheet.bvh.update_element(selection, elem.getAABB());
-	}
+	});
 }
 
 std::string Command_Move::what() const
@@ -345,6 +370,7 @@ void Command_Copy::redo(SchematicSheet& sheet)
 			elem.id   = sheet.id_counter++;
 			elem.iter = iter;
 
+			sheet.netlist.insert(elem);
 			refs.emplace_back(iter);
 		}
 	} else {
@@ -361,6 +387,7 @@ void Command_Copy::redo(SchematicSheet& sheet)
 			elem.id   = sheet.id_counter++;
 			elem.iter = iter;
 
+			sheet.netlist.insert(elem);
 			refs.emplace_back(iter);
 		}
 
@@ -381,6 +408,7 @@ void Command_Copy::undo(SchematicSheet& sheet)
 	for (auto iter : refs) {
 		elements.emplace_back(std::move(iter->second));
 		sheet.bvh.erase(iter);
+		sheet.netlist.erase(*elements.back());
 	}
 
 	refs.clear();
@@ -399,29 +427,21 @@ void Command_Cut::onPush(SchematicSheet& sheet)
 
 void Command_Cut::redo(SchematicSheet& sheet)
 {
-	for (auto& selection : sheet.selections) {
-		auto& elem = static_cast<CircuitElement&>(*selection->second);
-
+	transform_selections(sheet, [&](CircuitElement& elem) {
 		elem.select();
 		elem.transform(delta, origin, dir);
 		elem.unselect();
-
-		sheet.bvh.update_element(selection, elem.getAABB());
-	}
+	});
 }
 
 void Command_Cut::undo(SchematicSheet& sheet)
 {
-	for (auto& selection : sheet.selections) {
-		auto& elem = static_cast<CircuitElement&>(*selection->second);
-
+	transform_selections(sheet, [&](CircuitElement& elem) {
 		elem.select();
 		elem.transform({}, origin, invert_dir(dir));
 		elem.transform(-delta, {}, Direction::Up);
 		elem.unselect();
-
-		sheet.bvh.update_element(selection, elem.getAABB());
-	}
+	});
 }
 
 std::string Command_Cut::what() const
@@ -441,6 +461,7 @@ void Command_Delete::redo(SchematicSheet& sheet)
 
 		elements.emplace_back(std::move(selection->second));
 		sheet.bvh.erase(selection);
+		sheet.netlist.erase(elem);
 	}
 
 	sheet.selections.clear();
@@ -448,8 +469,13 @@ void Command_Delete::redo(SchematicSheet& sheet)
 
 void Command_Delete::undo(SchematicSheet& sheet)
 {
-	for (auto& elem : elements) {
-		auto iter = sheet.bvh.insert(elem->getAABB(), std::move(elem));
+	for (auto& elem_ptr : elements) {
+		auto& elem = *elem_ptr;
+
+		auto iter = sheet.bvh.insert(elem.getAABB(), std::move(elem_ptr));
+		elem.iter = iter;
+
+		sheet.netlist.insert(elem);
 		sheet.selections.emplace_back(iter);
 	}
 
@@ -5,6 +5,7 @@
 #include <vk2d/graphics/texture_view.h>
 #include <vk2d/system/clipboard.h>
 #include <imgui_internal.h>
+#include <imgui_stdlib.h>
 #include <tinyxml2.h>
 #include <filesystem>
 #include <fstream>
@@ -16,6 +17,7 @@
 #include "gui/imgui_impl_vk2d.h"
 #include "gui/imgui_custom.h"
 #include "util/convert_string.h"
+#include "util/bit_utils.h"
 #include "dialogs.h"
 #include "circuit_element_loader.h"
 #include "commands.h"
@@ -82,6 +84,10 @@ bool is_sub_path(const fs::path& base, const fs::path& destination)
 }
 
 MainWindow::MainWindow() :
+	simulated_sheet(nullptr),
+	simulated_revision(0),
+	oscillation_reported(false),
+	breakpoint_reported(NO_BREAKPOINT),
 	initialized(false)
 {
 	assert(!main_window);
@@ -125,6 +131,9 @@ MainWindow::MainWindow() :
 
 		logic_gates.swap(loader.logic_gates);
 		gate_textures.swap(loader.textures);
+		load_errors.swap(loader.errors);
+
+		CircuitElement::setLibrary(&logic_gates, &logic_units);
 	}
 	{
 		window_library.bindMenuLibrary(dynamic_cast<Menu_Library&>(*side_menus[3]));
@@ -142,6 +151,9 @@ MainWindow::MainWindow() :
 	ResizingLoop::initResizingLoop(window);
 	Dialog::pushImpls(3);
 	window.setVisible(true);
+
+	for (const auto& error : load_errors)
+		showErrorDialog(error);
 }
 
 MainWindow::~MainWindow()
@@ -206,6 +218,8 @@ void MainWindow::loop() {
 		if (getCurrentWindowSheet().window)
 			getCurrentSideMenu().loop();
 
+	updateSimulation();
+
 	closeUnvisibleWindowSheet();
 	for (auto& ws : window_sheets) {
 		ws->showUI();
@@ -475,6 +489,11 @@ bool MainWindow::saveProject()
 		elem->SetAttribute("path", sheet->path.c_str());
 		elem->SetAttribute("guid", sheet->guid.c_str());
 	}
+	for (const auto& guid : unit_sources) {
+		auto* elem = root->InsertNewChildElement("LogicUnit");
+
+		elem->SetAttribute("sheet", guid.c_str());
+	}
 	{
 		auto* elem = root->InsertNewChildElement("ImGui");
 
@@ -554,16 +573,34 @@ bool MainWindow::openProjectImpl(const std::string& path)
 		return false;
 	}
 	
+	// units of the new project are created into their own library while loading,
+	// it replaces the current one only after every sheet loaded
+	std::vector<LogicUnit>   new_units;
+	std::vector<std::string> new_unit_sources;
+
+	CircuitElement::setLibrary(&logic_gates, &new_units);
+
+	auto restore_library = [&]() {
+		CircuitElement::setLibrary(&logic_gates, &logic_units);
+	};
+
 	{
+		std::vector<tinyxml2::XMLElement*> entries;
+
 		auto* elem = root->FirstChildElement("SchematicSheet");
-		for (; elem; elem = elem->NextSiblingElement("SchematicSheet")) {
-			std::string file_path = elem->Attribute("path");
+		for (; elem; elem = elem->NextSiblingElement("SchematicSheet"))
+			entries.emplace_back(elem);
+
+		new_sheets.resize(entries.size());
+
+		auto load_sheet = [&](size_t idx) {
+			std::string file_path = entries[idx]->Attribute("path");
 			std::string full_path = new_project_dir + '/' + file_path;
 
-			SchematicSheetPtr_t sheet;
+			auto& sheet = new_sheets[idx];
 			if (!openSchematicSheetImpl(sheet, new_project_dir, full_path)) return false;
 
-			if (elem->Attribute("guid") != sheet->guid) {
+			if (entries[idx]->Attribute("guid") != sheet->guid) {
 				MessageBox msg_box;
 				msg_box.owner   = &window;
 				msg_box.title   = "Error";
@@ -574,7 +611,43 @@ bool MainWindow::openProjectImpl(const std::string& path)
 				return false;
 			}
 
-			new_sheets.emplace_back(std::move(sheet));
+			return true;
+		};
+
+		// sheets of units first and in creation order, a sheet may contain the units created before it
+		elem = root->FirstChildElement("LogicUnit");
+		for (; elem; elem = elem->NextSiblingElement("LogicUnit")) {
+			std::string guid = elem->Attribute("sheet");
+
+			auto iter = std::find_if(entries.begin(), entries.end(), [&](const auto* entry) {
+				return entry->Attribute("guid") == guid;
+			});
+
+			if (iter == entries.end()) {
+				MessageBox msg_box;
+				msg_box.owner   = &window;
+				msg_box.title   = "Error";
+				msg_box.content = "cannot locate the sheet of unit " + std::to_string(new_units.size());
+				msg_box.icon    = icon_to_texture_view(ICON_ERROR_BIG);
+
+				msg_box.showDialog();
+				restore_library();
+				return false;
+			}
+
+			auto idx = iter - entries.begin();
+
+			if ((!new_sheets[idx] && !load_sheet(idx)) || !createLogicUnit(*new_sheets[idx], new_units, new_unit_sources)) {
+				restore_library();
+				return false;
+			}
+		}
+
+		for (size_t idx = 0; idx < entries.size(); ++idx) {
+			if (!new_sheets[idx] && !load_sheet(idx)) {
+				restore_library();
+				return false;
+			}
 		}
 	}
 	{
@@ -588,16 +661,21 @@ bool MainWindow::openProjectImpl(const std::string& path)
 			msg_box.icon    = icon_to_texture_view(ICON_ERROR_BIG);
 
 			msg_box.showDialog();
+			restore_library();
 			return false;
 		}
 
 		imgui_ini = Base64::decode(elem->GetText());
 	}
 
+	restore_library();
 	closeProjectImpl();
 	initializeProject();
 	ImGui::LoadIniSettingsFromMemory(imgui_ini.c_str());
 
+	logic_units.swap(new_units);
+	unit_sources.swap(new_unit_sources);
+
 	project_name   = new_project_name;
 	project_dir    = new_project_dir;
 	project_path   = new_project_dir + '/' + new_project_name + PROJECT_EXT;
@@ -616,11 +694,15 @@ bool MainWindow::closeProjectImpl()
 
 	ImGui::VK2D::ShutDown(window);
 
+	stopSimulation();
+
 	project_name = "";
 	project_dir  = "";
 	project_path = "";
 	sheets.clear();
 	window_sheets.clear();
+	logic_units.clear();
+	unit_sources.clear();
 
 	initialized = false;
 
@@ -947,6 +1029,9 @@ bool MainWindow::deleteSchematicSheet(SchematicSheet& sheet)
 		ws->show = false;
 	}
 
+	if (&sheet == simulated_sheet)
+		stopSimulation();
+
 	for (auto iter = sheets.begin(); iter != sheets.end(); ++iter) {
 		if (iter->get() == &sheet) {
 			sheets.erase(iter);
@@ -1124,6 +1209,244 @@ bool MainWindow::isUndoable()
 	return getCurrentWindowSheet().isUndoable();
 }
 
+bool MainWindow::createLogicUnit(SchematicSheet& sheet)
+{
+	return createLogicUnit(sheet, logic_units, unit_sources);
+}
+
+bool MainWindow::createLogicUnit(SchematicSheet& sheet, std::vector<LogicUnit>& units, std::vector<std::string>& sources)
+{
+	sheet.updateNetlist();
+
+	auto module = std::make_shared<UnitModule>();
+
+	std::string error;
+	if (!module->build(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount(), true, error)) {
+		showErrorDialog("Cannot create a unit from '" + sheet.name + "': " + error, &window);
+		return false;
+	}
+
+	auto shared = create_unit_shared(std::move(module), sheet.name, units.size());
+
+	auto& unit = units.emplace_back();
+	unit.shared = std::move(shared);
+	unit.pos    = {};
+	unit.dir    = Direction::Up;
+	unit.pins.resize(unit.shared->pin_layouts.size(), {});
+
+	sources.emplace_back(sheet.guid);
+
+	return true;
+}
+
+void MainWindow::startSimulation(SchematicSheet& sheet)
+{
+	sheet.updateNetlist();
+
+	simulated_sheet    = &sheet;
+	simulated_revision = sheet.netlist.getRevision();
+	simulation.start(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount());
+
+	// the nets were renumbered
+	if (auto* ws = findWindowSheet(sheet))
+		ws->update_wires = true;
+}
+
+// goes on with the edited sheet from the state of the running simulation
+void MainWindow::restartSimulation()
+{
+	auto& sheet = *simulated_sheet;
+	sheet.updateNetlist();
+
+	simulated_revision = sheet.netlist.getRevision();
+	simulation.restart(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount());
+
+	if (auto* ws = findWindowSheet(sheet))
+		ws->update_wires = true;
+}
+
+// restarts without waiting for the edits to settle, for using the net ids of the sheet
+void MainWindow::syncSimulation()
+{
+	if (!simulation.isRunning()) return;
+
+	if (!simulated_sheet->netlist.isValid() || !simulated_sheet->netlist.isFlat())
+		restartSimulation();
+}
+
+void MainWindow::stopSimulation()
+{
+	simulation.stopCapture();
+	simulation.stop();
+	simulated_sheet = nullptr;
+
+	if (oscillation_reported || breakpoint_reported != NO_BREAKPOINT)
+		postStatusMessage("");
+
+	oscillation_reported = false;
+	breakpoint_reported  = NO_BREAKPOINT;
+}
+
+void MainWindow::updateSimulation()
+{
+	if (!simulation.isRunning()) return;
+
+	// the sheet was edited, the simulation goes on with it once the edits stop for a moment
+	// instead of rebuilding every frame of a drag
+	const auto& netlist = simulated_sheet->netlist;
+
+	if (!netlist.isValid() || !netlist.isFlat()) {
+		using namespace std::chrono;
+
+		if (netlist.getRevision() != simulated_revision) {
+			simulated_revision  = netlist.getRevision();
+			simulated_edit_time = clock_t::now();
+		} else if (duration_cast<milliseconds>(clock_t::now() - simulated_edit_time).count() >= SIMULATION_RESTART_DELAY) {
+			restartSimulation();
+		}
+	}
+
+	if (!simulation.updateSnapshot()) return;
+
+	const auto& snapshot = simulation.getSnapshot();
+
+	if (snapshot.oscillating && !oscillation_reported) {
+		postStatusMessage(
+			"Oscillation on " + std::to_string(snapshot.oscillating_nets.size()) +
+			" nets, simulation halted at tick " + std::to_string(snapshot.tick));
+	} else if (!snapshot.oscillating && oscillation_reported) {
+		postStatusMessage("");
+	}
+
+	oscillation_reported = snapshot.oscillating;
+
+	if (snapshot.breakpoint != NO_BREAKPOINT && breakpoint_reported == NO_BREAKPOINT) {
+		simulation.setPaused(true);
+		postStatusMessage(
+			"Breakpoint " + std::to_string(snapshot.breakpoint + 1) + " hit at tick " + std::to_string(snapshot.tick));
+	} else if (snapshot.breakpoint == NO_BREAKPOINT && breakpoint_reported != NO_BREAKPOINT) {
+		postStatusMessage("");
+	}
+
+	breakpoint_reported = snapshot.breakpoint;
+}
+
+void MainWindow::recordSimulation()
+{
+	syncSimulation();
+
+	// the selected wires, every net of the sheet if none is selected
+	auto nets = getSelectedNets();
+
+	if (nets.empty()) {
+		const auto& netlist = simulated_sheet->netlist;
+
+		for (net_id_t net = 0; net < netlist.getNetCount(); ++net)
+			if (netlist.net_sizes[net])
+				nets.emplace_back(net);
+	}
+
+	FileSaveDialog dialog;
+	dialog.owner        = &window;
+	dialog.title        = "Record waveform";
+	dialog.default_dir  = project_dir;
+	dialog.default_name = simulated_sheet->name;
+	dialog.filters.emplace_back("Value change dump", WAVEFORM_EXT_NAME);
+
+	if (dialog.showDialog() != DialogResult::OK) return;
+
+	auto path = fs::path(dialog.path).replace_extension(WAVEFORM_EXT);
+
+	if (!simulation.startCapture(nets, path.generic_string()))
+		showErrorDialog("Cannot write '" + path.generic_string() + "'", &window);
+}
+
+// one breakpoint per selected net for edges, the selected nets as one bus otherwise
+void MainWindow::addBreakpoint(Breakpoints::Condition condition)
+{
+	syncSimulation();
+
+	auto nets = getSelectedNets();
+
+	Breakpoints::Breakpoint breakpoint = { condition, {}, 0, 0 };
+
+	if (condition == Breakpoints::Rising || condition == Breakpoints::Falling) {
+		for (auto net : nets) {
+			breakpoint.nets = { net };
+			simulation.addBreakpoint(breakpoint);
+		}
+
+		return;
+	}
+
+	if (nets.size() > MAX_BREAKPOINT_NETS) {
+		showErrorDialog("A breakpoint can watch at most " + std::to_string(MAX_BREAKPOINT_NETS) + " nets", &window);
+		return;
+	}
+
+	breakpoint.nets = nets;
+
+	if (condition != Breakpoints::Unknown &&
+		!parse_bus_value(breakpoint_value, (uint32_t)nets.size(), breakpoint.value, breakpoint.known)) {
+		showErrorDialog("'" + breakpoint_value + "' is not a " + std::to_string(nets.size()) + " bit value", &window);
+		return;
+	}
+
+	simulation.addBreakpoint(breakpoint);
+}
+
+// nets of the selected wires in selection order, so the first one selected is bit 0 of a bus.
+// a selected bus adds its bits in order
+std::vector<net_id_t> MainWindow::getSelectedNets() const
+{
+	std::vector<net_id_t> nets;
+
+	auto add_net = [&](const Net* net) {
+		if (net && std::find(nets.begin(), nets.end(), net->id) == nets.end())
+			nets.emplace_back(net->id);
+	};
+
+	for (auto iter : simulated_sheet->selections) {
+		auto& elem = *iter->second;
+
+		if (elem.getType() == CircuitElement::Wire)
+			add_net(static_cast<WireElement&>(elem).net);
+		else if (elem.getType() == CircuitElement::Net)
+			for (auto* net : static_cast<Bus&>(elem).nets)
+				add_net(net);
+	}
+
+	return nets;
+}
+
+void MainWindow::runScalingBenchmark(SchematicSheet& sheet)
+{
+	sheet.updateNetlist();
+
+	Simulator simulator;
+	simulator.build(sheet.netlist.elements, sheet.netlist.buses, sheet.netlist.getNetCount());
+
+	MessageBox msg_box;
+	msg_box.owner = &window;
+	msg_box.title = "Scaling Benchmark";
+
+	// ParallelSimulator would run every delay as one tick
+	if (simulator.hasDelays()) {
+		msg_box.content = "the sheet has gate delays, which only the single threaded simulator models";
+		msg_box.icon    = icon_to_texture_view(ICON_WARNING_BIG);
+
+		msg_box.showDialog();
+		return;
+	}
+
+	auto results = benchmark_scaling(simulator, { 1, 2, 4, 8, 16 });
+
+	msg_box.content = std::to_string(simulator.getGateCount()) + " gates, " +
+		std::to_string(simulator.getNetCount()) + " nets\n\n" + format_scaling_results(results);
+
+	msg_box.showDialog();
+}
+
 void MainWindow::beginClipboardPaste()
 {
 	if (curr_menu->isBusy() || !vk2d::Clipboard::available()) return;
@@ -1367,6 +1690,122 @@ void MainWindow::showMainMenus()
 		}
 
 		if (ImGui::BeginMenu("Simulation")) {
+			bool has_ws     = curr_window_sheet;
+			bool simulating = simulation.isRunning();
+
+			if (ImGui::MenuItem("Start", nullptr, false, has_ws && !simulating))
+				startSimulation(*curr_window_sheet->sheet);
+
+			if (ImGui::MenuItem("Stop", nullptr, false, simulating))
+				stopSimulation();
+
+			ImGui::Separator();
+
+			bool paused = simulation.isPaused();
+			if (ImGui::MenuItem("Pause", nullptr, &paused, simulating))
+				simulation.setPaused(paused);
+
+			if (ImGui::MenuItem("Reset", nullptr, false, simulating))
+				simulation.reset();
+
+			if (simulating) {
+				const auto& snapshot = simulation.getSnapshot();
+
+				auto tick = snapshot.tick;
+				ImGui::SetNextItemWidth(150);
+				if (ImGui::SliderScalar("Rewind", ImGuiDataType_U64, &tick, &snapshot.history_begin, &snapshot.history_end) && tick != snapshot.tick)
+					simulation.rewind(tick);
+
+				ImGui::TextDisabled("%.1f MB history", simulation.getHistoryMemory() / (1024.f * 1024.f));
+			}
+
+			ImGui::Separator();
+
+			float tick_rate = simulation.getTickRate();
+			ImGui::SetNextItemWidth(150);
+			if (ImGui::SliderFloat("Tick Rate", &tick_rate, 1.f, 1e6f, "%.0f Hz", ImGuiSliderFlags_Logarithmic))
+				simulation.setTickRate(tick_rate);
+
+			bool halt = simulation.getSettleLimit() != 0;
+			if (ImGui::MenuItem("Halt on Oscillation", nullptr, &halt))
+				simulation.setSettleLimit(halt ? DEFAULT_SETTLE_LIMIT : 0);
+
+			if (simulating)
+				ImGui::TextDisabled("%u combinational loops", simulation.getLoopCount());
+
+			ImGui::Separator();
+
+			bool capturing = simulation.isCapturing();
+
+			if (ImGui::MenuItem("Record Waveform...", nullptr, false, simulating && !capturing))
+				recordSimulation();
+
+			if (ImGui::MenuItem("Stop Recording", nullptr, false, capturing))
+				simulation.stopCapture();
+
+			if (capturing)
+				ImGui::TextDisabled("%.1f MB written", simulation.getCaptureBytes() / (1024.f * 1024.f));
+
+			ImGui::Separator();
+
+			if (ImGui::BeginMenu("Breakpoints", simulating)) {
+				bool has_nets = !getSelectedNets().empty();
+
+				if (ImGui::MenuItem("Break on Rising Edge", nullptr, false, has_nets))
+					addBreakpoint(Breakpoints::Rising);
+
+				if (ImGui::MenuItem("Break on Falling Edge", nullptr, false, has_nets))
+					addBreakpoint(Breakpoints::Falling);
+
+				if (ImGui::MenuItem("Break on Unknown", nullptr, false, has_nets))
+					addBreakpoint(Breakpoints::Unknown);
+
+				ImGui::Separator();
+
+				ImGui::SetNextItemWidth(150);
+				ImGui::InputText("Bus Value", &breakpoint_value);
+
+				if (ImGui::MenuItem("Break on Equal", nullptr, false, has_nets))
+					addBreakpoint(Breakpoints::Equals);
+
+				if (ImGui::MenuItem("Break on Not Equal", nullptr, false, has_nets))
+					addBreakpoint(Breakpoints::NotEquals);
+
+				ImGui::Separator();
+
+				if (ImGui::MenuItem("Clear Breakpoints", nullptr, false, simulation.getBreakpointCount() != 0))
+					simulation.clearBreakpoints();
+
+				ImGui::TextDisabled("%zu breakpoints", simulation.getBreakpointCount());
+
+				ImGui::EndMenu();
+			}
+
+			ImGui::Separator();
+
+			bool profiling = simulation.isProfiling();
+			if (ImGui::MenuItem("Activity Heatmap", nullptr, &profiling))
+				simulation.setProfiling(profiling);
+
+			if (ImGui::MenuItem("Reset Activity", nullptr, false, simulating && profiling))
+				simulation.resetActivity();
+
+			ImGui::Separator();
+
+			int thread_count = simulation.getThreadCount();
+			ImGui::SetNextItemWidth(150);
+			if (ImGui::SliderInt("Threads", &thread_count, 1, std::max(std::thread::hardware_concurrency(), 1u))) {
+				simulation.setThreadCount(thread_count);
+
+				if (simulating)
+					restartSimulation();
+			}
+
+			ImGui::Separator();
+
+			if (ImGui::MenuItem("Scaling Benchmark", nullptr, false, has_ws))
+				runScalingBenchmark(*curr_window_sheet->sheet);
+
 			ImGui::EndMenu();
 		}
 		if (ImGui::BeginMenu("Tools")) {
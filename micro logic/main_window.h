@@ -7,6 +7,8 @@
 #include "window/window_history.h"
 #include "window/window_explorer.h"
 #include "side_menu.h"
+#include "simulation/simulation_thread.h"
+#include "simulation/simulation_benchmark.h"
 #include <vk2d/system/window.h>
 #include <vk2d/graphics/texture.h>
 #include <vk2d/system/font.h>
@@ -14,6 +16,7 @@
 
 #define DEFAULT_FONT_IDX 0
 #define TEXTURE_IDX_ICONS 0
+#define SIMULATION_RESTART_DELAY 250 // ms a simulated sheet stays unedited before the simulation goes on with it
 
 class MainWindow : public ResizingLoop {
 private:
@@ -89,6 +92,19 @@ public:
 
 	void beginClipboardPaste();
 
+	bool createLogicUnit(SchematicSheet& sheet);
+	bool createLogicUnit(SchematicSheet& sheet, std::vector<LogicUnit>& units, std::vector<std::string>& sources);
+
+	void startSimulation(SchematicSheet& sheet);
+	void restartSimulation();
+	void syncSimulation();
+	void stopSimulation();
+	void updateSimulation();
+	void recordSimulation();
+	void addBreakpoint(Breakpoints::Condition condition);
+	std::vector<net_id_t> getSelectedNets() const;
+	void runScalingBenchmark(SchematicSheet& sheet);
+
 public:
 	void showMainMenus();
 	void showUpperMenus();
@@ -135,6 +151,8 @@ public:
 	std::vector<SideMenuPtr_t> side_menus;
 	std::vector<LogicGate>     logic_gates;
 	std::vector<LogicUnit>     logic_units;
+	std::vector<std::string>   unit_sources; // guid of the sheet each unit was created from
+	std::vector<std::string>   load_errors;
 
 	std::string status_message;
 	std::string info_message;
@@ -156,6 +174,15 @@ public: // project
 	
 	bool project_opened;
 
+public: // simulation
+	SimulationThread simulation;
+	SchematicSheet*  simulated_sheet;
+	uint64_t         simulated_revision; // of the netlist, an edit waits for the restart delay from here
+	timepoint_t      simulated_edit_time;
+	bool             oscillation_reported;
+	uint32_t         breakpoint_reported;
+	std::string      breakpoint_value;
+
 public: // windows
 	Window_Library  window_library;
 	Window_History  window_history;
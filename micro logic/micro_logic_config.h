@@ -14,6 +14,8 @@
 #define PROJECT_EXT_NAME "mlp"
 #define SCHEMATIC_SHEET_EXT ".mls"
 #define SCHEMATIC_SHEET_EXT_NAME "mls"
+#define WAVEFORM_EXT ".vcd"
+#define WAVEFORM_EXT_NAME "vcd"
 
 #define GUID_STRING_SIZE 38
 #define CLIPBOARD_COPY_IDENTIFICATION "[A8ECDC3F-A527-45BB-8AEC-9D19EC0BA190]"
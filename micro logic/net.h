@@ -1,5 +1,20 @@
 #pragma once
 
+#include <cstdint>
+
+using net_id_t = uint32_t;
+
+#define INVALID_NET_ID UINT32_MAX
+
 class Net {
+public:
+	Net() :
+		id(INVALID_NET_ID)
+	{}
+
+	Net(net_id_t id) :
+		id(id)
+	{}
 
+	net_id_t id;
 };
\ No newline at end of file
@@ -0,0 +1,895 @@
+#include "netlist.h"
+
+#include "util/union_find.h"
+#include <algorithm>
+
+struct NetlistPoint {
+	uint64_t key;
+	uint32_t node;
+};
+
+struct NetlistBusPoint {
+	uint64_t key;
+	uint32_t bit;
+	uint32_t node;
+};
+
+struct NetlistSpan {
+	int32_t  line;
+	int32_t  begin;
+	int32_t  end;
+	uint32_t wire;
+};
+
+static inline ivec2 point_coord(const vec2& p) {
+	return {
+		(int32_t)std::lround(p.x * NETLIST_POINT_SCALE),
+		(int32_t)std::lround(p.y * NETLIST_POINT_SCALE)
+	};
+}
+
+static inline uint64_t point_key(const vec2& p) {
+	auto coord = point_coord(p);
+	return ((uint64_t)(uint32_t)coord.x << 32) | (uint32_t)coord.y;
+}
+
+static inline bool on_segment(const vec2& p, const vec2& a, const vec2& b) {
+	auto ab = b - a;
+	auto ap = p - a;
+
+	if (std::abs(ab.x * ap.y - ab.y * ap.x) > 1e-4f) return false;
+
+	auto t = ab.x * ap.x + ab.y * ap.y;
+	return 0.f <= t && t <= ab.x * ab.x + ab.y * ab.y;
+}
+
+static inline vec2 pin_position(const LogicElement& elem, const PinLayout& layout) {
+	return rotate_vector(layout.pos, elem.dir) + elem.pos;
+}
+
+Net*& Netlist::Node::net() const
+{
+	if (pin == UINT32_MAX)
+		return static_cast<WireElement*>(elem)->net;
+
+	switch (elem->getType()) {
+	case CircuitElement::Net:
+		return static_cast<Bus*>(elem)->nets[pin];
+	case CircuitElement::Splitter:
+		return static_cast<Splitter*>(elem)->pins[pin].net;
+	default:
+		return static_cast<LogicElement*>(elem)->pins[pin].net;
+	}
+}
+
+const void* Netlist::Node::key() const
+{
+	if (pin == UINT32_MAX)
+		return elem;
+	else
+		return &net();
+}
+
+Netlist::Netlist() :
+	bvh(nullptr),
+	excluded(nullptr),
+	revision(0),
+	valid(false),
+	flat(false)
+{}
+
+void Netlist::build(BVH_t& bvh)
+{
+	clear();
+
+	this->bvh = &bvh;
+
+	std::vector<WireElement*> wires;
+	std::vector<Splitter*>    splitters;
+
+	for (auto& [aabb, elem_ptr] : bvh) {
+		switch (elem_ptr->getType()) {
+		case CircuitElement::LogicGate:
+		case CircuitElement::LogicUnit:
+			elements.emplace_back(static_cast<LogicElement*>(elem_ptr.get()));
+			break;
+		case CircuitElement::Wire:
+			wires.emplace_back(static_cast<WireElement*>(elem_ptr.get()));
+			break;
+		case CircuitElement::Net:
+			buses.emplace_back(static_cast<Bus*>(elem_ptr.get()));
+			break;
+		case CircuitElement::Splitter:
+			splitters.emplace_back(static_cast<Splitter*>(elem_ptr.get()));
+			break;
+		default:
+			break;
+		}
+	}
+
+	// wire i is node i, pins follow in element order, then the bits of buses and splitters.
+	// every list keeps the order of the bvh, which only depends on the file and the edits,
+	// so a sheet gets the same net ids on every run. wires and buses met in the bvh are
+	// looked up by address in sorted copies
+	using ElementIndex = std::pair<const CircuitElement*, uint32_t>;
+
+	std::vector<ElementIndex> wire_indices;
+	std::vector<ElementIndex> bus_indices;
+
+	for (uint32_t i = 0; i < wires.size(); ++i)
+		wire_indices.emplace_back(wires[i], i);
+
+	for (uint32_t i = 0; i < buses.size(); ++i)
+		bus_indices.emplace_back(buses[i], i);
+
+	std::sort(wire_indices.begin(), wire_indices.end());
+	std::sort(bus_indices.begin(), bus_indices.end());
+
+	auto index_of = [](const std::vector<ElementIndex>& indices, const CircuitElement* elem) {
+		return std::lower_bound(indices.begin(), indices.end(), ElementIndex(elem, 0))->second;
+	};
+
+	auto wire_count = (uint32_t)wires.size();
+	auto node_count = wire_count;
+
+	for (auto* elem : elements)
+		node_count += (uint32_t)elem->pins.size();
+
+	auto pin_count = node_count - wire_count;
+
+	std::vector<uint32_t> bus_nodes; // first node of each bus
+
+	for (auto* bus : buses) {
+		bus_nodes.emplace_back(node_count);
+		node_count += bus->width;
+	}
+
+	auto splitter_node = node_count;
+
+	for (auto* splitter : splitters)
+		node_count += splitter->width;
+
+	auto splitter_bits = node_count - splitter_node;
+
+	std::vector<NetlistPoint> points;
+	points.reserve(2 * (size_t)wire_count + pin_count + splitter_bits);
+	pin_points.reserve(pin_count + splitter_bits);
+	tap_points.reserve(splitter_bits);
+
+	for (uint32_t i = 0; i < wire_count; ++i) {
+		points.push_back({ point_key(wires[i]->p0), i });
+		points.push_back({ point_key(wires[i]->p1), i });
+	}
+
+	auto node = wire_count;
+
+	for (auto* elem : elements) {
+		for (const auto& layout : elem->shared->pin_layouts) {
+			auto key = point_key(pin_position(*elem, layout));
+
+			points.push_back({ key, node + layout.pinout - 1 });
+			pin_points.emplace(key, Node{ elem, layout.pinout - 1u });
+		}
+
+		node += (uint32_t)elem->pins.size();
+	}
+
+	// the bit side of a splitter connects like a pin, buses and the bus side of splitters
+	// only connect bit n to bit n
+	std::vector<NetlistBusPoint> bus_points;
+	bus_points.reserve(2 * (size_t)(splitter_node - wire_count - pin_count) + splitter_bits);
+
+	for (uint32_t i = 0; i < buses.size(); ++i) {
+		for (uint32_t bit = 0; bit < buses[i]->width; ++bit) {
+			bus_points.push_back({ point_key(buses[i]->p0), bit, bus_nodes[i] + bit });
+			bus_points.push_back({ point_key(buses[i]->p1), bit, bus_nodes[i] + bit });
+		}
+	}
+
+	node = splitter_node;
+
+	for (auto* splitter : splitters) {
+		auto key = point_key(splitter->pos);
+
+		for (uint32_t bit = 0; bit < splitter->width; ++bit) {
+			auto bit_key = point_key(splitter->getBitPosition(bit));
+
+			points.push_back({ bit_key, node + bit });
+			pin_points.emplace(bit_key, Node{ splitter, bit });
+			bus_points.push_back({ key, bit, node + bit });
+			tap_points.emplace(key, Node{ splitter, bit });
+		}
+
+		node += splitter->width;
+	}
+
+	std::sort(points.begin(), points.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.key < rhs.key;
+	});
+
+	std::sort(bus_points.begin(), bus_points.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.key != rhs.key ? lhs.key < rhs.key : lhs.bit < rhs.bit;
+	});
+
+	UnionFind uf(node_count);
+
+	for (size_t i = 1; i < points.size(); ++i)
+		if (points[i - 1].key == points[i].key)
+			uf.unite(points[i - 1].node, points[i].node);
+
+	for (size_t i = 1; i < bus_points.size(); ++i)
+		if (bus_points[i - 1].key == bus_points[i].key && bus_points[i - 1].bit == bus_points[i].bit)
+			uf.unite(bus_points[i - 1].node, bus_points[i].node);
+
+	// a dotted endpoint also connects to any wire passing through it. axis aligned wires
+	// are found by binary search over (line, start) sorted spans, others through the bvh
+	std::vector<NetlistSpan> spans[2];
+
+	for (uint32_t i = 0; i < wire_count; ++i) {
+		auto p0 = point_coord(wires[i]->p0);
+		auto p1 = point_coord(wires[i]->p1);
+
+		if (p0.y == p1.y)
+			spans[0].push_back({ p0.y, std::min(p0.x, p1.x), std::max(p0.x, p1.x), i });
+		else if (p0.x == p1.x)
+			spans[1].push_back({ p0.x, std::min(p0.y, p1.y), std::max(p0.y, p1.y), i });
+	}
+
+	for (auto& list : spans) {
+		std::sort(list.begin(), list.end(), [](const auto& lhs, const auto& rhs) {
+			return lhs.line != rhs.line ? lhs.line < rhs.line : lhs.begin < rhs.begin;
+		});
+	}
+
+	auto unite_span = [&](const std::vector<NetlistSpan>& list, int32_t line, int32_t pos, uint32_t wire) {
+		auto iter = std::upper_bound(list.begin(), list.end(), std::make_pair(line, pos), [](const auto& value, const auto& span) {
+			return value.first != span.line ? value.first < span.line : value.second < span.begin;
+		});
+
+		for (; iter != list.begin(); ) {
+			--iter;
+
+			if (iter->line != line || iter->end < pos) break;
+
+			uf.unite(wire, iter->wire);
+		}
+	};
+
+	for (uint32_t i = 0; i < wire_count; ++i) {
+		auto& wire = *wires[i];
+
+		for (int end = 0; end < 2; ++end) {
+			if (!(end ? wire.dot1 : wire.dot0)) continue;
+
+			auto pos   = end ? wire.p1 : wire.p0;
+			auto coord = point_coord(pos);
+
+			unite_span(spans[0], coord.y, coord.x, i);
+			unite_span(spans[1], coord.x, coord.y, i);
+
+			if (spans[0].size() + spans[1].size() == wire_count) continue;
+
+			bvh.query(pos, [&](BVH_t::iterator iter) {
+				auto& elem = *iter->second;
+
+				if (elem.getType() != CircuitElement::Wire || &elem == &wire) BVH_CONTINUE;
+
+				auto& other = static_cast<WireElement&>(elem);
+
+				if (on_segment(pos, other.p0, other.p1)) {
+					uf.unite(i, index_of(wire_indices, &other));
+				}
+
+				BVH_CONTINUE;
+			});
+		}
+	}
+
+	// buses are few, their dotted endpoints go through the bvh
+	for (uint32_t i = 0; i < buses.size(); ++i) {
+		auto& bus = *buses[i];
+
+		for (int end = 0; end < 2; ++end) {
+			if (!(end ? bus.dot1 : bus.dot0)) continue;
+
+			auto pos = end ? bus.p1 : bus.p0;
+
+			bvh.query(pos, [&](BVH_t::iterator iter) {
+				auto& elem = *iter->second;
+
+				if (elem.getType() != CircuitElement::Net || &elem == &bus) BVH_CONTINUE;
+
+				auto& other = static_cast<Bus&>(elem);
+
+				if (on_segment(pos, other.p0, other.p1)) {
+					auto other_idx = index_of(bus_indices, &other);
+
+					for (uint32_t bit = 0; bit < std::min(bus.width, other.width); ++bit)
+						uf.unite(bus_nodes[i] + bit, bus_nodes[other_idx] + bit);
+				}
+
+				BVH_CONTINUE;
+			});
+		}
+	}
+
+	std::vector<net_id_t> root_nets(node_count, INVALID_NET_ID);
+	std::vector<net_id_t> node_nets(node_count);
+
+	for (uint32_t i = 0; i < node_count; ++i) {
+		auto& id = root_nets[uf.find(i)];
+
+		if (id == INVALID_NET_ID) {
+			id = (net_id_t)nets.size();
+			nets.emplace_back(id);
+			net_sizes.emplace_back(0);
+		}
+
+		node_nets[i] = id;
+		++net_sizes[id];
+	}
+
+	for (uint32_t i = 0; i < wire_count; ++i)
+		wires[i]->net = &nets[node_nets[i]];
+
+	node = wire_count;
+
+	for (auto* elem : elements)
+		for (auto& pin : elem->pins)
+			pin.net = &nets[node_nets[node++]];
+
+	for (auto* bus : buses)
+		for (auto& net : bus->nets)
+			net = &nets[node_nets[node++]];
+
+	for (auto* splitter : splitters)
+		for (auto& pin : splitter->pins)
+			pin.net = &nets[node_nets[node++]];
+
+	flattenPins();
+
+	valid = true;
+}
+
+void Netlist::clear()
+{
+	nets.clear();
+	net_sizes.clear();
+	pin_offsets.clear();
+	net_pins.clear();
+	elements.clear();
+	buses.clear();
+	pin_points.clear();
+	tap_points.clear();
+	free_ids.clear();
+
+	valid = false;
+	flat  = false;
+}
+
+void Netlist::flatten()
+{
+	assert(valid);
+
+	elements.clear();
+	buses.clear();
+
+	for (auto& [aabb, elem_ptr] : *bvh) {
+		auto type = elem_ptr->getType();
+
+		if (type == CircuitElement::LogicGate || type == CircuitElement::LogicUnit)
+			elements.emplace_back(static_cast<LogicElement*>(elem_ptr.get()));
+		else if (type == CircuitElement::Net)
+			buses.emplace_back(static_cast<Bus*>(elem_ptr.get()));
+	}
+
+	flattenPins();
+}
+
+bool Netlist::isValid() const
+{
+	return valid;
+}
+
+bool Netlist::isFlat() const
+{
+	return flat;
+}
+
+uint64_t Netlist::getRevision() const
+{
+	return revision;
+}
+
+void Netlist::insert(CircuitElement& elem)
+{
+	++revision;
+
+	if (!valid) return;
+
+	flat = false;
+
+	std::vector<Node> nodes;
+
+	addNodes(elem, nodes);
+	connectNodes(nodes);
+}
+
+void Netlist::insert(const std::vector<BVH_t::iterator>& iters)
+{
+	++revision;
+
+	if (!valid) return;
+
+	flat = false;
+
+	std::vector<Node> nodes;
+
+	// copies still hold the nets of their originals, every new node is cleared before
+	// any of them looks for neighbors
+	for (auto iter : iters)
+		addNodes(*iter->second, nodes);
+
+	connectNodes(nodes);
+}
+
+void Netlist::addNodes(CircuitElement& elem, std::vector<Node>& nodes)
+{
+	switch (elem.getType()) {
+	case CircuitElement::LogicGate:
+	case CircuitElement::LogicUnit: {
+		auto& logic = static_cast<LogicElement&>(elem);
+
+		for (const auto& layout : logic.shared->pin_layouts) {
+			Node node{ &elem, layout.pinout - 1u };
+
+			node.net() = nullptr;
+			nodes.emplace_back(node);
+			pin_points.emplace(point_key(pin_position(logic, layout)), node);
+		}
+	} break;
+	case CircuitElement::Wire:
+		nodes.push_back({ &elem, UINT32_MAX });
+		nodes.back().net() = nullptr;
+		break;
+	case CircuitElement::Net: {
+		auto& bus = static_cast<Bus&>(elem);
+
+		for (uint32_t bit = 0; bit < bus.width; ++bit) {
+			nodes.push_back({ &elem, bit });
+			nodes.back().net() = nullptr;
+		}
+	} break;
+	case CircuitElement::Splitter: {
+		auto& splitter = static_cast<Splitter&>(elem);
+
+		for (uint32_t bit = 0; bit < splitter.width; ++bit) {
+			Node node{ &elem, bit };
+
+			node.net() = nullptr;
+			nodes.emplace_back(node);
+			pin_points.emplace(point_key(splitter.getBitPosition(bit)), node);
+			tap_points.emplace(point_key(splitter.pos), node);
+		}
+	} break;
+	default:
+		break;
+	}
+}
+
+void Netlist::connectNodes(const std::vector<Node>& nodes)
+{
+	std::vector<Node> neighbors;
+
+	for (const auto& node : nodes) {
+		neighbors.clear();
+		getNeighbors(node, neighbors);
+
+		Net* target = nullptr;
+
+		for (const auto& neighbor : neighbors) {
+			auto* net = neighbor.net();
+
+			if (net && (!target || net_sizes[net->id] > net_sizes[target->id]))
+				target = net;
+		}
+
+		if (!target) target = allocNet();
+
+		node.net() = target;
+		++net_sizes[target->id];
+
+		for (const auto& neighbor : neighbors)
+			if (neighbor.net() && neighbor.net() != target)
+				mergeNet(neighbor, target);
+	}
+}
+
+void Netlist::erase(CircuitElement& elem)
+{
+	++revision;
+
+	if (!valid) return;
+
+	flat     = false;
+	excluded = &elem;
+
+	switch (elem.getType()) {
+	case CircuitElement::LogicGate:
+	case CircuitElement::LogicUnit: {
+		auto& logic = static_cast<LogicElement&>(elem);
+
+		// every node touching a pin also touches the others there, so removing pins never splits a net
+		for (const auto& layout : logic.shared->pin_layouts) {
+			Node node{ &elem, layout.pinout - 1u };
+
+			auto [first, last] = pin_points.equal_range(point_key(pin_position(logic, layout)));
+
+			for (; first != last; ++first) {
+				if (first->second.key() == node.key()) {
+					pin_points.erase(first);
+					break;
+				}
+			}
+
+			auto* net = std::exchange(node.net(), nullptr);
+
+			if (net && --net_sizes[net->id] == 0)
+				freeNet(net);
+		}
+	} break;
+	case CircuitElement::Wire:
+		eraseNode({ &elem, UINT32_MAX });
+		break;
+	case CircuitElement::Net: {
+		auto& bus = static_cast<Bus&>(elem);
+
+		for (uint32_t bit = 0; bit < bus.width; ++bit)
+			eraseNode({ &elem, bit });
+	} break;
+	case CircuitElement::Splitter: {
+		auto& splitter = static_cast<Splitter&>(elem);
+
+		auto erase_point = [](std::unordered_multimap<uint64_t, Node>& points, uint64_t key, const Node& node) {
+			auto [first, last] = points.equal_range(key);
+
+			for (; first != last; ++first) {
+				if (first->second.key() == node.key()) {
+					points.erase(first);
+					break;
+				}
+			}
+		};
+
+		// a splitter bridges the bus to the wires at its bits, so unlike pins it can split a net
+		for (uint32_t bit = 0; bit < splitter.width; ++bit) {
+			Node node{ &elem, bit };
+
+			erase_point(pin_points, point_key(splitter.getBitPosition(bit)), node);
+			erase_point(tap_points, point_key(splitter.pos), node);
+			eraseNode(node);
+		}
+	} break;
+	default:
+		break;
+	}
+
+	excluded = nullptr;
+}
+
+size_t Netlist::getNetCount() const
+{
+	return nets.size();
+}
+
+const Netlist::PinRef* Netlist::pinsBegin(net_id_t net) const
+{
+	return net_pins.data() + pin_offsets[net];
+}
+
+const Netlist::PinRef* Netlist::pinsEnd(net_id_t net) const
+{
+	return net_pins.data() + pin_offsets[net + 1];
+}
+
+void Netlist::flattenPins()
+{
+	pin_offsets.assign(nets.size() + 1, 0);
+
+	for (auto* elem : elements)
+		for (auto& pin : elem->pins)
+			++pin_offsets[pin.net->id + 1];
+
+	for (size_t i = 0; i < nets.size(); ++i)
+		pin_offsets[i + 1] += pin_offsets[i];
+
+	net_pins.resize(pin_offsets.back());
+
+	std::vector<uint32_t> cursor(pin_offsets.begin(), pin_offsets.end() - 1);
+
+	for (auto* elem : elements)
+		for (uint32_t pin = 0; pin < elem->pins.size(); ++pin)
+			net_pins[cursor[elem->pins[pin].net->id]++] = { elem, pin };
+
+	flat = true;
+}
+
+Net* Netlist::allocNet()
+{
+	if (free_ids.empty()) {
+		auto id = (net_id_t)nets.size();
+
+		net_sizes.emplace_back(0);
+		return &nets.emplace_back(id);
+	}
+
+	auto id = free_ids.back();
+	free_ids.pop_back();
+
+	net_sizes[id] = 0;
+	return &nets[id];
+}
+
+void Netlist::freeNet(Net* net)
+{
+	net_sizes[net->id] = 0;
+	free_ids.emplace_back(net->id);
+}
+
+void Netlist::getNeighbors(const Node& node, std::vector<Node>& neighbors)
+{
+	auto add_point = [&](const vec2& pos, bool dotted) {
+		auto key = point_key(pos);
+
+		auto [first, last] = pin_points.equal_range(key);
+
+		for (; first != last; ++first)
+			if (first->second.elem != excluded && first->second.key() != node.key())
+				neighbors.emplace_back(first->second);
+
+		bvh->query(pos, [&](BVH_t::iterator iter) {
+			auto* elem = iter->second.get();
+
+			if (elem == excluded || elem == node.elem || elem->getType() != CircuitElement::Wire) BVH_CONTINUE;
+
+			auto& wire = static_cast<WireElement&>(*elem);
+
+			if (point_key(wire.p0) == key || point_key(wire.p1) == key || (dotted && on_segment(pos, wire.p0, wire.p1)))
+				neighbors.push_back({ elem, UINT32_MAX });
+
+			BVH_CONTINUE;
+		});
+	};
+
+	// same bit of the splitters and buses ending at pos
+	auto add_bus_point = [&](const vec2& pos, bool dotted) {
+		auto key = point_key(pos);
+
+		auto [first, last] = tap_points.equal_range(key);
+
+		for (; first != last; ++first)
+			if (first->second.pin == node.pin && first->second.elem != excluded && first->second.key() != node.key())
+				neighbors.emplace_back(first->second);
+
+		bvh->query(pos, [&](BVH_t::iterator iter) {
+			auto* elem = iter->second.get();
+
+			if (elem == excluded || elem == node.elem || elem->getType() != CircuitElement::Net) BVH_CONTINUE;
+
+			auto& bus = static_cast<Bus&>(*elem);
+
+			if (node.pin >= bus.width) BVH_CONTINUE;
+
+			if (point_key(bus.p0) == key || point_key(bus.p1) == key || (dotted && on_segment(pos, bus.p0, bus.p1)))
+				neighbors.push_back({ elem, node.pin });
+
+			BVH_CONTINUE;
+		});
+	};
+
+	if (node.pin != UINT32_MAX) {
+		switch (node.elem->getType()) {
+		case CircuitElement::Net: {
+			auto& bus = static_cast<Bus&>(*node.elem);
+
+			add_bus_point(bus.p0, bus.dot0);
+			add_bus_point(bus.p1, bus.dot1);
+
+			bvh->query((Rect)bus.getAABB(), [&](BVH_t::iterator iter) {
+				auto* elem = iter->second.get();
+
+				if (elem == excluded || elem == node.elem || elem->getType() != CircuitElement::Net) BVH_CONTINUE;
+
+				auto& other = static_cast<Bus&>(*elem);
+
+				if (node.pin < other.width &&
+					((other.dot0 && on_segment(other.p0, bus.p0, bus.p1)) || (other.dot1 && on_segment(other.p1, bus.p0, bus.p1))))
+					neighbors.push_back({ elem, node.pin });
+
+				BVH_CONTINUE;
+			});
+		} break;
+		case CircuitElement::Splitter: {
+			auto& splitter = static_cast<Splitter&>(*node.elem);
+
+			add_point(splitter.getBitPosition(node.pin), false);
+			add_bus_point(splitter.pos, false);
+		} break;
+		default: {
+			auto& logic = static_cast<LogicElement&>(*node.elem);
+
+			for (const auto& layout : logic.shared->pin_layouts)
+				if (layout.pinout - 1u == node.pin)
+					add_point(pin_position(logic, layout), false);
+		} break;
+		}
+
+		return;
+	}
+
+	auto& wire = static_cast<WireElement&>(*node.elem);
+
+	add_point(wire.p0, wire.dot0);
+	add_point(wire.p1, wire.dot1);
+
+	// dotted endpoints of other wires landing on this one
+	bvh->query((Rect)wire.getAABB(), [&](BVH_t::iterator iter) {
+		auto* elem = iter->second.get();
+
+		if (elem == excluded || elem == node.elem || elem->getType() != CircuitElement::Wire) BVH_CONTINUE;
+
+		auto& other = static_cast<WireElement&>(*elem);
+
+		if ((other.dot0 && on_segment(other.p0, wire.p0, wire.p1)) || (other.dot1 && on_segment(other.p1, wire.p0, wire.p1)))
+			neighbors.push_back({ elem, UINT32_MAX });
+
+		BVH_CONTINUE;
+	});
+}
+
+// takes node out of its net, which may fall apart into the pieces its neighbors are left in
+void Netlist::eraseNode(const Node& node)
+{
+	auto* net = std::exchange(node.net(), nullptr);
+
+	if (!net) return;
+
+	if (--net_sizes[net->id] == 0) {
+		freeNet(net);
+		return;
+	}
+
+	std::vector<Node> neighbors;
+	getNeighbors(node, neighbors);
+
+	neighbors.erase(std::remove_if(neighbors.begin(), neighbors.end(), [&](const Node& neighbor) {
+		return neighbor.net() != net;
+	}), neighbors.end());
+
+	if (neighbors.size() > 1)
+		splitNet(net, neighbors);
+}
+
+void Netlist::mergeNet(const Node& from, Net* into)
+{
+	auto* old = from.net();
+
+	std::vector<Node> stack{ from };
+	std::vector<Node> neighbors;
+
+	from.net() = into;
+
+	while (!stack.empty()) {
+		auto node = stack.back();
+		stack.pop_back();
+
+		neighbors.clear();
+		getNeighbors(node, neighbors);
+
+		for (const auto& neighbor : neighbors) {
+			if (neighbor.net() != old) continue;
+
+			neighbor.net() = into;
+			stack.emplace_back(neighbor);
+		}
+	}
+
+	net_sizes[into->id] += net_sizes[old->id];
+	freeNet(old);
+}
+
+void Netlist::splitNet(Net* net, const std::vector<Node>& roots)
+{
+	// one breadth first search per root, advanced in lockstep. searches that meet are united,
+	// and once at most one is still running the finished ones are the pieces split off.
+	// the cost is bounded by the smaller pieces instead of the whole net
+	auto root_count = (uint32_t)roots.size();
+
+	UnionFind groups(root_count);
+
+	std::unordered_map<const void*, uint32_t> visited;
+	std::vector<Node>                         nodes;
+	std::vector<uint32_t>                     node_groups;
+	std::vector<std::vector<uint32_t>>        queues(root_count);
+	std::vector<size_t>                       heads(root_count, 0);
+	std::vector<Node>                         neighbors;
+
+	auto visit = [&](const Node& node, uint32_t group) {
+		auto [iter, inserted] = visited.emplace(node.key(), (uint32_t)nodes.size());
+
+		if (inserted) {
+			nodes.emplace_back(node);
+			node_groups.emplace_back(group);
+			queues[group].emplace_back(iter->second);
+		} else {
+			groups.unite(group, node_groups[iter->second]);
+		}
+	};
+
+	for (uint32_t i = 0; i < root_count; ++i)
+		visit(roots[i], i);
+
+	std::vector<uint8_t> running(root_count);
+
+	while (true) {
+		uint32_t running_count = 0;
+
+		std::fill(running.begin(), running.end(), 0);
+
+		for (uint32_t i = 0; i < root_count; ++i) {
+			if (heads[i] == queues[i].size()) continue;
+
+			auto root = groups.find(i);
+
+			if (!running[root]) {
+				running[root] = true;
+				++running_count;
+			}
+		}
+
+		if (running_count <= 1) break;
+
+		for (uint32_t i = 0; i < root_count; ++i) {
+			if (heads[i] == queues[i].size()) continue;
+
+			auto node = nodes[queues[i][heads[i]++]];
+
+			neighbors.clear();
+			getNeighbors(node, neighbors);
+
+			for (const auto& neighbor : neighbors)
+				if (neighbor.net() == net)
+					visit(neighbor, i);
+		}
+	}
+
+	std::vector<uint32_t> sizes(root_count, 0);
+
+	for (auto group : node_groups)
+		++sizes[groups.find(group)];
+
+	// the running search, or else the largest piece, keeps the net
+	uint32_t keep = UINT32_MAX;
+
+	for (uint32_t i = 0; i < root_count; ++i)
+		if (running[i]) keep = i;
+
+	if (keep == UINT32_MAX)
+		keep = (uint32_t)(std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
+
+	std::vector<Net*> split_nets(root_count, nullptr);
+
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		auto root = groups.find(node_groups[i]);
+
+		if (root == keep) continue;
+
+		auto*& split_net = split_nets[root];
+
+		if (!split_net) split_net = allocNet();
+
+		nodes[i].net() = split_net;
+		++net_sizes[split_net->id];
+		--net_sizes[net->id];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "circuit_element.h"
+#include <deque>
+#include <unordered_map>
+
+#define NETLIST_POINT_SCALE 16.f
+
+class Netlist {
+public:
+	using BVH_t = BVH<std::unique_ptr<CircuitElement>>;
+
+	struct PinRef {
+		LogicElement* elem;
+		uint32_t      pin; // index of LogicElement::pins
+	};
+
+	Netlist();
+
+	void build(BVH_t& bvh); // net ids only depend on the loaded sheet, the same on every run
+	void clear();
+	void flatten();
+	bool isValid() const;
+	bool isFlat() const;
+	uint64_t getRevision() const; // counts the inserts and erases, for telling edits apart
+
+	// elem must be in the bvh on insert, erase also works after it has been taken out
+	void insert(CircuitElement& elem);
+	void insert(const std::vector<BVH_t::iterator>& iters); // elements put in the bvh together
+	void erase(CircuitElement& elem);
+
+	size_t getNetCount() const;
+	const PinRef* pinsBegin(net_id_t net) const;
+	const PinRef* pinsEnd(net_id_t net) const;
+
+public:
+	std::deque<Net>            nets;        // nets[id].id == id, freed ids are reused
+	std::vector<uint32_t>      net_sizes;   // wires and pins in each net, 0 if freed
+	std::vector<uint32_t>      pin_offsets; // CSR, pins of net n are net_pins[pin_offsets[n]..pin_offsets[n + 1]]
+	std::vector<PinRef>        net_pins;
+	std::vector<LogicElement*> elements;
+	std::vector<Bus*>          buses; // their bit nets are simulated as words
+
+private:
+	struct Node {
+		CircuitElement* elem;
+		uint32_t        pin; // UINT32_MAX for wires, the bit for buses and splitters
+
+		Net*& net() const;
+		const void* key() const;
+	};
+
+	void flattenPins();
+	Net* allocNet();
+	void freeNet(Net* net);
+	void addNodes(CircuitElement& elem, std::vector<Node>& nodes);
+	void connectNodes(const std::vector<Node>& nodes);
+	void getNeighbors(const Node& node, std::vector<Node>& neighbors);
+	void eraseNode(const Node& node);
+	void mergeNet(const Node& from, Net* into);
+	void splitNet(Net* net, const std::vector<Node>& roots);
+
+	BVH_t* bvh;
+	const CircuitElement* excluded;
+
+	std::unordered_multimap<uint64_t, Node> pin_points; // pins and the bit side of splitters
+	std::unordered_multimap<uint64_t, Node> tap_points; // bus side of splitters, one node per bit
+	std::vector<net_id_t>                   free_ids;
+
+	uint64_t revision;
+
+	bool valid;
+	bool flat;
+};
\ No newline at end of file
@@ -36,12 +36,29 @@ void SchematicSheet::unserialize(std::istream& is)
 	read_binary(is, id_counter);
 	read_binary(is, elem_count);
 
+	std::vector<std::pair<AABB, std::unique_ptr<CircuitElement>>> new_elems;
+	std::vector<bvh_iterator_t>                                   iters;
+
+	new_elems.reserve(elem_count);
+	iters.reserve(elem_count);
+
 	for (size_t i = 0; i < elem_count; ++i) {
 		auto new_elem = CircuitElement::create(is);
-		auto& elem    = *new_elem;
 
-		elem.iter = bvh.insert(elem.getAABB(), std::move(new_elem));
+		if (!new_elem) continue;
+
+		new_elems.emplace_back(new_elem->getAABB(), std::move(new_elem));
 	}
+
+	bvh.insert(
+		std::make_move_iterator(new_elems.begin()),
+		std::make_move_iterator(new_elems.end()),
+		std::back_inserter(iters));
+
+	for (auto& iter : iters)
+		iter->second->iter = iter;
+
+	netlist.build(bvh);
 }
 
 bool SchematicSheet::empty() const
@@ -49,6 +66,14 @@ bool SchematicSheet::empty() const
 	return bvh.empty();
 }
 
+void SchematicSheet::updateNetlist()
+{
+	if (!netlist.isValid())
+		netlist.build(bvh);
+	else if (!netlist.isFlat())
+		netlist.flatten();
+}
+
 void SchematicSheet::setPosition(const vec2& pos)
 {
 	position = pos;
@@ -1,7 +1,10 @@
 #pragma once
 
+#ifndef MICRO_LOGIC_HEADLESS
 #include <vk2d/graphics/render_texture.h>
+#endif
 #include "circuit_element.h"
+#include "netlist.h"
 #include "serialize.h"
 #include "bvh.hpp"
 
@@ -21,6 +24,7 @@ public:
 	void unserialize(std::istream& is) override;
 
 	bool empty() const;
+	void updateNetlist();
 
 public:
 	void setPosition(const vec2& pos);
@@ -39,7 +43,11 @@ public:
 	CMD_ONLY std::vector<bvh_iterator_t>          selections;
 	CMD_ONLY uint32_t                             id_counter;
 
+	Netlist netlist;
+
+#ifndef MICRO_LOGIC_HEADLESS
 	vk2d::Texture thumbnail;
+#endif
 
 	bool file_saved;
 	bool is_up_to_date;
@@ -3,6 +3,7 @@
 #include <ostream>
 #include <istream>
 #include <iomanip>
+#include <cstring>
 
 class Serialrizable {
 public:
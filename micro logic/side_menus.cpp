@@ -498,10 +498,16 @@ void Menu_Select::endWork()
 		cmd->origin = last_pos;
 		cmd->dir    = dir;
 
-		for (auto iter : ws.sheet->selections)
-			ws.getBVH().update_element(iter, iter->second->getAABB());
+		// the drag only moved the selection on screen, put it back so the command moves it
+		// through the netlist and the bvh
+		for (auto iter : ws.sheet->selections) {
+			auto& elem = *iter->second;
+
+			elem.transform({}, last_pos, invert_dir(dir));
+			elem.transform(start_pos - last_pos, {}, Direction::Up);
+		}
 
-		ws.pushCommand(std::move(cmd), true);
+		ws.pushCommand(std::move(cmd));
 	}
 
 	SelectingSideMenu::endWork();
@@ -646,12 +652,66 @@ void Menu_Library::upperMenu()
 }
 
 Menu_Unit::Menu_Unit() :
-	SideMenu("Unit")
+	SideMenu("Unit"),
+	curr_unit(-1),
+	curr_dir(Direction::Up)
+{}
+
+void Menu_Unit::loop()
 {
+	auto& main_window = MainWindow::get();
+
+	if (curr_unit == -1 || curr_unit >= (int32_t)main_window.logic_units.size()) return;
+
+	auto& ws = getCurrentWindowSheet();
+
+	vk2d::Cursor::setVisible(!ws.capturing_mouse);
+
+	auto pos = ws.getClampedCursorPos();
+	if (ws.capturing_mouse) {
+		pos        = ws.toPlane(pos);
+		auto& bvh  = ws.sheet->bvh;
+		auto& unit = main_window.logic_units[curr_unit];
+
+		unit.pos = pos;
+		unit.dir = curr_dir;
+
+		auto overlap = bvh.query(unit.getAABB(), [&](auto iter) {
+			return iter->second->getType() != CircuitElement::Wire;
+		});
+
+		if (overlap)
+			unit.style |= CircuitElement::Blocked;
+		else
+			unit.style &= ~CircuitElement::Blocked;
+
+		unit.draw(ws.draw_list);
+	}
 }
 
-void Menu_Unit::loop()
+void Menu_Unit::eventProc(const vk2d::Event& e, float dt)
 {
+	switch (e.type) {
+	case Event::MousePressed: {
+		auto& main_window = MainWindow::get();
+		auto& ws = getCurrentWindowSheet();
+
+		if (e.mouseButton.button == Mouse::Left && ws.capturing_mouse) {
+			if (curr_unit == -1 || curr_unit >= (int32_t)main_window.logic_units.size()) return;
+
+			auto& unit = main_window.logic_units[curr_unit];
+
+			if (unit.style & CircuitElement::Style::Blocked) return;
+
+			auto cmd = std::make_unique<Command_Add>();
+			cmd->elements.emplace_back(unit.clone());
+
+			ws.pushCommand(std::move(cmd));
+		} else if (e.mouseButton.button == Mouse::Right) {
+			curr_dir = rotate_cw(curr_dir);
+		}
+	}	break;
+	}
 }
 
 void Menu_Unit::menuButton()
@@ -660,6 +720,44 @@ void Menu_Unit::menuButton()
 	SideMenu::menuButtonImpl(ICON_MICROCHIP, { 40, 40 });
 }
 
+void Menu_Unit::upperMenu()
+{
+	auto& main_window = MainWindow::get();
+	auto& units       = main_window.logic_units;
+
+	if (curr_unit >= (int32_t)units.size())
+		curr_unit = -1;
+
+	// the unit is compiled from the sheet as it is now, later edits need a new unit
+	if (ImGui::Button("Create from Sheet") && main_window.curr_window_sheet) {
+		if (main_window.createLogicUnit(*main_window.curr_window_sheet->sheet))
+			curr_unit = (int32_t)units.size() - 1;
+	}
+
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(200);
+	if (ImGui::BeginCombo("##Units", curr_unit == -1 ? "" : units[curr_unit].shared->name.c_str())) {
+		for (int32_t i = 0; i < (int32_t)units.size(); ++i) {
+			ImGui::PushID(i);
+			if (ImGui::Selectable(units[i].shared->name.c_str(), i == curr_unit))
+				curr_unit = i;
+			ImGui::PopID();
+		}
+
+		ImGui::EndCombo();
+	}
+
+	ImGui::SameLine();
+	if (ImGui::ImageButton(ICON_ROTATE_CW, { 35, 35 })) {
+		curr_dir = rotate_cw(curr_dir);
+	}
+
+	ImGui::SameLine();
+	if (ImGui::ImageButton(ICON_ROTATE_CCW, { 35, 35 })) {
+		curr_dir = rotate_ccw(curr_dir);
+	}
+}
+
 Menu_Shapes::Menu_Shapes() :
 	SideMenu("Shapes")
 {
@@ -1168,9 +1266,11 @@ bool WiringSideMenu::checkContinueWiring(const vec2& pos) const
 
 		switch (elem->getType()) {
 		case CircuitElement::Wire:
+		case CircuitElement::Net:
 			BVH_BREAK;
 		case CircuitElement::LogicGate:
 		case CircuitElement::LogicUnit:
+		case CircuitElement::Splitter:
 			if (auto* pin = elem->getPin(pos))
 				BVH_BREAK;
 			break;
@@ -1182,6 +1282,85 @@ bool WiringSideMenu::checkContinueWiring(const vec2& pos) const
 	return !result;
 }
 
+// adds the wires, or buses, of stack as one command. the parts that overlap an element of
+// the same type are cut off
+template <class WireType>
+void WiringSideMenu::addWires(std::vector<WireType>&& stack)
+{
+	auto& ws = getCurrentWindowSheet();
+	auto cmd = std::make_unique<Command_Add>();
+
+	while (!stack.empty()) {
+		auto wire = stack.back(); stack.pop_back();
+		auto type = wire.getType();
+
+		auto canceled = ws.sheet->bvh.query(wire.getAABB(), [&](auto iter) {
+			CircuitElement& elem = *iter->second;
+
+			if (elem.getType() != type) BVH_CONTINUE;
+
+			float t0, t1;
+			auto& item = static_cast<Wire&>(elem);
+
+			if (item.overlap(wire, t0, t1)) {
+				if (t0 == t1) BVH_CONTINUE;
+
+				auto p0 = wire.p0;
+				auto p1 = wire.p1;
+
+				if (t0 == 0.f && t1 != 1.f) {
+					wire.p0 = lerp(p0, p1, t1);
+					stack.push_back(wire);
+				} else if (t0 != 0.f && t1 == 1.f) {
+					wire.p1 = lerp(p0, p1, t0);
+					stack.push_back(wire);
+				} else if (t0 != 0.f && t1 != 1.f) {
+					wire.p1 = lerp(p0, p1, t0);
+					stack.push_back(wire);
+					wire.p0 = lerp(p0, p1, t1);
+					wire.p1 = p1;
+					stack.push_back(wire);
+				}
+				BVH_BREAK;
+			}
+
+			BVH_CONTINUE;
+		});
+
+		if (!canceled) {
+			wire.dot0 = checkWireCrossing(wire.p0, type);
+			wire.dot1 = checkWireCrossing(wire.p1, type);
+			cmd->elements.emplace_back(wire.clone());
+		}
+	}
+
+	if (!cmd->elements.empty())
+		ws.pushCommand(std::move(cmd));
+}
+
+bool WiringSideMenu::checkWireCrossing(const vec2& pos, CircuitElement::Type type) const
+{
+	auto& ws  = getCurrentWindowSheet();
+	int count = 0;
+
+	ws.sheet->bvh.query(pos, [&](auto iter) {
+		CircuitElement& elem = *iter->second;
+
+		if (elem.getType() != type) BVH_CONTINUE;
+
+		auto& wire = static_cast<Wire&>(elem);
+
+		if (wire.p0 == pos || wire.p1 == pos) 
+			++count;
+		else if (wire.hit(pos))
+			count += 2;
+
+		return count > 1;
+	});
+
+	return count > 1;
+}
+
 Menu_Wire::Menu_Wire() :
 	WiringSideMenu("Wire")
 {}
@@ -1287,85 +1466,90 @@ void Menu_Wire::upperMenu()
 	ImGui::RadioImageButton(ICON_WIRE_TYPE4, { 35, 35 }, &curr_wire_type, 4);
 }
 
-void Menu_Wire::addWires(std::vector<Wire>&& stack)
+Menu_Net::Menu_Net() :
+	WiringSideMenu("Net"),
+	bus_width(DEFAULT_BUS_WIDTH)
 {
-	auto& ws = getCurrentWindowSheet();
-	auto cmd = std::make_unique<Command_Add>();
-
-	while (!stack.empty()) {
-		auto wire = stack.back(); stack.pop_back();
+}
 
-		auto canceled = ws.sheet->bvh.query(wire.getAABB(), [&](auto iter) {
-			CircuitElement& elem = *iter->second;
+void Menu_Net::loop()
+{
+	static const vk2d::Color color(58, 132, 214);
 
-			if (elem.getType() != CircuitElement::Wire) BVH_CONTINUE;
+	auto& ws  = getCurrentWindowSheet();
+	auto pos  = ws.getClampedCursorPlanePos();
+	auto& cmd = ws.draw_list.commands.back();
 
-			float t0, t1;
-			auto& item = static_cast<Wire&>(elem);
+	cmd.addFilledCircle(pos, 5.f / DEFAULT_GRID_SIZE, color);
 
-			if (item.overlap(wire, t0, t1)) {
-				if (t0 == t1) BVH_CONTINUE;
+	if (is_wiring) {
+		auto mid = getMiddle(start_pos, pos);
 
-				if (t0 == 0.f && t1 != 1.f) {
-					wire.p0 = lerp(wire.p0, wire.p1, t1);
-					stack.push_back(wire);
-				} else if (t0 != 0.f && t1 == 1.f) {
-					wire.p1 = lerp(wire.p0, wire.p1, t0);
-					stack.push_back(wire);
-				} else if (t0 != 0.f && t1 != 1.f) {
-					stack.emplace_back(wire.p0, lerp(wire.p0, wire.p1, t0));
-					stack.emplace_back(lerp(wire.p0, wire.p1, t1), wire.p1);
-				}
-				BVH_BREAK;
-			}
+		Bus bus0(start_pos, mid, bus_width);
+		Bus bus1(mid, pos, bus_width);
+		bus0.select();
+		bus1.select();
 
-			BVH_CONTINUE;
-		});
+		cmd.addFilledCircle(start_pos, 5.f / DEFAULT_GRID_SIZE, color);
 
-		if (!canceled) {
-			wire.dot0 = checkWireCrossing(wire.p0);
-			wire.dot1 = checkWireCrossing(wire.p1);
-			cmd->elements.emplace_back(wire.clone());
-		}
+		bus0.draw(ws.draw_list);
+		bus1.draw(ws.draw_list);
 	}
-
-	ws.pushCommand(std::move(cmd));
 }
 
-bool Menu_Wire::checkWireCrossing(const vec2& pos) const
+void Menu_Net::eventProc(const vk2d::Event& e, float dt)
 {
-	auto& ws  = getCurrentWindowSheet();
-	int count = 0;
-
-	ws.sheet->bvh.query(pos, [&](auto iter) {
-		CircuitElement& elem = *iter->second;
-
-		if (elem.getType() != CircuitElement::Wire) BVH_CONTINUE;
-
-		auto& wire = static_cast<Wire&>(elem);
+	switch (e.type) {
+	case Event::KeyPressed: {
+		if (e.keyboard.key == Key::Escape)
+			is_wiring = false;
+	} break;
+	case Event::MousePressed: {
+		auto& ws = getCurrentWindowSheet();
 
-		if (wire.p0 == pos || wire.p1 == pos) 
-			++count;
-		else if (wire.hit(pos))
-			count += 2;
+		if (e.mouseButton.button == Mouse::Left && ws.capturing_mouse) {
+			auto pos = ws.getClampedCursorPlanePos();
 
-		return count > 1;
-	});
+			if (!is_wiring) {
+				is_wiring = true;
+				start_pos = pos;
+				return;
+			} else if (pos != start_pos) {
+				auto is_vert  = is_vertical(start_pos, pos);
+				auto is_horiz = is_horizontal(start_pos, pos);
 
-	return count > 1;
-}
+				std::vector<Bus> buses;
+				if (curr_wire_type == 2 || is_vert || is_horiz) {
+					if (length(start_pos - pos) > 0.f)
+						buses.emplace_back(start_pos, pos, bus_width);
+				} else {
+					auto mid = getMiddle(start_pos, pos);
 
-Menu_Net::Menu_Net() :
-	WiringSideMenu("Net")
-{
-}
+					if (length(start_pos - mid) > 0.f)
+						buses.emplace_back(start_pos, mid, bus_width);
+					if (length(mid - pos) > 0.f)
+						buses.emplace_back(mid, pos, bus_width);
+				}
 
-void Menu_Net::loop()
-{
-}
+				bool wiring = checkContinueWiring(pos);
+				addWires(std::move(buses));
 
-void Menu_Net::eventProc(const vk2d::Event& e, float dt)
-{
+				if (wiring) {
+					start_pos = pos;
+					break;
+				}
+			}
+			
+			is_wiring = false;
+		} else if (e.mouseButton.button == Mouse::Right) {
+			if (is_wiring && Mouse::isPressed(Mouse::Left)) {
+				is_wiring = false;
+			} else {
+				curr_wire_type = (curr_wire_type + 1) % 5;
+			}
+		}
+	}break;
+	}
 }
 
 void Menu_Net::menuButton()
@@ -1387,23 +1571,96 @@ void Menu_Net::upperMenu()
 	ImGui::RadioImageButton(ICON_NET_TYPE3, { 35, 35 }, &curr_wire_type, 3);
 	ImGui::SameLine();
 	ImGui::RadioImageButton(ICON_NET_TYPE4, { 35, 35 }, &curr_wire_type, 4);
+
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(200);
+	ImGui::SliderInt("Bits", &bus_width, 2, MAX_BUS_WIDTH);
 }
 
 Menu_SplitWire::Menu_SplitWire() :
-	SideMenu("Split Wire")
+	SideMenu("Split Wire"),
+	splitter_width(DEFAULT_BUS_WIDTH),
+	curr_dir(Direction::Up)
 {
 }
 
 void Menu_SplitWire::loop()
 {
+	auto& ws = getCurrentWindowSheet();
+
+	if (!ws.capturing_mouse) return;
+
+	Splitter splitter(splitter_width);
+	splitter.pos = ws.getClampedCursorPlanePos();
+	splitter.dir = curr_dir;
+
+	if (checkBlocked(splitter))
+		splitter.style |= CircuitElement::Blocked;
+
+	splitter.draw(ws.draw_list);
 }
 
 void Menu_SplitWire::eventProc(const vk2d::Event& e, float dt)
 {
+	switch (e.type) {
+	case Event::MousePressed: {
+		auto& ws = getCurrentWindowSheet();
+
+		if (e.mouseButton.button == Mouse::Left && ws.capturing_mouse) {
+			auto splitter = std::make_unique<Splitter>(splitter_width);
+			splitter->pos = ws.getClampedCursorPlanePos();
+			splitter->dir = curr_dir;
+
+			if (checkBlocked(*splitter)) return;
+
+			auto cmd = std::make_unique<Command_Add>();
+			cmd->elements.emplace_back(std::move(splitter));
+
+			ws.pushCommand(std::move(cmd));
+		} else if (e.mouseButton.button == Mouse::Right) {
+			curr_dir = rotate_cw(curr_dir);
+		}
+	}	break;
+	}
 }
 
 void Menu_SplitWire::menuButton()
 {
 	auto& main_window = MainWindow::get();
 	SideMenu::menuButtonImpl(ICON_SPLIT_WIRE, { 40, 40 });
+}
+
+void Menu_SplitWire::upperMenu()
+{
+	if (ImGui::ImageButton(ICON_ROTATE_CW, { 35, 35 })) {
+		curr_dir = rotate_cw(curr_dir);
+	}
+
+	ImGui::SameLine();
+	if (ImGui::ImageButton(ICON_ROTATE_CCW, { 35, 35 })) {
+		curr_dir = rotate_ccw(curr_dir);
+	}
+
+	ImGui::SameLine();
+	ImGui::RadioImageButton(ICON_DIR_UP, { 35, 35 }, (int*)&curr_dir, 0);
+	ImGui::SameLine();
+	ImGui::RadioImageButton(ICON_DIR_RIGHT, { 35, 35 }, (int*)&curr_dir, 1);
+	ImGui::SameLine();
+	ImGui::RadioImageButton(ICON_DIR_DOWN, { 35, 35 }, (int*)&curr_dir, 2);
+	ImGui::SameLine();
+	ImGui::RadioImageButton(ICON_DIR_LEFT, { 35, 35 }, (int*)&curr_dir, 3);
+
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(200);
+	ImGui::SliderInt("Bits", &splitter_width, 2, MAX_BUS_WIDTH);
+}
+
+// splitters may sit on wires and buses but not on other elements
+bool Menu_SplitWire::checkBlocked(const Splitter& splitter) const
+{
+	auto& ws = getCurrentWindowSheet();
+
+	return ws.getBVH().query(splitter.getAABB(), [&](auto iter) {
+		return !iter->second->isWireBased();
+	});
 }
\ No newline at end of file
@@ -94,7 +94,12 @@ public:
 	Menu_Unit();
 
 	void loop() override;
+	void eventProc(const vk2d::Event& e, float dt) override;
 	void menuButton() override;
+	void upperMenu() override;
+
+	int32_t   curr_unit;
+	Direction curr_dir;
 };
 
 class Menu_Shapes : public SideMenu
@@ -180,6 +185,10 @@ public:
 	vec2 getMiddle(const vec2& p0, const vec2& p1) const;
 	bool checkContinueWiring(const vec2& pos) const;
 
+	template <class WireType>
+	void addWires(std::vector<WireType>&& stack);
+	bool checkWireCrossing(const vec2& pos, CircuitElement::Type type) const;
+
 	int curr_wire_type;
 	bool is_wiring;
 	vec2 start_pos;
@@ -194,9 +203,6 @@ public:
 	void eventProc(const vk2d::Event& e, float dt) override;
 	void menuButton() override;
 	void upperMenu() override;
-
-	void addWires(std::vector<Wire>&& stack);
-	bool checkWireCrossing(const vec2& pos) const;
 };
 
 class Menu_Net : public WiringSideMenu
@@ -208,6 +214,8 @@ public:
 	void eventProc(const vk2d::Event& e, float dt) override;
 	void menuButton() override;
 	void upperMenu() override;
+
+	int bus_width;
 };
 
 class Menu_SplitWire : public SideMenu
@@ -218,4 +226,10 @@ public:
 	void loop() override;
 	void eventProc(const vk2d::Event& e, float dt) override;
 	void menuButton() override;
+	void upperMenu() override;
+
+	bool checkBlocked(const Splitter& splitter) const;
+
+	int       splitter_width;
+	Direction curr_dir;
 };
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// transitions of every net and evaluations of every gate, in the net ids and gate order of
+// the Simulator the engine was built from. the engines count into their own arrays while
+// counting is on and add them here with collectActivity
+struct ActivityCounters {
+	std::vector<uint64_t> net_toggles;
+	std::vector<uint64_t> gate_evaluations;
+
+	void clear() {
+		std::fill(net_toggles.begin(), net_toggles.end(), 0);
+		std::fill(gate_evaluations.begin(), gate_evaluations.end(), 0);
+	}
+};
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "breakpoints.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+
+Breakpoints::Breakpoints() :
+	hit(NO_BREAKPOINT),
+	hit_tick(0)
+{}
+
+bool Breakpoints::add(const Breakpoint& breakpoint)
+{
+	const auto& nets = breakpoint.nets;
+
+	if (nets.empty() || nets.size() > MAX_BREAKPOINT_NETS) return false;
+	if ((breakpoint.condition == Rising || breakpoint.condition == Falling) && nets.size() != 1) return false;
+
+	auto idx = (uint32_t)breakpoints.size();
+
+	for (auto net : nets) {
+		auto iter = std::upper_bound(watches.begin(), watches.end(), net,
+			[](net_id_t net, const Watch& watch) { return net < watch.net; });
+
+		watches.insert(iter, { net, idx });
+		watched.set(net);
+	}
+
+	auto& added = breakpoints.emplace_back(breakpoint);
+
+	// bits past the width never compare
+	auto mask = nets.size() == 64 ? ~0ull : (1ull << nets.size()) - 1;
+	added.value &= mask;
+	added.known &= mask;
+
+	last_values.emplace_back(0);
+	last_known.emplace_back(0);
+	dirty_flags.emplace_back(0);
+
+	return true;
+}
+
+void Breakpoints::clear()
+{
+	breakpoints.clear();
+	watches.clear();
+	watched.clear();
+	last_values.clear();
+	last_known.clear();
+	dirty_flags.clear();
+	dirty.clear();
+
+	hit      = NO_BREAKPOINT;
+	hit_tick = 0;
+}
+
+void Breakpoints::sync(const std::vector<uint8_t>& net_values)
+{
+	for (uint32_t idx = 0; idx < breakpoints.size(); ++idx) {
+		readBus(breakpoints[idx], net_values, last_values[idx], last_known[idx]);
+		dirty_flags[idx] = false;
+	}
+
+	dirty.clear();
+}
+
+void Breakpoints::evaluate(uint64_t tick, const std::vector<uint8_t>& net_values)
+{
+	for (auto idx : dirty) {
+		const auto& breakpoint = breakpoints[idx];
+		dirty_flags[idx] = false;
+
+		uint64_t value, known;
+		readBus(breakpoint, net_values, value, known);
+
+		auto prev_value = last_values[idx];
+		auto prev_known = last_known[idx];
+
+		last_values[idx] = value;
+		last_known[idx]  = known;
+
+		// a net toggled back within the tick
+		if (value == prev_value && known == prev_known) continue;
+
+		auto width = (uint32_t)breakpoint.nets.size();
+		auto mask  = width == 64 ? ~0ull : (1ull << width) - 1;
+
+		bool equals = value == breakpoint.value && known == breakpoint.known;
+		bool cond   = false;
+
+		switch (breakpoint.condition) {
+		case Equals:
+			cond = equals;
+			break;
+		case NotEquals:
+			cond = !equals && (prev_value == breakpoint.value && prev_known == breakpoint.known);
+			break;
+		case Rising:
+			cond = (prev_known & 1) && !(prev_value & 1) && (known & 1) && (value & 1);
+			break;
+		case Falling:
+			cond = (prev_known & 1) && (prev_value & 1) && (known & 1) && !(value & 1);
+			break;
+		case Unknown:
+			cond = known != mask && prev_known == mask;
+			break;
+		}
+
+		if (cond && (hit == NO_BREAKPOINT || (hit_tick == tick && idx < hit))) {
+			hit      = idx;
+			hit_tick = tick;
+		}
+	}
+
+	dirty.clear();
+}
+
+bool Breakpoints::isHit() const
+{
+	return hit != NO_BREAKPOINT;
+}
+
+uint32_t Breakpoints::getHit() const
+{
+	return hit;
+}
+
+uint64_t Breakpoints::getHitTick() const
+{
+	return hit_tick;
+}
+
+void Breakpoints::clearHit()
+{
+	hit = NO_BREAKPOINT;
+}
+
+size_t Breakpoints::getCount() const
+{
+	return breakpoints.size();
+}
+
+const Breakpoints::Breakpoint& Breakpoints::getBreakpoint(uint32_t idx) const
+{
+	return breakpoints[idx];
+}
+
+void Breakpoints::markWatched(net_id_t net)
+{
+	auto iter = std::lower_bound(watches.begin(), watches.end(), net,
+		[](const Watch& watch, net_id_t net) { return watch.net < net; });
+
+	for (; iter != watches.end() && iter->net == net; ++iter) {
+		if (dirty_flags[iter->breakpoint]) continue;
+
+		dirty_flags[iter->breakpoint] = true;
+		dirty.emplace_back(iter->breakpoint);
+	}
+}
+
+void Breakpoints::readBus(const Breakpoint& breakpoint, const std::vector<uint8_t>& net_values, uint64_t& value, uint64_t& known) const
+{
+	value = 0;
+	known = 0;
+
+	for (uint32_t bit = 0; bit < breakpoint.nets.size(); ++bit) {
+		auto net = breakpoint.nets[bit];
+
+		if (net >= net_values.size()) continue;
+
+		value |= (uint64_t)(net_values[net] & 1) << bit;
+		known |= (uint64_t)(net_values[net] >> 1) << bit;
+	}
+}
+
+bool parse_bus_value(const std::string& str, uint32_t width, uint64_t& value, uint64_t& known)
+{
+	auto mask = width >= 64 ? ~0ull : (1ull << width) - 1;
+
+	value = 0;
+	known = 0;
+
+	if (str.size() > 2 && str[0] == '0' && (str[1] == 'b' || str[1] == 'B')) {
+		auto digits = str.size() - 2;
+
+		if (digits > width) return false;
+
+		for (size_t i = 2; i < str.size(); ++i) {
+			value <<= 1;
+			known <<= 1;
+
+			switch (str[i]) {
+			case '0':           known |= 1; break;
+			case '1':           known |= 1; value |= 1; break;
+			case 'x': case 'X': break;
+			case 'z': case 'Z': value |= 1; break;
+			default:            return false;
+			}
+		}
+
+		// leading bits that were left out are 0
+		known |= mask & ~(digits >= 64 ? ~0ull : (1ull << digits) - 1);
+		return true;
+	}
+
+	bool hex    = str.size() > 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X');
+	auto digits = str.c_str() + (hex ? 2 : 0);
+
+	if (!*digits || !std::isxdigit((unsigned char)*digits)) return false;
+
+	char* end;
+	errno = 0;
+	value = std::strtoull(digits, &end, hex ? 16 : 10);
+	known = mask;
+
+	return !*end && errno != ERANGE && !(value & ~mask);
+}
\ No newline at end of file
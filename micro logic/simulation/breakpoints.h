@@ -0,0 +1,100 @@
+#pragma once
+
+#include "logic_value.h"
+#include "../net.h"
+#include "../util/sparse_bitset.hpp"
+#include <string>
+#include <vector>
+
+#define MAX_BREAKPOINT_NETS 64
+#define NO_BREAKPOINT       UINT32_MAX
+
+// conditions on nets that stop the simulation. the engines hand over the nets changed in a
+// tick, only the ones in the watched bitset are looked at further, so nets without a
+// breakpoint cost one bit test. a breakpoint is evaluated when one of its nets changed and
+// hits when its value moves into the condition
+class Breakpoints {
+public:
+	enum Condition {
+		Equals,    // the nets as a bus, bit n is nets[n]
+		NotEquals,
+		Rising,    // a single net going from 0 to 1
+		Falling,
+		Unknown    // any of the nets is X or Z
+	};
+
+	struct Breakpoint {
+		Condition             condition;
+		std::vector<net_id_t> nets;
+		uint64_t              value; // value and known planes to compare to
+		uint64_t              known;
+	};
+
+	Breakpoints();
+
+	bool add(const Breakpoint& breakpoint);
+	void clear();
+
+	// takes the current values without hitting, after a reset or a restored state
+	void sync(const std::vector<uint8_t>& net_values);
+
+	inline void mark(net_id_t net) {
+		if (watched.test(net))
+			markWatched(net);
+	}
+
+	template <class NetList>
+	inline void mark(const NetList& nets) {
+		for (auto net : nets)
+			mark(net);
+	}
+
+	// evaluates the breakpoints whose nets were marked
+	void evaluate(uint64_t tick, const std::vector<uint8_t>& net_values);
+
+	inline void check(uint64_t tick, net_id_t net, const std::vector<uint8_t>& net_values) {
+		mark(net);
+
+		if (!dirty.empty())
+			evaluate(tick, net_values);
+	}
+
+	template <class NetList>
+	inline void check(uint64_t tick, const NetList& nets, const std::vector<uint8_t>& net_values) {
+		mark(nets);
+
+		if (!dirty.empty())
+			evaluate(tick, net_values);
+	}
+
+	bool isHit() const;
+	uint32_t getHit() const;   // the first breakpoint that hit, NO_BREAKPOINT if none
+	uint64_t getHitTick() const;
+	void clearHit();
+
+	size_t getCount() const;
+	const Breakpoint& getBreakpoint(uint32_t idx) const;
+
+private:
+	struct Watch {
+		net_id_t net;
+		uint32_t breakpoint;
+	};
+
+	void markWatched(net_id_t net);
+	void readBus(const Breakpoint& breakpoint, const std::vector<uint8_t>& net_values, uint64_t& value, uint64_t& known) const;
+
+	std::vector<Breakpoint> breakpoints;
+	std::vector<Watch>      watches; // sorted by net
+	SparseBitset            watched;
+	std::vector<uint64_t>   last_values; // per breakpoint
+	std::vector<uint64_t>   last_known;
+	std::vector<uint8_t>    dirty_flags;
+	std::vector<uint32_t>   dirty;
+
+	uint32_t hit;
+	uint64_t hit_tick;
+};
+
+// a bus constant as hex (0x), binary (0b) or decimal. binary digits may be x or z
+bool parse_bus_value(const std::string& str, uint32_t width, uint64_t& value, uint64_t& known);
\ No newline at end of file
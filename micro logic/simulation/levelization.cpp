@@ -0,0 +1,186 @@
+#include "levelization.h"
+
+#include "../util/bit_utils.h"
+#include <algorithm>
+
+Levelization::Levelization() :
+	component_count(0),
+	loop_count(0),
+	level_count(0)
+{}
+
+void Levelization::build(const Simulator& simulator)
+{
+	std::vector<Simulator::Gate>   gates;
+	std::vector<net_id_t>          gate_nets;
+	std::vector<uint32_t>          fanout_offsets;
+	std::vector<Simulator::Fanout> fanouts;
+
+	simulator.flatten(gates, gate_nets, fanout_offsets, fanouts);
+
+	build(gates, gate_nets, fanout_offsets, fanouts);
+}
+
+void Levelization::build(
+	const std::vector<Simulator::Gate>& gates,
+	const std::vector<net_id_t>& gate_nets,
+	const std::vector<uint32_t>& fanout_offsets,
+	const std::vector<Simulator::Fanout>& fanouts)
+{
+	struct Frame {
+		uint32_t gate;
+		uint64_t bits; // output pins left to visit
+		uint32_t next; // fanouts of the current output
+		uint32_t end;
+	};
+
+	clear();
+
+	auto gate_count = (uint32_t)gates.size();
+	auto net_count  = fanout_offsets.size() - 1;
+
+	std::vector<uint32_t> indices(gate_count, UINT32_MAX);
+	std::vector<uint32_t> lows(gate_count);
+	std::vector<uint8_t>  on_stack(gate_count, 0);
+	std::vector<uint8_t>  self_loops(gate_count, 0);
+	std::vector<uint32_t> stack;
+	std::vector<Frame>    frames;
+	std::vector<uint32_t> sizes;
+
+	components.resize(gate_count);
+	order.reserve(gate_count);
+
+	uint32_t counter = 0;
+
+	auto push = [&](uint32_t gate_idx) {
+		indices[gate_idx]  = counter;
+		lows[gate_idx]     = counter++;
+		on_stack[gate_idx] = true;
+		stack.emplace_back(gate_idx);
+		frames.push_back({ gate_idx, gates[gate_idx].shared->output_mask, 0, 0 });
+	};
+
+	for (uint32_t root = 0; root < gate_count; ++root) {
+		if (indices[root] != UINT32_MAX) continue;
+
+		push(root);
+
+		while (!frames.empty()) {
+			auto& frame = frames.back();
+			auto v      = frame.gate;
+
+			if (frame.next == frame.end) {
+				if (frame.bits) {
+					auto pin = count_trailing_zeros(frame.bits);
+					auto net = gate_nets[gates[v].net_begin + pin];
+
+					frame.bits &= frame.bits - 1;
+
+					if (net != INVALID_NET_ID) {
+						frame.next = fanout_offsets[net];
+						frame.end  = fanout_offsets[net + 1];
+					}
+					continue;
+				}
+
+				frames.pop_back();
+
+				// v is the root of a component, Tarjan finds components sinks first
+				if (lows[v] == indices[v]) {
+					uint32_t size = 0;
+					uint32_t w;
+
+					do {
+						w = stack.back();
+						stack.pop_back();
+						on_stack[w]   = false;
+						components[w] = component_count;
+						order.emplace_back(w);
+						++size;
+					} while (w != v);
+
+					sizes.emplace_back(size);
+					++component_count;
+				}
+
+				if (!frames.empty()) {
+					auto u  = frames.back().gate;
+					lows[u] = std::min(lows[u], lows[v]);
+				}
+				continue;
+			}
+
+			auto w = fanouts[frame.next++].gate;
+
+			if (w == v)
+				self_loops[v] = true;
+
+			if (indices[w] == UINT32_MAX)
+				push(w);
+			else if (on_stack[w])
+				lows[v] = std::min(lows[v], indices[w]);
+		}
+	}
+
+	std::reverse(order.begin(), order.end());
+
+	// longest path over the component dag, in topological order
+	std::vector<uint32_t> component_levels(component_count, 0);
+
+	levels.resize(gate_count);
+	loop_flags.resize(net_count, 0);
+
+	for (auto gate_idx : order) {
+		auto comp  = components[gate_idx];
+		auto level = component_levels[comp];
+		auto loop  = sizes[comp] > 1 || self_loops[gate_idx];
+
+		levels[gate_idx] = level;
+		level_count      = std::max(level_count, level + 1);
+
+		const auto& gate = gates[gate_idx];
+
+		for (auto bits = gate.shared->output_mask; bits; bits &= bits - 1) {
+			auto net = gate_nets[gate.net_begin + count_trailing_zeros(bits)];
+
+			if (net == INVALID_NET_ID) continue;
+
+			for (auto i = fanout_offsets[net]; i < fanout_offsets[net + 1]; ++i) {
+				auto next = components[fanouts[i].gate];
+
+				if (next != comp) {
+					component_levels[next] = std::max(component_levels[next], level + 1);
+				} else if (loop && !loop_flags[net]) {
+					loop_flags[net] = true;
+					loop_nets.emplace_back(net);
+				}
+			}
+		}
+	}
+
+	for (uint32_t comp = 0; comp < component_count; ++comp)
+		if (sizes[comp] > 1)
+			++loop_count;
+
+	for (uint32_t gate_idx = 0; gate_idx < gate_count; ++gate_idx)
+		if (self_loops[gate_idx] && sizes[components[gate_idx]] == 1)
+			++loop_count;
+}
+
+void Levelization::clear()
+{
+	order.clear();
+	components.clear();
+	levels.clear();
+	loop_nets.clear();
+	loop_flags.clear();
+
+	component_count = 0;
+	loop_count      = 0;
+	level_count     = 0;
+}
+
+bool Levelization::isLoopNet(net_id_t net) const
+{
+	return net < loop_flags.size() && loop_flags[net];
+}
\ No newline at end of file
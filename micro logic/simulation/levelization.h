@@ -0,0 +1,32 @@
+#pragma once
+
+#include "simulator.h"
+
+// strongly connected components of the gate graph, found with an iterative Tarjan
+// search in O(gates + fanouts). a component of more than one gate, or a gate reading
+// its own output, is a combinational loop. latches are loops too, only the ones that
+// keep switching are reported at run time
+class Levelization {
+public:
+	Levelization();
+
+	void build(const Simulator& simulator);
+	void build(
+		const std::vector<Simulator::Gate>& gates,
+		const std::vector<net_id_t>& gate_nets,
+		const std::vector<uint32_t>& fanout_offsets,
+		const std::vector<Simulator::Fanout>& fanouts);
+	void clear();
+
+	bool isLoopNet(net_id_t net) const;
+
+public:
+	std::vector<uint32_t> order;       // gates, each after every gate driving it from another component
+	std::vector<uint32_t> components;  // component of each gate
+	std::vector<uint32_t> levels;      // level of each gate, sources are 0
+	std::vector<net_id_t> loop_nets;   // nets read and driven inside the same loop
+	std::vector<uint8_t>  loop_flags;  // per net
+	uint32_t              component_count;
+	uint32_t              loop_count;
+	uint32_t              level_count;
+};
\ No newline at end of file
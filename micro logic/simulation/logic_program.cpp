@@ -0,0 +1,394 @@
+#include "logic_program.h"
+
+#include "../util/bit_utils.h"
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+
+namespace {
+
+struct Token {
+	enum Type {
+		End,
+		NewLine,
+		Pin,
+		Const,
+		Assign,
+		Op,
+		Not,
+		LParen,
+		RParen,
+		Invalid
+	};
+
+	Type                 type;
+	LogicProgram::OpCode op;
+	uint32_t             value;
+};
+
+class Parser {
+public:
+	Parser(const char* src, uint64_t input_mask, uint64_t output_mask, LogicProgram& program, std::string& error) :
+		src(src),
+		input_mask(input_mask),
+		output_mask(output_mask),
+		pin_count(0),
+		next_reg(0),
+		program(program),
+		error(error)
+	{
+		auto mask = input_mask | output_mask;
+		while (pin_count < 64 && (mask >> pin_count))
+			++pin_count;
+	}
+
+	bool parse() {
+		next();
+
+		while (token.type != Token::End) {
+			if (token.type == Token::NewLine) {
+				next();
+				continue;
+			}
+
+			if (!parseStatement()) return false;
+		}
+
+		return true;
+	}
+
+private:
+	void skipSpace() {
+		while (*src == ' ' || *src == '\t' || *src == '\r')
+			++src;
+
+		if (*src == '#') {
+			while (*src && *src != '\n')
+				++src;
+		}
+	}
+
+	bool matchWord(const char* word) {
+		auto len = strlen(word);
+
+		if (strncmp(src, word, len) != 0) return false;
+		if (std::isalnum((unsigned char)src[len]) || src[len] == '_') return false;
+
+		src += len;
+		return true;
+	}
+
+	void next() {
+		static const struct {
+			const char*          word;
+			LogicProgram::OpCode op;
+		} words[] = {
+			{ "and",  LogicProgram::And },
+			{ "or",   LogicProgram::Or },
+			{ "xor",  LogicProgram::Xor },
+			{ "nand", LogicProgram::Nand },
+			{ "nor",  LogicProgram::Nor },
+			{ "xnor", LogicProgram::Xnor },
+		};
+
+		skipSpace();
+
+		token = {};
+
+		switch (*src) {
+		case '\0':
+			token.type = Token::End;
+			return;
+		case '\n':
+		case ';':
+			++src;
+			token.type = Token::NewLine;
+			return;
+		case '=':
+			++src;
+			token.type = Token::Assign;
+			return;
+		case '(':
+			++src;
+			token.type = Token::LParen;
+			return;
+		case ')':
+			++src;
+			token.type = Token::RParen;
+			return;
+		case '!':
+		case '~':
+			++src;
+			token.type = Token::Not;
+			return;
+		case '&':
+			++src;
+			token.type = Token::Op;
+			token.op   = LogicProgram::And;
+			return;
+		case '|':
+			++src;
+			token.type = Token::Op;
+			token.op   = LogicProgram::Or;
+			return;
+		case '^':
+			++src;
+			token.type = Token::Op;
+			token.op   = LogicProgram::Xor;
+			return;
+		case '0':
+		case '1':
+			token.type  = Token::Const;
+			token.value = *src++ - '0';
+			return;
+		case '$':
+			++src;
+
+			if (!std::isdigit((unsigned char)*src)) {
+				token.type = Token::Invalid;
+				return;
+			}
+
+			token.type = Token::Pin;
+			while (std::isdigit((unsigned char)*src))
+				token.value = 10 * token.value + (*src++ - '0');
+			return;
+		}
+
+		if (matchWord("not")) {
+			token.type = Token::Not;
+			return;
+		}
+
+		for (const auto& [word, op] : words) {
+			if (matchWord(word)) {
+				token.type = Token::Op;
+				token.op   = op;
+				return;
+			}
+		}
+
+		token.type = Token::Invalid;
+	}
+
+	static int precedence(LogicProgram::OpCode op) {
+		switch (op) {
+		case LogicProgram::And:
+		case LogicProgram::Nand:
+			return 3;
+		case LogicProgram::Xor:
+		case LogicProgram::Xnor:
+			return 2;
+		default:
+			return 1;
+		}
+	}
+
+	bool fail(const std::string& msg) {
+		error = msg;
+		return false;
+	}
+
+	bool allocRegister(uint8_t& reg) {
+		if (next_reg >= MAX_LOGIC_REGISTERS)
+			return fail("expression is too complex");
+
+		reg = (uint8_t)next_reg++;
+		program.reg_count = std::max(program.reg_count, next_reg);
+		return true;
+	}
+
+	bool emit(LogicProgram::OpCode op, uint8_t a, uint8_t b, uint8_t& dst) {
+		if (!allocRegister(dst)) return false;
+
+		program.code.push_back({ op, dst, a, b });
+		return true;
+	}
+
+	bool parseStatement() {
+		if (token.type != Token::Pin)
+			return fail("expected '$n' at the beginning of statement");
+
+		auto pin = token.value;
+
+		if (pin >= pin_count || !((output_mask >> pin) & 1))
+			return fail("$" + std::to_string(pin) + " is not an output pin");
+
+		next();
+		if (token.type != Token::Assign)
+			return fail("expected '=' after $" + std::to_string(pin));
+
+		next_reg = pin_count;
+
+		uint8_t reg;
+		next();
+		if (!parseExpression(0, reg)) return false;
+
+		if (token.type != Token::NewLine && token.type != Token::End)
+			return fail("unexpected token after expression");
+
+		if (!program.code.empty() && program.code.back().dst == reg && reg >= pin_count)
+			program.code.back().dst = (uint8_t)pin;
+		else
+			program.code.push_back({ LogicProgram::Mov, (uint8_t)pin, reg, reg });
+
+		program.write_mask |= 1ull << pin;
+		return true;
+	}
+
+	bool parseExpression(int min_prec, uint8_t& reg) {
+		if (!parseUnary(reg)) return false;
+
+		while (token.type == Token::Op && precedence(token.op) > min_prec) {
+			auto op = token.op;
+
+			uint8_t rhs;
+			next();
+			if (!parseExpression(precedence(op), rhs)) return false;
+			if (!emit(op, reg, rhs, reg)) return false;
+		}
+
+		return true;
+	}
+
+	bool parseUnary(uint8_t& reg) {
+		switch (token.type) {
+		case Token::Not: {
+			uint8_t operand;
+			next();
+			if (!parseUnary(operand)) return false;
+			return emit(LogicProgram::Not, operand, operand, reg);
+		}
+		case Token::LParen:
+			next();
+			if (!parseExpression(0, reg)) return false;
+			if (token.type != Token::RParen)
+				return fail("expected ')'");
+			next();
+			return true;
+		case Token::Const: {
+			auto op = token.value ? LogicProgram::One : LogicProgram::Zero;
+			next();
+			return emit(op, 0, 0, reg);
+		}
+		case Token::Pin:
+			if (token.value >= pin_count || !(((input_mask | output_mask) >> token.value) & 1))
+				return fail("$" + std::to_string(token.value) + " is not a logic pin");
+
+			reg = (uint8_t)token.value;
+			next();
+			return true;
+		default:
+			return fail("expected operand");
+		}
+	}
+
+	const char* src;
+	uint64_t    input_mask;
+	uint64_t    output_mask;
+	uint32_t    pin_count;
+	uint32_t    next_reg;
+	Token       token;
+
+	LogicProgram& program;
+	std::string&  error;
+};
+
+}
+
+LogicProgram::LogicProgram() :
+	reg_count(0),
+	write_mask(0)
+{}
+
+bool LogicProgram::compile(const char* src, uint64_t input_mask, uint64_t output_mask, std::string& error)
+{
+	clear();
+
+	Parser parser(src, input_mask, output_mask, *this, error);
+
+	if (!parser.parse()) {
+		clear();
+		return false;
+	}
+
+	code.shrink_to_fit();
+	tabulate();
+	return true;
+}
+
+void LogicProgram::clear()
+{
+	code.clear();
+	tables.clear();
+	reg_count  = 0;
+	write_mask = 0;
+}
+
+bool LogicProgram::empty() const
+{
+	return code.empty();
+}
+
+bool LogicProgram::tabulated() const
+{
+	return !code.empty() && tables.size() == count_bits(write_mask);
+}
+
+void LogicProgram::tabulate()
+{
+	uint64_t support[MAX_LOGIC_REGISTERS];
+
+	for (uint32_t reg = 0; reg < MAX_LOGIC_REGISTERS; ++reg)
+		support[reg] = 1ull << reg;
+
+	for (const auto& ins : code) {
+		switch (ins.op) {
+		case Mov:
+		case Not:  support[ins.dst] = support[ins.a]; break;
+		case Zero:
+		case One:  support[ins.dst] = 0; break;
+		default:   support[ins.dst] = support[ins.a] | support[ins.b]; break;
+		}
+	}
+
+	tables.clear();
+
+	for (auto outputs = write_mask; outputs; outputs &= outputs - 1) {
+		auto output = count_trailing_zeros(outputs);
+		auto inputs = support[output];
+
+		if (count_bits(inputs) > MAX_TABLE_INPUTS) {
+			tables.clear();
+			return;
+		}
+
+		auto& table = tables.emplace_back();
+		table.bits        = 0;
+		table.input_mask  = 0;
+		table.output      = (uint8_t)output;
+		table.input_count = 0;
+
+		if (inputs) {
+			auto run = inputs >> count_trailing_zeros(inputs);
+
+			// a run of ones has no gaps once it is shifted down
+			if ((run & (run + 1)) == 0)
+				table.input_mask = inputs;
+		}
+
+		for (; inputs; inputs &= inputs - 1)
+			table.inputs[table.input_count++] = (uint8_t)count_trailing_zeros(inputs);
+
+		for (uint32_t index = 0; index < (1u << table.input_count); ++index) {
+			uint64_t regs = 0;
+
+			for (uint32_t i = 0; i < table.input_count; ++i)
+				regs |= (uint64_t)((index >> i) & 1) << table.inputs[i];
+
+			table.bits |= ((evaluate(regs) >> output) & 1) << index;
+		}
+	}
+
+	tables.shrink_to_fit();
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define MAX_LOGIC_REGISTERS 64
+#define MAX_TABLE_INPUTS 6
+
+class LogicProgram {
+public:
+	enum OpCode : uint8_t {
+		Mov,
+		Not,
+		And,
+		Or,
+		Xor,
+		Nand,
+		Nor,
+		Xnor,
+		Zero,
+		One
+	};
+
+	struct Instruction {
+		OpCode  op;
+		uint8_t dst;
+		uint8_t a;
+		uint8_t b;
+	};
+
+	struct Table {
+		uint64_t bits; // bit n is the output for input combination n
+		uint64_t input_mask; // the input pins when they are contiguous, 0 otherwise
+		uint8_t  output;
+		uint8_t  input_count;
+		uint8_t  inputs[MAX_TABLE_INPUTS];
+	};
+
+	LogicProgram();
+
+	bool compile(const char* src, uint64_t input_mask, uint64_t output_mask, std::string& error);
+	void clear();
+	bool empty() const;
+	bool tabulated() const;
+
+	inline uint64_t evaluate(uint64_t regs) const;
+	inline uint64_t evaluateUnknown(uint64_t regs, uint64_t& known) const;
+	inline uint64_t evaluateTables(uint64_t pins) const;
+
+	template <class Word>
+	inline void evaluateWords(Word* regs) const;
+
+	std::vector<Instruction> code;
+	std::vector<Table>       tables;
+	uint32_t                 reg_count;
+	uint64_t                 write_mask;
+
+private:
+	void tabulate();
+};
+
+inline uint64_t LogicProgram::evaluate(uint64_t regs) const
+{
+	for (const auto& ins : code) {
+		uint64_t a = (regs >> ins.a) & 1;
+		uint64_t b = (regs >> ins.b) & 1;
+		uint64_t v;
+
+		switch (ins.op) {
+		case Mov:  v = a; break;
+		case Not:  v = a ^ 1; break;
+		case And:  v = a & b; break;
+		case Or:   v = a | b; break;
+		case Xor:  v = a ^ b; break;
+		case Nand: v = (a & b) ^ 1; break;
+		case Nor:  v = (a | b) ^ 1; break;
+		case Xnor: v = a ^ b ^ 1; break;
+		case Zero: v = 0; break;
+		default:   v = 1; break;
+		}
+
+		regs = (regs & ~(1ull << ins.dst)) | (v << ins.dst);
+	}
+
+	return regs;
+}
+
+// known is the known plane of regs, a known 0 on an and or a known 1 on an or decides the result alone
+inline uint64_t LogicProgram::evaluateUnknown(uint64_t regs, uint64_t& known) const
+{
+	for (const auto& ins : code) {
+		uint64_t a  = (regs >> ins.a) & 1;
+		uint64_t b  = (regs >> ins.b) & 1;
+		uint64_t ka = (known >> ins.a) & 1;
+		uint64_t kb = (known >> ins.b) & 1;
+		uint64_t v, k;
+
+		switch (ins.op) {
+		case Mov:  v = a;           k = ka; break;
+		case Not:  v = a ^ 1;       k = ka; break;
+		case And:  v = a & b;       k = (ka & kb) | (ka & ~a) | (kb & ~b); break;
+		case Or:   v = a | b;       k = (ka & kb) | (ka & a) | (kb & b); break;
+		case Xor:  v = a ^ b;       k = ka & kb; break;
+		case Nand: v = (a & b) ^ 1; k = (ka & kb) | (ka & ~a) | (kb & ~b); break;
+		case Nor:  v = (a | b) ^ 1; k = (ka & kb) | (ka & a) | (kb & b); break;
+		case Xnor: v = a ^ b ^ 1;   k = ka & kb; break;
+		case Zero: v = 0;           k = 1; break;
+		default:   v = 1;           k = 1; break;
+		}
+
+		regs  = (regs & ~(1ull << ins.dst)) | (v << ins.dst);
+		known = (known & ~(1ull << ins.dst)) | ((k & 1) << ins.dst);
+	}
+
+	return regs;
+}
+
+inline uint64_t LogicProgram::evaluateTables(uint64_t pins) const
+{
+	uint64_t result = 0;
+
+	for (const auto& table : tables) {
+		uint32_t index = 0;
+
+		// the common case of pins declared side by side needs no gathering
+		if (table.input_mask) {
+			index = (uint32_t)((pins & table.input_mask) >> table.inputs[0]);
+		} else {
+			for (uint32_t i = 0; i < table.input_count; ++i)
+				index |= (uint32_t)((pins >> table.inputs[i]) & 1) << i;
+		}
+
+		result |= ((table.bits >> index) & 1) << table.output;
+	}
+
+	return result;
+}
+
+template <class Word>
+inline void LogicProgram::evaluateWords(Word* regs) const
+{
+	for (const auto& ins : code) {
+		const auto& a = regs[ins.a];
+		const auto& b = regs[ins.b];
+
+		switch (ins.op) {
+		case Mov:  regs[ins.dst] = a; break;
+		case Not:  regs[ins.dst] = ~a; break;
+		case And:  regs[ins.dst] = a & b; break;
+		case Or:   regs[ins.dst] = a | b; break;
+		case Xor:  regs[ins.dst] = a ^ b; break;
+		case Nand: regs[ins.dst] = ~(a & b); break;
+		case Nor:  regs[ins.dst] = ~(a | b); break;
+		case Xnor: regs[ins.dst] = ~(a ^ b); break;
+		case Zero: regs[ins.dst] = Word(); break;
+		default:   regs[ins.dst] = ~Word(); break;
+		}
+	}
+}
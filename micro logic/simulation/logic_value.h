@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+// bit 0 is the value plane, bit 1 the known plane. an unknown value is X, or Z if its value bit is set
+enum LogicValue : uint8_t {
+	Logic_X = 0b00,
+	Logic_Z = 0b01,
+	Logic_0 = 0b10,
+	Logic_1 = 0b11
+};
+
+inline LogicValue to_logic_value(bool value) {
+	return value ? Logic_1 : Logic_0;
+}
+
+// LogicValue of pin n of a gate's value and known planes
+inline LogicValue get_logic_value(uint64_t values, uint64_t known, uint32_t pin) {
+	return (LogicValue)(((values >> pin) & 1) | (((known >> pin) & 1) << 1));
+}
+
+inline const char* to_string(LogicValue value) {
+	switch (value) {
+	case Logic_0: return "0";
+	case Logic_1: return "1";
+	case Logic_Z: return "Z";
+	default:      return "X";
+	}
+}
+
+// number of drivers of a net in each state, Z drivers are released
+struct DriverCounts {
+	uint32_t counts[4];
+
+	inline void move(LogicValue from, LogicValue to) {
+		--counts[from];
+		++counts[to];
+	}
+
+	inline LogicValue resolve() const {
+		if (counts[Logic_X] || (counts[Logic_0] && counts[Logic_1])) return Logic_X;
+		if (counts[Logic_1]) return Logic_1;
+		if (counts[Logic_0]) return Logic_0;
+		return Logic_Z;
+	}
+};
\ No newline at end of file
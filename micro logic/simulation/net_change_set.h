@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../net.h"
+#include <vector>
+
+// the nets changed since the last take, each one once. the engines hand over the nets
+// changed in a tick like they do to the recorder, so collecting costs per change and not
+// per net
+class NetChangeSet {
+public:
+	NetChangeSet() :
+		all(true)
+	{}
+
+	void resize(size_t net_count) {
+		marks.assign(net_count, 0);
+		nets.clear();
+		all = true;
+	}
+
+	// any net may have changed, after a reset or a loaded state
+	void addAll() {
+		for (auto net : nets)
+			marks[net] = 0;
+
+		nets.clear();
+		all = true;
+	}
+
+	inline void add(net_id_t net) {
+		if (all || marks[net]) return;
+
+		marks[net] = 1;
+		nets.emplace_back(net);
+	}
+
+	template <class NetList>
+	inline void add(const NetList& list) {
+		for (auto net : list)
+			add(net);
+	}
+
+	// in the order they first changed, every net after addAll
+	void take(std::vector<net_id_t>& out) {
+		out.clear();
+
+		if (all) {
+			for (net_id_t net = 0; net < marks.size(); ++net)
+				out.emplace_back(net);
+		} else {
+			nets.swap(out);
+
+			for (auto net : out)
+				marks[net] = 0;
+		}
+
+		all = false;
+	}
+
+	// like take but the nets stay in the set
+	void copy(std::vector<net_id_t>& out) const {
+		out.clear();
+
+		if (all) {
+			for (net_id_t net = 0; net < marks.size(); ++net)
+				out.emplace_back(net);
+		} else
+			out.assign(nets.begin(), nets.end());
+	}
+
+	void clear() {
+		for (auto net : nets)
+			marks[net] = 0;
+
+		nets.clear();
+		all = false;
+	}
+
+private:
+	std::vector<uint8_t>  marks;
+	std::vector<net_id_t> nets;
+	bool                  all;
+};
\ No newline at end of file
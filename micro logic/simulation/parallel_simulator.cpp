@@ -0,0 +1,1027 @@
+#include "parallel_simulator.h"
+
+#include "levelization.h"
+#include "simulation_state.h"
+#include "../util/bit_utils.h"
+#include <algorithm>
+
+ParallelSimulator::ParallelSimulator() :
+	generation(0),
+	pending(0),
+	sleepers(0),
+	phase(Phase::Evaluate),
+	tick_rate(DEFAULT_TICK_RATE),
+	tick_accum(0.f),
+	tick(0),
+	stable(true),
+	counting_activity(false),
+	recorder(nullptr),
+	breakpoints(nullptr),
+	changes(nullptr)
+{}
+
+ParallelSimulator::~ParallelSimulator()
+{
+	stopThreads();
+}
+
+void ParallelSimulator::build(const Simulator& simulator, uint32_t thread_count)
+{
+	clear();
+
+	std::vector<Simulator::Gate>   flat_gates;
+	std::vector<net_id_t>          flat_gate_nets;
+	std::vector<uint32_t>          flat_fanout_offsets;
+	std::vector<Simulator::Fanout> flat_fanouts;
+
+	simulator.flatten(flat_gates, flat_gate_nets, flat_fanout_offsets, flat_fanouts);
+
+	auto gate_count = (uint32_t)flat_gates.size();
+	auto net_count  = simulator.getNetCount();
+
+	// gates in topological order of their strongly connected components
+	Levelization levelization;
+	levelization.build(flat_gates, flat_gate_nets, flat_fanout_offsets, flat_fanouts);
+
+	const auto& order = levelization.order;
+
+	// the partition count depends only on the circuit, which keeps drive resolution order fixed
+	auto part_count = std::clamp<uint32_t>(
+		(gate_count + SIMULATION_PARTITION_GATES - 1) / SIMULATION_PARTITION_GATES, 1, MAX_SIMULATION_PARTITIONS);
+
+	std::vector<uint32_t> gate_parts(gate_count);
+
+	for (uint32_t part_idx = 0; part_idx < part_count; ++part_idx) {
+		auto& part = partitions.emplace_back();
+		part.gate_begin  = (uint32_t)((uint64_t)gate_count * part_idx / part_count);
+		part.gate_end    = (uint32_t)((uint64_t)gate_count * (part_idx + 1) / part_count);
+		part.evaluations = 0;
+		part.net_changes = 0;
+		part.posted      = false;
+		part.target_senders.store(0, std::memory_order_relaxed);
+		part.drive_senders.store(0, std::memory_order_relaxed);
+
+		std::fill(gate_parts.begin() + part.gate_begin, gate_parts.begin() + part.gate_end, part_idx);
+	}
+
+	std::vector<uint32_t> fanout_offsets(net_count + 1, 0);
+
+	net_owners.assign(net_count, UINT32_MAX);
+
+	for (auto old_idx : order) {
+		const auto& src = flat_gates[old_idx];
+
+		auto net_end = old_idx + 1 < gate_count ?
+			flat_gates[old_idx + 1].net_begin : (uint32_t)flat_gate_nets.size();
+		auto part_idx = gate_parts[gates.size()];
+
+		source_gates.emplace_back(old_idx);
+
+		auto& gate = gates.emplace_back();
+		gate.shared    = src.shared;
+		gate.pins      = 0;
+		gate.known     = 0;
+		gate.net_begin = (uint32_t)gate_nets.size();
+		gate.instance  = 0;
+
+		gate_nets.insert(gate_nets.end(),
+			flat_gate_nets.begin() + src.net_begin,
+			flat_gate_nets.begin() + net_end);
+
+		for (auto bits = gate.shared->output_mask; bits; bits &= bits - 1) {
+			auto net = gate_nets[gate.net_begin + count_trailing_zeros(bits)];
+
+			if (net != INVALID_NET_ID && net_owners[net] == UINT32_MAX)
+				net_owners[net] = part_idx;
+		}
+
+		for (auto bits = gate.shared->input_mask; bits; bits &= bits - 1) {
+			auto net = gate_nets[gate.net_begin + count_trailing_zeros(bits)];
+
+			if (net != INVALID_NET_ID)
+				++fanout_offsets[net + 1];
+		}
+	}
+
+	// the bits of a word go to the owner of its first driven bit
+	simulator.flattenWords(word_offsets, word_nets);
+
+	auto word_count = (uint32_t)word_offsets.size() - 1;
+
+	net_words.assign(net_count, INVALID_WORD_ID);
+	net_word_bits.assign(net_count, 0);
+
+	for (uint32_t word = 0; word < word_count; ++word) {
+		auto owner = UINT32_MAX;
+
+		for (auto i = word_offsets[word]; i < word_offsets[word + 1]; ++i) {
+			auto net = word_nets[i];
+
+			net_words[net]     = word;
+			net_word_bits[net] = (uint8_t)(i - word_offsets[word]);
+
+			if (owner == UINT32_MAX)
+				owner = net_owners[net];
+		}
+
+		for (auto i = word_offsets[word]; i < word_offsets[word + 1]; ++i)
+			net_owners[word_nets[i]] = owner;
+	}
+
+	// undriven nets only change through setNet
+	for (auto& owner : net_owners)
+		if (owner == UINT32_MAX) owner = 0;
+
+	for (size_t i = 0; i < net_count; ++i)
+		fanout_offsets[i + 1] += fanout_offsets[i];
+
+	fanouts.resize(fanout_offsets.back());
+
+	std::vector<uint32_t> cursor(fanout_offsets.begin(), fanout_offsets.end() - 1);
+
+	for (uint32_t gate_idx = 0; gate_idx < gates.size(); ++gate_idx) {
+		auto& gate = gates[gate_idx];
+
+		for (auto bits = gate.shared->input_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto net = gate_nets[gate.net_begin + pin];
+
+			if (net != INVALID_NET_ID)
+				fanouts[cursor[net]++] = { gate_idx, pin };
+		}
+	}
+
+	// fanouts of a net are sorted by gate, so the ones in the same partition are contiguous.
+	// a bit of a word only has the targets of its word
+	target_offsets.resize(net_count + 1);
+
+	for (net_id_t net = 0; net < net_count; ++net) {
+		target_offsets[net] = (uint32_t)targets.size();
+
+		if (net_words[net] != INVALID_WORD_ID) continue;
+
+		for (auto i = fanout_offsets[net]; i < fanout_offsets[net + 1];) {
+			auto part_idx = gate_parts[fanouts[i].gate];
+			auto end      = i + 1;
+
+			while (end < fanout_offsets[net + 1] && gate_parts[fanouts[end].gate] == part_idx)
+				++end;
+
+			targets.push_back({ net, part_idx, i, end, INVALID_WORD_ID });
+			i = end;
+		}
+	}
+
+	target_offsets[net_count] = (uint32_t)targets.size();
+
+	std::vector<uint32_t> word_fanout_offsets;
+	build_word_fanouts(word_offsets, word_nets, fanout_offsets, fanouts, word_fanout_offsets, word_fanouts);
+
+	word_target_offsets.resize(word_count + 1);
+
+	for (uint32_t word = 0; word < word_count; ++word) {
+		word_target_offsets[word] = (uint32_t)targets.size();
+
+		for (auto i = word_fanout_offsets[word]; i < word_fanout_offsets[word + 1];) {
+			auto part_idx = gate_parts[word_fanouts[i].gate];
+			auto end      = i + 1;
+
+			while (end < word_fanout_offsets[word + 1] && gate_parts[word_fanouts[end].gate] == part_idx)
+				++end;
+
+			targets.push_back({ INVALID_NET_ID, part_idx, i, end, word });
+			i = end;
+		}
+	}
+
+	word_target_offsets[word_count] = (uint32_t)targets.size();
+
+	mailboxes.resize(part_count * part_count);
+	drives.resize(part_count * part_count);
+
+	net_values.resize(net_count);
+	net_pushed.resize(net_count);
+	net_prev.resize(net_count);
+	gate_pushed.resize(gates.size());
+	driver_counts.resize(net_count);
+	constant_counts = simulator.constant_counts;
+	word_values.resize(word_count);
+	word_known.resize(word_count);
+	word_changed.resize(word_count);
+
+	startThreads(thread_count);
+	reset();
+}
+
+void ParallelSimulator::clear()
+{
+	stopThreads();
+
+	gates.clear();
+	gate_nets.clear();
+	fanouts.clear();
+	target_offsets.clear();
+	targets.clear();
+	net_owners.clear();
+	source_gates.clear();
+	word_offsets.clear();
+	word_nets.clear();
+	word_fanouts.clear();
+	word_target_offsets.clear();
+	net_words.clear();
+	net_word_bits.clear();
+	net_values.clear();
+	net_pushed.clear();
+	net_prev.clear();
+	gate_pushed.clear();
+	driver_counts.clear();
+	constant_counts.clear();
+	word_values.clear();
+	word_known.clear();
+	word_changed.clear();
+	partitions.clear();
+	mailboxes.clear();
+	drives.clear();
+	toggle_counts.clear();
+	evaluation_counts.clear();
+
+	tick_accum        = 0.f;
+	tick              = 0;
+	stable            = true;
+	counting_activity = false;
+}
+
+void ParallelSimulator::reset()
+{
+	restore({}, 0);
+}
+
+void ParallelSimulator::restore(const std::vector<uint8_t>& values, uint64_t start_tick)
+{
+	auto value_of = [&](net_id_t net) {
+		return net < values.size() ? (LogicValue)values[net] : Logic_X;
+	};
+
+	std::copy(constant_counts.begin(), constant_counts.end(), driver_counts.begin());
+	std::fill(net_pushed.begin(), net_pushed.end(), 0);
+
+	for (auto& gate : gates) {
+		gate.pins  = 0;
+		gate.known = 0;
+
+		for (auto bits = gate.shared->output_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto net = gate_nets[gate.net_begin + pin];
+
+			if (net == INVALID_NET_ID) continue;
+
+			auto value = value_of(net);
+
+			if (value == Logic_Z)
+				value = Logic_X;
+
+			++driver_counts[net].counts[value];
+			gate.pins  |= (uint64_t)(value & 1) << pin;
+			gate.known |= (uint64_t)(value >> 1) << pin;
+		}
+	}
+
+	for (net_id_t net = 0; net < net_values.size(); ++net) {
+		net_values[net] = driver_counts[net].resolve();
+
+		if (net_values[net] == Logic_Z && value_of(net) != Logic_X)
+			net_values[net] = value_of(net);
+	}
+
+	for (auto& mailbox : mailboxes)
+		mailbox.clear();
+
+	for (auto& inbox : drives)
+		inbox.clear();
+
+	syncWords();
+
+	for (auto& part : partitions) {
+		part.active_gates.clear();
+		part.changed_nets.clear();
+		part.target_senders.store(0, std::memory_order_relaxed);
+		part.drive_senders.store(0, std::memory_order_relaxed);
+		part.evaluations = 0;
+		part.net_changes = 0;
+		part.posted      = false;
+
+		for (auto gate_idx = part.gate_begin; gate_idx < part.gate_end; ++gate_idx) {
+			auto& gate = gates[gate_idx];
+
+			for (auto bits = gate.shared->input_mask; bits; bits &= bits - 1) {
+				auto pin = count_trailing_zeros(bits);
+				auto net = gate_nets[gate.net_begin + pin];
+
+				if (net == INVALID_NET_ID) continue;
+
+				gate.pins  |= (uint64_t)(net_values[net] & 1) << pin;
+				gate.known |= (uint64_t)(net_values[net] >> 1) << pin;
+			}
+
+			gate_pushed[gate_idx] = true;
+			part.active_gates.emplace_back(gate_idx);
+		}
+	}
+
+	tick_accum = 0.f;
+	tick       = start_tick;
+	stable     = gates.empty();
+
+	if (recorder)
+		recorder->captureAll(tick, net_values);
+
+	if (breakpoints)
+		breakpoints->sync(net_values);
+
+	if (changes)
+		changes->addAll();
+}
+
+void ParallelSimulator::step()
+{
+	if (!gates.empty()) {
+		runPhase(Phase::Evaluate);
+		runPhase(Phase::Resolve);
+	}
+
+	stable = std::none_of(partitions.begin(), partitions.end(), [](const auto& part) { return part.posted; });
+
+	++tick;
+
+	if (recorder && !gates.empty())
+		for (const auto& part : partitions)
+			recorder->capture(tick, part.changed_nets, net_values);
+
+	// all partitions are marked first, a bus can change in several of them
+	if (breakpoints && !gates.empty()) {
+		for (const auto& part : partitions)
+			breakpoints->mark(part.changed_nets);
+
+		breakpoints->evaluate(tick, net_values);
+	}
+
+	if (changes && !gates.empty())
+		for (const auto& part : partitions)
+			changes->add(part.changed_nets);
+}
+
+void ParallelSimulator::advance(uint64_t ticks)
+{
+	for (uint64_t i = 0; i < ticks; ++i) {
+		if (isStable()) {
+			tick += ticks - i;
+			break;
+		}
+
+		step();
+
+		if (breakpoints && breakpoints->isHit()) break;
+	}
+}
+
+uint64_t ParallelSimulator::update(float dt, uint64_t max_ticks)
+{
+	tick_accum += dt * tick_rate;
+
+	auto count = (uint64_t)tick_accum;
+
+	if (count > MAX_TICKS_PER_UPDATE) {
+		count      = MAX_TICKS_PER_UPDATE;
+		tick_accum = 0.f;
+	} else {
+		tick_accum -= (float)count;
+	}
+
+	if (count > max_ticks) {
+		tick_accum += (float)(count - max_ticks);
+		count       = max_ticks;
+	}
+
+	advance(count);
+
+	return count;
+}
+
+void ParallelSimulator::setCountingActivity(bool counting)
+{
+	counting_activity = counting;
+
+	toggle_counts.assign(counting ? net_values.size() : 0, 0);
+	evaluation_counts.assign(counting ? gates.size() : 0, 0);
+}
+
+bool ParallelSimulator::isCountingActivity() const
+{
+	return counting_activity;
+}
+
+void ParallelSimulator::collectActivity(ActivityCounters& counters)
+{
+	counters.net_toggles.resize(net_values.size(), 0);
+	counters.gate_evaluations.resize(gates.size(), 0);
+
+	if (!counting_activity) return;
+
+	for (size_t net = 0; net < toggle_counts.size(); ++net) {
+		counters.net_toggles[net] += toggle_counts[net];
+		toggle_counts[net] = 0;
+	}
+
+	for (size_t gate_idx = 0; gate_idx < evaluation_counts.size(); ++gate_idx) {
+		counters.gate_evaluations[source_gates[gate_idx]] += evaluation_counts[gate_idx];
+		evaluation_counts[gate_idx] = 0;
+	}
+}
+
+void ParallelSimulator::setTickRate(float tick_rate)
+{
+	this->tick_rate = std::max(tick_rate, 0.f);
+}
+
+float ParallelSimulator::getTickRate() const
+{
+	return tick_rate;
+}
+
+void ParallelSimulator::setRecorder(WaveformRecorder* recorder)
+{
+	this->recorder = recorder;
+}
+
+void ParallelSimulator::setBreakpoints(Breakpoints* breakpoints)
+{
+	this->breakpoints = breakpoints;
+}
+
+void ParallelSimulator::setChangeSet(NetChangeSet* changes)
+{
+	this->changes = changes;
+}
+
+// between steps the pending work is the partitions' active gates and the posted targets
+void ParallelSimulator::saveState(std::vector<uint8_t>& state) const
+{
+	state.clear();
+
+	write_state(state, (uint64_t)gates.size());
+	write_state(state, (uint64_t)net_values.size());
+	write_state(state, (uint64_t)partitions.size());
+	write_state(state, tick);
+	write_state(state, (uint8_t)stable);
+
+	for (const auto& gate : gates) {
+		write_state(state, gate.pins);
+		write_state(state, gate.known);
+	}
+
+	write_state_array(state, net_values);
+	write_state_array(state, driver_counts);
+	write_state_array(state, word_changed);
+
+	for (const auto& part : partitions)
+		write_state(state, (uint8_t)part.posted);
+
+	for (const auto& part : partitions)
+		write_state_array(state, part.active_gates);
+
+	for (const auto& mailbox : mailboxes)
+		write_state_array(state, mailbox);
+}
+
+bool ParallelSimulator::loadState(const std::vector<uint8_t>& state)
+{
+	StateReader reader(state);
+
+	uint64_t gate_count, net_count, part_count;
+
+	if (!reader.read(gate_count) || gate_count != gates.size()) return false;
+	if (!reader.read(net_count) || net_count != net_values.size()) return false;
+	if (!reader.read(part_count) || part_count != partitions.size()) return false;
+
+	auto load = [&]() {
+		uint8_t flag;
+
+		if (!reader.read(tick) || !reader.read(flag)) return false;
+		stable = flag;
+
+		for (auto& gate : gates)
+			if (!reader.read(gate.pins) || !reader.read(gate.known)) return false;
+
+		if (!reader.readArray(net_values, net_count)) return false;
+		if (!reader.readArray(driver_counts, net_count)) return false;
+
+		std::vector<uint64_t> changed;
+
+		if (!reader.readArray(changed, word_changed.size())) return false;
+
+		syncWords();
+
+		for (auto& part : partitions) {
+			if (!reader.read(flag)) return false;
+			part.posted = flag;
+		}
+
+		// the posted words wait in the mailboxes with the bits they changed
+		for (uint32_t word = 0; word < changed.size(); ++word) {
+			if (!changed[word]) continue;
+
+			word_changed[word] = changed[word];
+			partitions[net_owners[word_nets[word_offsets[word]]]].changed_words.emplace_back(word);
+		}
+
+		std::fill(net_pushed.begin(), net_pushed.end(), 0);
+		std::fill(gate_pushed.begin(), gate_pushed.end(), 0);
+
+		for (auto& part : partitions) {
+			part.changed_nets.clear();
+			part.target_senders.store(0, std::memory_order_relaxed);
+			part.drive_senders.store(0, std::memory_order_relaxed);
+
+			if (!reader.readArray(part.active_gates)) return false;
+
+			for (auto gate_idx : part.active_gates) {
+				if (gate_idx < part.gate_begin || gate_idx >= part.gate_end) return false;
+				gate_pushed[gate_idx] = true;
+			}
+		}
+
+		for (auto& inbox : drives)
+			inbox.clear();
+
+		for (uint32_t idx = 0; idx < mailboxes.size(); ++idx) {
+			auto& mailbox = mailboxes[idx];
+
+			if (!reader.readArray(mailbox)) return false;
+
+			for (auto target_idx : mailbox)
+				if (target_idx >= targets.size() || targets[target_idx].partition != idx % part_count) return false;
+
+			if (!mailbox.empty())
+				partitions[idx % part_count].target_senders.fetch_or(1ull << (idx / part_count), std::memory_order_relaxed);
+		}
+
+		return true;
+	};
+
+	tick_accum = 0.f;
+
+	if (load()) {
+		if (changes)
+			changes->addAll();
+
+		return true;
+	}
+
+	reset();
+	return false;
+}
+
+void ParallelSimulator::setNet(net_id_t net, LogicValue value)
+{
+	if (net_values[net] == value) return;
+
+	net_values[net] = value;
+
+	if (net_words[net] == INVALID_WORD_ID)
+		postNet(net_owners[net], net);
+	else if (setWordBit(net_owners[net], net))
+		postWord(net_owners[net], net_words[net]);
+
+	stable = false;
+
+	if (counting_activity)
+		++toggle_counts[net];
+
+	if (recorder)
+		recorder->capture(tick, net, value);
+
+	if (breakpoints)
+		breakpoints->check(tick, net, net_values);
+
+	if (changes)
+		changes->add(net);
+}
+
+LogicValue ParallelSimulator::getNet(net_id_t net) const
+{
+	return (LogicValue)net_values[net];
+}
+
+const std::vector<uint8_t>& ParallelSimulator::getNetValues() const
+{
+	return net_values;
+}
+
+bool ParallelSimulator::isStable() const
+{
+	return stable;
+}
+
+uint64_t ParallelSimulator::getTick() const
+{
+	return tick;
+}
+
+uint64_t ParallelSimulator::getEventCount() const
+{
+	uint64_t count = 0;
+
+	for (const auto& part : partitions)
+		count += part.evaluations;
+
+	return count;
+}
+
+uint64_t ParallelSimulator::getNetChangeCount() const
+{
+	uint64_t count = 0;
+
+	for (const auto& part : partitions)
+		count += part.net_changes;
+
+	return count;
+}
+
+uint32_t ParallelSimulator::getThreadCount() const
+{
+	return std::max((uint32_t)queues.size(), 1u);
+}
+
+size_t ParallelSimulator::getPartitionCount() const
+{
+	return partitions.size();
+}
+
+size_t ParallelSimulator::getGateCount() const
+{
+	return gates.size();
+}
+
+size_t ParallelSimulator::getNetCount() const
+{
+	return net_values.size();
+}
+
+void ParallelSimulator::startThreads(uint32_t thread_count)
+{
+	thread_count = std::clamp<uint32_t>(thread_count, 1, (uint32_t)partitions.size());
+
+	// each worker starts on a contiguous run of partitions and steals from the others once it's done
+	for (uint32_t worker = 0; worker < thread_count; ++worker) {
+		auto& queue = queues.emplace_back();
+		queue.begin = (uint32_t)(partitions.size() * worker / thread_count);
+		queue.end   = (uint32_t)(partitions.size() * (worker + 1) / thread_count);
+		queue.next.store(queue.end, std::memory_order_relaxed);
+	}
+
+	generation.store(0);
+	pending.store(0);
+	sleepers.store(0);
+
+	for (uint32_t worker = 1; worker < thread_count; ++worker)
+		threads.emplace_back(&ParallelSimulator::workerMain, this, worker, 0u);
+}
+
+void ParallelSimulator::stopThreads()
+{
+	if (!threads.empty()) {
+		phase = Phase::Quit;
+		generation.fetch_add(1);
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			cv.notify_all();
+		}
+
+		for (auto& thread : threads)
+			thread.join();
+
+		threads.clear();
+	}
+
+	queues.clear();
+}
+
+void ParallelSimulator::runPhase(Phase phase)
+{
+	this->phase = phase;
+
+	for (auto& queue : queues)
+		queue.next.store(queue.begin, std::memory_order_relaxed);
+
+	if (threads.empty()) {
+		work(0);
+		return;
+	}
+
+	pending.store((uint32_t)threads.size(), std::memory_order_relaxed);
+	generation.fetch_add(1);
+
+	if (sleepers.load()) {
+		std::lock_guard<std::mutex> lock(mutex);
+		cv.notify_all();
+	}
+
+	work(0);
+
+	while (pending.load(std::memory_order_acquire))
+		std::this_thread::yield();
+}
+
+void ParallelSimulator::work(uint32_t worker)
+{
+	auto queue_count = (uint32_t)queues.size();
+
+	for (uint32_t i = 0; i < queue_count; ++i) {
+		auto& queue = queues[(worker + i) % queue_count];
+
+		for (uint32_t part_idx; (part_idx = queue.next.fetch_add(1, std::memory_order_relaxed)) < queue.end;) {
+			if (phase == Phase::Evaluate)
+				evaluatePartition(part_idx);
+			else
+				resolvePartition(part_idx);
+		}
+	}
+}
+
+void ParallelSimulator::workerMain(uint32_t worker, uint32_t generation)
+{
+	while (true) {
+		generation = waitGeneration(generation);
+
+		if (phase == Phase::Quit) return;
+
+		work(worker);
+		pending.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+uint32_t ParallelSimulator::waitGeneration(uint32_t seen)
+{
+	for (uint32_t spin = 0;; ++spin) {
+		auto curr = generation.load(std::memory_order_acquire);
+
+		if (curr != seen) return curr;
+
+		if (spin < WORKER_SPIN_COUNT) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// runPhase bumps the generation before it checks for sleepers
+		sleepers.fetch_add(1);
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait(lock, [&]() { return generation.load() != seen; });
+		}
+
+		sleepers.fetch_sub(1);
+	}
+}
+
+void ParallelSimulator::evaluatePartition(uint32_t part_idx)
+{
+	auto& part      = partitions[part_idx];
+	auto part_count = (uint32_t)partitions.size();
+
+	// senders are visited in partition order, so activation order doesn't depend on scheduling
+	for (auto senders = part.target_senders.exchange(0, std::memory_order_relaxed); senders; senders &= senders - 1) {
+		auto& mailbox = mailboxes[count_trailing_zeros(senders) * part_count + part_idx];
+
+		for (auto target_idx : mailbox) {
+			const auto& target = targets[target_idx];
+
+			if (target.word != INVALID_WORD_ID) {
+				evaluateWordTarget(part_idx, target);
+				continue;
+			}
+
+			uint64_t value = net_values[target.net] & 1;
+			uint64_t known = net_values[target.net] >> 1;
+
+			for (auto i = target.fanout_begin; i < target.fanout_end; ++i) {
+				auto [gate_idx, pin] = fanouts[i];
+				auto& gate = gates[gate_idx];
+
+				gate.pins  = (gate.pins & ~(1ull << pin)) | (value << pin);
+				gate.known = (gate.known & ~(1ull << pin)) | (known << pin);
+
+				if (!gate_pushed[gate_idx]) {
+					gate_pushed[gate_idx] = true;
+					part.active_gates.emplace_back(gate_idx);
+				}
+			}
+		}
+
+		mailbox.clear();
+	}
+
+	for (auto gate_idx : part.active_gates) {
+		gate_pushed[gate_idx] = false;
+		evaluateGate(part_idx, gate_idx);
+	}
+
+	if (counting_activity)
+		for (auto gate_idx : part.active_gates)
+			++evaluation_counts[gate_idx];
+
+	part.evaluations += part.active_gates.size();
+	part.active_gates.clear();
+}
+
+void ParallelSimulator::resolvePartition(uint32_t part_idx)
+{
+	auto& part      = partitions[part_idx];
+	auto part_count = (uint32_t)partitions.size();
+
+	// kept until the next resolve so step can hand them to the recorder
+	part.changed_nets.clear();
+
+	// the evaluate phase has read the words posted before
+	for (auto word : part.changed_words)
+		word_changed[word] = 0;
+
+	part.changed_words.clear();
+
+	for (auto senders = part.drive_senders.exchange(0, std::memory_order_relaxed); senders; senders &= senders - 1) {
+		auto& inbox = drives[count_trailing_zeros(senders) * part_count + part_idx];
+
+		for (auto [net, from, to] : inbox) {
+			auto& counts = driver_counts[net];
+			counts.move(from, to);
+
+			auto value = counts.resolve();
+
+			if (net_values[net] == value) continue;
+
+			if (!net_pushed[net]) {
+				net_pushed[net] = true;
+				net_prev[net]   = net_values[net];
+				part.changed_nets.emplace_back(net);
+			}
+
+			net_values[net] = value;
+		}
+
+		inbox.clear();
+	}
+
+	// a net whose drivers moved away and back within the tick did not change, as in Simulator
+	part.changed_nets.erase(std::remove_if(part.changed_nets.begin(), part.changed_nets.end(), [&](net_id_t net) {
+		net_pushed[net] = false;
+		return net_values[net] == net_prev[net];
+	}), part.changed_nets.end());
+
+	part.posted       = false;
+	part.net_changes += part.changed_nets.size();
+
+	// only the owner of a net resolves it
+	if (counting_activity)
+		for (auto net : part.changed_nets)
+			++toggle_counts[net];
+
+	for (auto net : part.changed_nets) {
+		if (net_words[net] == INVALID_WORD_ID)
+			postNet(part_idx, net);
+		else
+			setWordBit(part_idx, net);
+	}
+
+	for (auto word : part.changed_words)
+		postWord(part_idx, word);
+}
+
+// one update per run of pins reading bits the word changed
+void ParallelSimulator::evaluateWordTarget(uint32_t part_idx, const Target& target)
+{
+	auto& part   = partitions[part_idx];
+	auto changed = word_changed[target.word];
+	auto value   = word_values[target.word];
+	auto known   = word_known[target.word];
+
+	for (auto i = target.fanout_begin; i < target.fanout_end; ++i) {
+		const auto& fanout = word_fanouts[i];
+
+		if (!((changed >> fanout.bit) & fanout.mask)) continue;
+
+		auto pins = fanout.mask << fanout.pin;
+		auto& gate = gates[fanout.gate];
+
+		gate.pins  = (gate.pins & ~pins) | (((value >> fanout.bit) & fanout.mask) << fanout.pin);
+		gate.known = (gate.known & ~pins) | (((known >> fanout.bit) & fanout.mask) << fanout.pin);
+
+		if (!gate_pushed[fanout.gate]) {
+			gate_pushed[fanout.gate] = true;
+			part.active_gates.emplace_back(fanout.gate);
+		}
+	}
+}
+
+void ParallelSimulator::evaluateGate(uint32_t part_idx, uint32_t gate_idx)
+{
+	auto& gate   = gates[gate_idx];
+	auto& shared = *gate.shared;
+
+	uint64_t outputs;
+	uint64_t known = gate.known;
+
+	if (!(~gate.known & (shared.input_mask | shared.output_mask))) {
+		outputs = shared.evaluate(shared, gate.pins);
+		known   = ~0ull;
+	} else {
+		outputs = shared.logic.evaluateUnknown(gate.pins, known);
+	}
+
+	outputs &= known;
+
+	auto changed = ((outputs ^ gate.pins) | (known ^ gate.known)) & shared.output_mask;
+
+	for (auto bits = changed; bits; bits &= bits - 1) {
+		auto pin = count_trailing_zeros(bits);
+		auto net = gate_nets[gate.net_begin + pin];
+
+		if (net == INVALID_NET_ID) continue;
+
+		auto owner = net_owners[net];
+		auto& outbox = drives[part_idx * partitions.size() + owner];
+
+		if (outbox.empty())
+			partitions[owner].drive_senders.fetch_or(1ull << part_idx, std::memory_order_relaxed);
+
+		outbox.push_back({ net, get_logic_value(gate.pins, gate.known, pin), get_logic_value(outputs, known, pin) });
+	}
+
+	gate.pins  ^= (outputs ^ gate.pins) & shared.output_mask;
+	gate.known ^= (known ^ gate.known) & shared.output_mask;
+}
+
+void ParallelSimulator::postNet(uint32_t part_idx, net_id_t net)
+{
+	postTargets(part_idx, target_offsets[net], target_offsets[net + 1]);
+}
+
+void ParallelSimulator::postWord(uint32_t part_idx, uint32_t word)
+{
+	postTargets(part_idx, word_target_offsets[word], word_target_offsets[word + 1]);
+}
+
+void ParallelSimulator::postTargets(uint32_t part_idx, uint32_t target_begin, uint32_t target_end)
+{
+	auto part_count = (uint32_t)partitions.size();
+
+	for (auto target_idx = target_begin; target_idx < target_end; ++target_idx) {
+		auto to = targets[target_idx].partition;
+		auto& mailbox = mailboxes[part_idx * part_count + to];
+
+		if (mailbox.empty())
+			partitions[to].target_senders.fetch_or(1ull << part_idx, std::memory_order_relaxed);
+
+		mailbox.emplace_back(target_idx);
+		partitions[part_idx].posted = true;
+	}
+}
+
+// true if the word was not changed before, it is then posted by the partition that owns it
+bool ParallelSimulator::setWordBit(uint32_t part_idx, net_id_t net)
+{
+	auto word  = net_words[net];
+	auto bit   = 1ull << net_word_bits[net];
+	auto value = net_values[net];
+	auto first = !word_changed[word];
+
+	if (first)
+		partitions[part_idx].changed_words.emplace_back(word);
+
+	word_changed[word] |= bit;
+	word_values[word]   = (value & 1) ? word_values[word] | bit : word_values[word] & ~bit;
+	word_known[word]    = (value >> 1) ? word_known[word] | bit : word_known[word] & ~bit;
+
+	return first;
+}
+
+// the planes of every word from its bit nets, none of them changed
+void ParallelSimulator::syncWords()
+{
+	std::fill(word_values.begin(), word_values.end(), 0);
+	std::fill(word_known.begin(), word_known.end(), 0);
+	std::fill(word_changed.begin(), word_changed.end(), 0);
+
+	for (auto& part : partitions)
+		part.changed_words.clear();
+
+	for (uint32_t word = 0; word < word_values.size(); ++word) {
+		for (auto i = word_offsets[word]; i < word_offsets[word + 1]; ++i) {
+			auto bit   = i - word_offsets[word];
+			auto value = net_values[word_nets[i]];
+
+			word_values[word] |= (uint64_t)(value & 1) << bit;
+			word_known[word]  |= (uint64_t)(value >> 1) << bit;
+		}
+	}
+}
\ No newline at end of file
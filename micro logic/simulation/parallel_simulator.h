@@ -0,0 +1,173 @@
+#pragma once
+
+#include "simulator.h"
+#include "breakpoints.h"
+#include "waveform_recorder.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#define MAX_SIMULATION_PARTITIONS 64
+#define SIMULATION_PARTITION_GATES 4096
+#define WORKER_SPIN_COUNT 4096
+
+// same tick semantics as Simulator, run on a work stealing thread pool.
+// gates are levelized and cut into partitions whose count depends only on the circuit,
+// every tick is an evaluate and a resolve phase separated by barriers,
+// so results don't depend on the thread count or on which thread runs which partition.
+// the bits of a word are resolved by one partition, which posts the word once per tick.
+// gate delays are not modeled, every output changes one tick after its inputs
+class ParallelSimulator {
+public:
+	ParallelSimulator();
+	~ParallelSimulator();
+
+	void build(const Simulator& simulator, uint32_t thread_count);
+	void clear();
+	void reset();
+	void restore(const std::vector<uint8_t>& values, uint64_t start_tick); // see Simulator::restore
+
+	void step();
+	void advance(uint64_t ticks);
+	uint64_t update(float dt, uint64_t max_ticks = MAX_TICKS_PER_UPDATE);
+
+	void setTickRate(float tick_rate);
+	float getTickRate() const;
+
+	void setRecorder(WaveformRecorder* recorder);
+	void setBreakpoints(Breakpoints* breakpoints);
+	void setChangeSet(NetChangeSet* changes);
+
+	// as Simulator, the gates are counted in its order. the partitions count their own gates
+	// and resolved nets, so the workers never write the same counter
+	void setCountingActivity(bool counting);
+	bool isCountingActivity() const;
+	void collectActivity(ActivityCounters& counters);
+
+	// everything that changes while simulating, loadState fails on a state of another circuit
+	void saveState(std::vector<uint8_t>& state) const;
+	bool loadState(const std::vector<uint8_t>& state);
+
+	void setNet(net_id_t net, LogicValue value);
+	LogicValue getNet(net_id_t net) const;
+	const std::vector<uint8_t>& getNetValues() const;
+
+	bool isStable() const;
+	uint64_t getTick() const;
+	uint64_t getEventCount() const;
+	uint64_t getNetChangeCount() const;
+	uint32_t getThreadCount() const;
+	size_t getPartitionCount() const;
+	size_t getGateCount() const;
+	size_t getNetCount() const;
+
+private:
+	enum class Phase {
+		Evaluate,
+		Resolve,
+		Quit
+	};
+
+	struct Drive {
+		net_id_t   net;
+		LogicValue from;
+		LogicValue to;
+	};
+
+	struct Target {
+		net_id_t net;
+		uint32_t partition;
+		uint32_t fanout_begin;
+		uint32_t fanout_end;
+		uint32_t word; // INVALID_WORD_ID for a net, else the fanouts are word_fanouts
+	};
+
+	struct alignas(64) Partition {
+		uint32_t              gate_begin;
+		uint32_t              gate_end;
+		std::vector<uint32_t> active_gates;
+		std::vector<net_id_t> changed_nets;
+		std::vector<uint32_t> changed_words; // posted by the last resolve or setNet
+		std::atomic<uint64_t> target_senders; // partitions that posted targets to this one
+		std::atomic<uint64_t> drive_senders;  // partitions that sent drives to this one
+		uint64_t              evaluations;
+		uint64_t              net_changes;
+		bool                  posted;
+	};
+
+	struct alignas(64) WorkQueue {
+		std::atomic<uint32_t> next;
+		uint32_t              begin;
+		uint32_t              end;
+	};
+
+	void startThreads(uint32_t thread_count);
+	void stopThreads();
+	void runPhase(Phase phase);
+	void work(uint32_t worker);
+	void workerMain(uint32_t worker, uint32_t generation);
+	uint32_t waitGeneration(uint32_t seen);
+
+	void evaluatePartition(uint32_t part_idx);
+	void resolvePartition(uint32_t part_idx);
+	void evaluateGate(uint32_t part_idx, uint32_t gate_idx);
+	void evaluateWordTarget(uint32_t part_idx, const Target& target);
+	void postNet(uint32_t part_idx, net_id_t net);
+	void postWord(uint32_t part_idx, uint32_t word);
+	void postTargets(uint32_t part_idx, uint32_t target_begin, uint32_t target_end);
+	bool setWordBit(uint32_t part_idx, net_id_t net);
+	void syncWords();
+
+	std::vector<Simulator::Gate>   gates;
+	std::vector<net_id_t>          gate_nets;
+	std::vector<Simulator::Fanout> fanouts;
+	std::vector<uint32_t>          target_offsets; // CSR, targets of net n are targets[target_offsets[n]..target_offsets[n + 1]]
+	std::vector<Target>            targets;
+	std::vector<uint32_t>          net_owners;     // partition that resolves the drives of each net
+	std::vector<uint32_t>          source_gates;   // index of each gate in the Simulator
+
+	std::vector<uint32_t>               word_offsets; // CSR, bit n of word w is word_nets[word_offsets[w] + n]
+	std::vector<net_id_t>               word_nets;
+	std::vector<UnitModule::WordFanout> word_fanouts;
+	std::vector<uint32_t>               word_target_offsets; // CSR, like target_offsets for the words
+	std::vector<uint32_t>               net_words;           // INVALID_WORD_ID if the net has none
+	std::vector<uint8_t>                net_word_bits;
+
+	std::vector<uint8_t>      net_values; // LogicValue
+	std::vector<uint8_t>      net_pushed;
+	std::vector<uint8_t>      net_prev;   // value before the tick of the nets being resolved
+	std::vector<uint8_t>      gate_pushed;
+	std::vector<DriverCounts> driver_counts;
+	std::vector<DriverCounts> constant_counts;
+	std::vector<uint64_t>     word_values;
+	std::vector<uint64_t>     word_known;
+	std::vector<uint64_t>     word_changed; // bits changed in the tick the word was posted
+
+	std::deque<Partition>              partitions;
+	std::vector<std::vector<uint32_t>> mailboxes; // [from * partitions.size() + to], indices of targets
+	std::vector<std::vector<Drive>>    drives;    // [from * partitions.size() + to]
+
+	std::vector<std::thread> threads;
+	std::deque<WorkQueue>    queues;
+	std::mutex               mutex;
+	std::condition_variable  cv;
+	std::atomic<uint32_t>    generation;
+	std::atomic<uint32_t>    pending;
+	std::atomic<uint32_t>    sleepers;
+	Phase                    phase;
+
+	float    tick_rate;
+	float    tick_accum;
+	uint64_t tick;
+	bool     stable;
+
+	std::vector<uint32_t> toggle_counts;
+	std::vector<uint32_t> evaluation_counts; // in partition order
+	bool                  counting_activity;
+
+	WaveformRecorder* recorder;
+	Breakpoints*      breakpoints;
+	NetChangeSet*     changes;
+};
\ No newline at end of file
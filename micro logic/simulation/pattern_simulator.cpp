@@ -0,0 +1,217 @@
+#include "pattern_simulator.h"
+
+#include "../util/bit_utils.h"
+#include <algorithm>
+#include <cassert>
+
+PatternSimulator::PatternSimulator() :
+	step_count(0)
+{}
+
+bool PatternSimulator::build(const Simulator& simulator, std::string& error)
+{
+	clear();
+
+	std::vector<Simulator::Gate> flat_gates;
+
+	simulator.flatten(flat_gates, gate_nets, fanout_offsets, fanouts);
+
+	for (uint32_t gate_idx = 0; gate_idx < flat_gates.size(); ++gate_idx) {
+		const auto& src = flat_gates[gate_idx];
+
+		auto& gate = gates.emplace_back();
+		gate.logic       = &src.shared->logic;
+		gate.output_mask = src.shared->output_mask;
+		gate.net_begin   = src.net_begin;
+		gate.net_end     = gate_idx + 1 < flat_gates.size() ?
+			flat_gates[gate_idx + 1].net_begin : (uint32_t)gate_nets.size();
+
+		assert(gate.net_end - gate.net_begin <= MAX_LOGIC_REGISTERS);
+	}
+
+	// words carry plain 0/1 per pattern, a net with several drivers has no resolution
+	std::vector<uint32_t> driver_counts(simulator.getNetCount());
+
+	for (net_id_t net = 0; net < simulator.constant_counts.size(); ++net) {
+		const auto& counts = simulator.constant_counts[net].counts;
+
+		if (counts[Logic_0] && counts[Logic_1]) {
+			clear();
+			error = "net " + std::to_string(net) + " is tied to both VCC and GND";
+			return false;
+		}
+
+		driver_counts[net] = counts[Logic_0] || counts[Logic_1];
+
+		if (counts[Logic_1]) vcc_nets.emplace_back(net);
+	}
+
+	for (const auto& gate : gates) {
+		for (auto outputs = gate.output_mask & gate.logic->write_mask; outputs; outputs &= outputs - 1) {
+			auto net = gate_nets[gate.net_begin + count_trailing_zeros(outputs)];
+
+			if (net != INVALID_NET_ID && ++driver_counts[net] > 1) {
+				clear();
+				error = "net " + std::to_string(net) + " has more than one driver";
+				return false;
+			}
+		}
+	}
+
+	pin_values.resize(gate_nets.size());
+	net_values.resize(simulator.getNetCount());
+	net_pushed.resize(net_values.size());
+	gate_pushed.resize(gates.size());
+	regs.resize(MAX_LOGIC_REGISTERS);
+
+	reset();
+
+	return true;
+}
+
+void PatternSimulator::clear()
+{
+	gates.clear();
+	gate_nets.clear();
+	fanout_offsets.clear();
+	fanouts.clear();
+	vcc_nets.clear();
+	pin_values.clear();
+	net_values.clear();
+	net_pushed.clear();
+	gate_pushed.clear();
+	curr_nets.clear();
+	active_gates.clear();
+	regs.clear();
+
+	step_count = 0;
+}
+
+void PatternSimulator::reset()
+{
+	std::fill(pin_values.begin(), pin_values.end(), PatternWord());
+	std::fill(net_values.begin(), net_values.end(), PatternWord());
+	std::fill(net_pushed.begin(), net_pushed.end(), 0);
+	std::fill(gate_pushed.begin(), gate_pushed.end(), 0);
+
+	curr_nets.clear();
+	active_gates.clear();
+
+	// GND nets stay at the all-zero word
+	for (auto net : vcc_nets) {
+		net_values[net] = PatternWord(~0ull);
+		pushNet(net);
+	}
+
+	for (uint32_t gate_idx = 0; gate_idx < gates.size(); ++gate_idx)
+		pushGate(gate_idx);
+
+	step_count = 0;
+}
+
+void PatternSimulator::step()
+{
+	for (auto net : curr_nets) {
+		net_pushed[net] = false;
+
+		for (auto i = fanout_offsets[net]; i < fanout_offsets[net + 1]; ++i) {
+			auto [gate_idx, pin] = fanouts[i];
+
+			pin_values[gates[gate_idx].net_begin + pin] = net_values[net];
+			pushGate(gate_idx);
+		}
+	}
+
+	curr_nets.clear();
+
+	for (auto gate_idx : active_gates) {
+		gate_pushed[gate_idx] = false;
+		evaluateGate(gate_idx);
+	}
+
+	active_gates.clear();
+
+	++step_count;
+}
+
+bool PatternSimulator::settle(uint64_t max_steps)
+{
+	for (uint64_t i = 0; i < max_steps && !isStable(); ++i)
+		step();
+
+	return isStable();
+}
+
+void PatternSimulator::setNet(net_id_t net, const PatternWord& value)
+{
+	if (net_values[net] == value) return;
+
+	net_values[net] = value;
+	pushNet(net);
+}
+
+const PatternWord& PatternSimulator::getNet(net_id_t net) const
+{
+	return net_values[net];
+}
+
+bool PatternSimulator::isStable() const
+{
+	return curr_nets.empty() && active_gates.empty();
+}
+
+uint64_t PatternSimulator::getStepCount() const
+{
+	return step_count;
+}
+
+size_t PatternSimulator::getGateCount() const
+{
+	return gates.size();
+}
+
+size_t PatternSimulator::getNetCount() const
+{
+	return net_values.size();
+}
+
+void PatternSimulator::pushNet(net_id_t net)
+{
+	if (net_pushed[net]) return;
+
+	net_pushed[net] = true;
+	curr_nets.emplace_back(net);
+}
+
+void PatternSimulator::pushGate(uint32_t gate_idx)
+{
+	if (gate_pushed[gate_idx]) return;
+
+	gate_pushed[gate_idx] = true;
+	active_gates.emplace_back(gate_idx);
+}
+
+void PatternSimulator::evaluateGate(uint32_t gate_idx)
+{
+	auto& gate = gates[gate_idx];
+
+	std::copy(pin_values.begin() + gate.net_begin, pin_values.begin() + gate.net_end, regs.begin());
+
+	gate.logic->evaluateWords(regs.data());
+
+	for (auto outputs = gate.output_mask & gate.logic->write_mask; outputs; outputs &= outputs - 1) {
+		auto pin = count_trailing_zeros(outputs);
+		auto& value = pin_values[gate.net_begin + pin];
+
+		if (value == regs[pin]) continue;
+
+		value = regs[pin];
+
+		auto net = gate_nets[gate.net_begin + pin];
+
+		if (net != INVALID_NET_ID && net_values[net] != value) {
+			net_values[net] = value;
+			pushNet(net);
+		}
+	}
+}
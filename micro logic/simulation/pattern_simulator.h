@@ -0,0 +1,54 @@
+#pragma once
+
+#include "simulator.h"
+#include "pattern_word.h"
+
+#define MAX_PATTERN_STEPS 10000
+
+class PatternSimulator {
+public:
+	PatternSimulator();
+
+	bool build(const Simulator& simulator, std::string& error);
+	void clear();
+	void reset();
+
+	void step();
+	bool settle(uint64_t max_steps = MAX_PATTERN_STEPS);
+
+	void setNet(net_id_t net, const PatternWord& value);
+	const PatternWord& getNet(net_id_t net) const;
+
+	bool isStable() const;
+	uint64_t getStepCount() const;
+	size_t getGateCount() const;
+	size_t getNetCount() const;
+
+private:
+	struct Gate {
+		const LogicProgram* logic;
+		uint64_t            output_mask;
+		uint32_t            net_begin;
+		uint32_t            net_end;
+	};
+
+	void pushNet(net_id_t net);
+	void pushGate(uint32_t gate_idx);
+	void evaluateGate(uint32_t gate_idx);
+
+	std::vector<Gate>              gates;
+	std::vector<net_id_t>          gate_nets;
+	std::vector<uint32_t>          fanout_offsets;
+	std::vector<Simulator::Fanout> fanouts;
+	std::vector<net_id_t>          vcc_nets;
+
+	std::vector<PatternWord> pin_values; // indexed like gate_nets
+	std::vector<PatternWord> net_values;
+	std::vector<uint8_t>     net_pushed;
+	std::vector<uint8_t>     gate_pushed;
+	std::vector<net_id_t>    curr_nets;
+	std::vector<uint32_t>    active_gates;
+	std::vector<PatternWord> regs;
+
+	uint64_t step_count;
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#define PATTERN_WORD_LANES 4
+#define PATTERN_WORD_BITS (64 * PATTERN_WORD_LANES)
+
+// PATTERN_WORD_BITS independent logic values, pattern n is bit n % 64 of lanes[n / 64]
+struct alignas(32) PatternWord {
+	PatternWord() :
+		lanes{}
+	{}
+
+	explicit PatternWord(uint64_t lane) :
+		lanes{ lane, lane, lane, lane }
+	{}
+
+	static PatternWord counter(uint32_t bit, uint64_t base);
+
+	bool get(uint32_t pattern) const;
+	void set(uint32_t pattern, bool value);
+
+	uint64_t lanes[PATTERN_WORD_LANES];
+};
+
+#ifdef __AVX2__
+inline __m256i load_pattern(const PatternWord& w) {
+	return _mm256_load_si256((const __m256i*)w.lanes);
+}
+
+inline PatternWord store_pattern(__m256i v) {
+	PatternWord result;
+	_mm256_store_si256((__m256i*)result.lanes, v);
+	return result;
+}
+
+inline PatternWord operator&(const PatternWord& a, const PatternWord& b) {
+	return store_pattern(_mm256_and_si256(load_pattern(a), load_pattern(b)));
+}
+
+inline PatternWord operator|(const PatternWord& a, const PatternWord& b) {
+	return store_pattern(_mm256_or_si256(load_pattern(a), load_pattern(b)));
+}
+
+inline PatternWord operator^(const PatternWord& a, const PatternWord& b) {
+	return store_pattern(_mm256_xor_si256(load_pattern(a), load_pattern(b)));
+}
+
+inline PatternWord operator~(const PatternWord& a) {
+	return store_pattern(_mm256_xor_si256(load_pattern(a), _mm256_set1_epi64x(-1)));
+}
+
+inline bool operator==(const PatternWord& a, const PatternWord& b) {
+	auto diff = _mm256_xor_si256(load_pattern(a), load_pattern(b));
+	return _mm256_testz_si256(diff, diff);
+}
+#else
+inline PatternWord operator&(const PatternWord& a, const PatternWord& b) {
+	PatternWord result;
+	for (int i = 0; i < PATTERN_WORD_LANES; ++i)
+		result.lanes[i] = a.lanes[i] & b.lanes[i];
+	return result;
+}
+
+inline PatternWord operator|(const PatternWord& a, const PatternWord& b) {
+	PatternWord result;
+	for (int i = 0; i < PATTERN_WORD_LANES; ++i)
+		result.lanes[i] = a.lanes[i] | b.lanes[i];
+	return result;
+}
+
+inline PatternWord operator^(const PatternWord& a, const PatternWord& b) {
+	PatternWord result;
+	for (int i = 0; i < PATTERN_WORD_LANES; ++i)
+		result.lanes[i] = a.lanes[i] ^ b.lanes[i];
+	return result;
+}
+
+inline PatternWord operator~(const PatternWord& a) {
+	PatternWord result;
+	for (int i = 0; i < PATTERN_WORD_LANES; ++i)
+		result.lanes[i] = ~a.lanes[i];
+	return result;
+}
+
+inline bool operator==(const PatternWord& a, const PatternWord& b) {
+	uint64_t diff = 0;
+	for (int i = 0; i < PATTERN_WORD_LANES; ++i)
+		diff |= a.lanes[i] ^ b.lanes[i];
+	return diff == 0;
+}
+#endif
+
+inline bool operator!=(const PatternWord& a, const PatternWord& b) {
+	return !(a == b);
+}
+
+inline PatternWord PatternWord::counter(uint32_t bit, uint64_t base)
+{
+	PatternWord result;
+
+	for (uint32_t pattern = 0; pattern < PATTERN_WORD_BITS; ++pattern)
+		result.set(pattern, ((base + pattern) >> bit) & 1);
+
+	return result;
+}
+
+inline bool PatternWord::get(uint32_t pattern) const
+{
+	return (lanes[pattern / 64] >> (pattern % 64)) & 1;
+}
+
+inline void PatternWord::set(uint32_t pattern, bool value)
+{
+	auto& lane = lanes[pattern / 64];
+	lane = (lane & ~(1ull << (pattern % 64))) | ((uint64_t)value << (pattern % 64));
+}
@@ -0,0 +1,116 @@
+#include "simulation_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+double ScalingResult::getEventsPerSecond() const
+{
+	return seconds > 0.0 ? events / seconds : 0.0;
+}
+
+template <class Sim>
+static void settle(Sim& sim, uint64_t max_ticks)
+{
+	for (uint64_t i = 0; i < max_ticks && !sim.isStable(); ++i)
+		sim.step();
+}
+
+// calls func(vector) once settled after the reset and after each vector
+template <class Sim, class Func>
+static void run_round(Sim& sim, const std::vector<net_id_t>& inputs, uint64_t max_ticks, Func&& func)
+{
+	std::mt19937 rng(BENCHMARK_SEED);
+
+	sim.reset();
+	settle(sim, max_ticks);
+	func(0);
+
+	for (uint32_t vector = 1; vector <= BENCHMARK_VECTORS; ++vector) {
+		for (auto net : inputs)
+			sim.setNet(net, to_logic_value(rng() & 1));
+
+		settle(sim, max_ticks);
+		func(vector);
+	}
+}
+
+std::vector<ScalingResult> benchmark_scaling(
+	const Simulator& simulator,
+	const std::vector<uint32_t>& thread_counts,
+	uint64_t max_ticks)
+{
+	using clock_t = std::chrono::steady_clock;
+
+	std::vector<ScalingResult> results;
+
+	if (simulator.hasDelays()) return results;
+
+	Simulator reference = simulator;
+	reference.reset();
+
+	// nets nobody drives float after a reset
+	std::vector<net_id_t> inputs;
+
+	for (net_id_t net = 0; net < reference.getNetCount(); ++net)
+		if (reference.getNet(net) == Logic_Z)
+			inputs.emplace_back(net);
+
+	std::vector<std::vector<uint8_t>> reference_values;
+
+	run_round(reference, inputs, max_ticks, [&](uint32_t) {
+		reference_values.emplace_back(reference.getNetValues());
+	});
+
+	ParallelSimulator parallel;
+
+	for (auto thread_count : thread_counts) {
+		parallel.build(simulator, thread_count);
+
+		auto started = parallel.getThreadCount();
+
+		if (std::any_of(results.begin(), results.end(), [&](const auto& result) { return result.thread_count == started; }))
+			continue;
+
+		auto& result = results.emplace_back();
+		result.thread_count  = started;
+		result.ticks         = 0;
+		result.events        = 0;
+		result.seconds       = 0.0;
+		result.deterministic = true;
+
+		auto begin = clock_t::now();
+
+		do {
+			run_round(parallel, inputs, max_ticks, [&](uint32_t vector) {
+				result.deterministic = result.deterministic && parallel.getNetValues() == reference_values[vector];
+			});
+
+			result.ticks  += parallel.getTick();
+			result.events += parallel.getEventCount();
+			result.seconds = std::chrono::duration<double>(clock_t::now() - begin).count();
+		} while (result.seconds < BENCHMARK_MIN_SECONDS && result.ticks);
+	}
+
+	return results;
+}
+
+std::string format_scaling_results(const std::vector<ScalingResult>& results)
+{
+	std::string str;
+	char        line[128];
+
+	for (const auto& result : results) {
+		snprintf(line, sizeof(line), "%2u threads: %12.0f events/s, %8llu ticks in %.3fs%s\n",
+			result.thread_count,
+			result.getEventsPerSecond(),
+			(unsigned long long)result.ticks,
+			result.seconds,
+			result.deterministic ? "" : " (MISMATCH)");
+
+		str += line;
+	}
+
+	return str;
+}
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "parallel_simulator.h"
+#include <string>
+
+#define BENCHMARK_MAX_TICKS   10000
+#define BENCHMARK_MIN_SECONDS 0.5
+#define BENCHMARK_VECTORS     16
+#define BENCHMARK_SEED        1
+
+struct ScalingResult {
+	uint32_t thread_count; // the workers ParallelSimulator started, at most one per partition
+	uint64_t ticks;
+	uint64_t events; // gate evaluations
+	double   seconds;
+	bool     deterministic; // net values match the single threaded Simulator
+
+	double getEventsPerSecond() const;
+};
+
+// every round resets, settles and then drives BENCHMARK_VECTORS random vectors into the nets
+// that float after a reset, each run until stable or max_ticks. rounds repeat for at least
+// BENCHMARK_MIN_SECONDS. thread counts that start as many workers as an earlier one are
+// skipped, a circuit with delays gives no results as ParallelSimulator does not model them
+std::vector<ScalingResult> benchmark_scaling(
+	const Simulator& simulator,
+	const std::vector<uint32_t>& thread_counts,
+	uint64_t max_ticks = BENCHMARK_MAX_TICKS);
+
+std::string format_scaling_results(const std::vector<ScalingResult>& results);
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "simulation_history.h"
+
+#include <cassert>
+#include <cstring>
+
+static uint64_t load_word(const std::vector<uint8_t>& state, size_t word)
+{
+	uint64_t value = 0;
+	auto offset    = word * 8;
+
+	if (offset < state.size())
+		std::memcpy(&value, state.data() + offset, std::min<size_t>(state.size() - offset, 8));
+
+	return value;
+}
+
+static void write_varint(std::vector<uint8_t>& out, uint64_t value)
+{
+	for (; value >= 0x80; value >>= 7)
+		out.emplace_back((uint8_t)(value | 0x80));
+
+	out.emplace_back((uint8_t)value);
+}
+
+static bool read_varint(const uint8_t*& ptr, const uint8_t* end, uint64_t& value)
+{
+	value = 0;
+
+	for (uint32_t shift = 0; ptr != end && shift < 64; shift += 7) {
+		auto byte = *ptr++;
+		value |= (uint64_t)(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) return true;
+	}
+
+	return false;
+}
+
+// xor of the two states word by word as runs of zero words followed by runs of literal words
+static void encode_delta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& state, std::vector<uint8_t>& out)
+{
+	auto word_count = (std::max(base.size(), state.size()) + 7) / 8;
+
+	out.clear();
+
+	for (size_t word = 0; word < word_count;) {
+		auto zero_begin = word;
+
+		while (word < word_count && load_word(base, word) == load_word(state, word))
+			++word;
+
+		if (word == word_count) break;
+
+		auto literal_begin = word;
+
+		// a literal run ends at the first two equal words
+		while (word < word_count && (load_word(base, word) != load_word(state, word) ||
+			(word + 1 < word_count && load_word(base, word + 1) != load_word(state, word + 1))))
+			++word;
+
+		write_varint(out, literal_begin - zero_begin);
+		write_varint(out, word - literal_begin);
+
+		for (auto i = literal_begin; i < word; ++i) {
+			auto value = load_word(base, i) ^ load_word(state, i);
+			auto size  = out.size();
+
+			out.resize(size + 8);
+			std::memcpy(out.data() + size, &value, 8);
+		}
+	}
+}
+
+static bool apply_delta(const std::vector<uint8_t>& delta, size_t state_size, std::vector<uint8_t>& state)
+{
+	auto word_count = (std::max(state.size(), state_size) + 7) / 8;
+
+	state.resize(word_count * 8, 0);
+
+	auto ptr = delta.data();
+	auto end = delta.data() + delta.size();
+
+	for (size_t word = 0; ptr != end;) {
+		uint64_t zeros, literals;
+
+		if (!read_varint(ptr, end, zeros) || !read_varint(ptr, end, literals)) return false;
+
+		word += zeros;
+
+		if (word + literals > word_count || (size_t)(end - ptr) < literals * 8) return false;
+
+		for (uint64_t i = 0; i < literals; ++i, ++word, ptr += 8) {
+			uint64_t value, diff;
+
+			std::memcpy(&value, state.data() + word * 8, 8);
+			std::memcpy(&diff, ptr, 8);
+
+			value ^= diff;
+			std::memcpy(state.data() + word * 8, &value, 8);
+		}
+	}
+
+	state.resize(state_size);
+	return true;
+}
+
+SimulationHistory::SimulationHistory() :
+	last_valid(false),
+	since_keyframe(0),
+	rewound(false),
+	interval(DEFAULT_CHECKPOINT_INTERVAL),
+	budget(DEFAULT_HISTORY_BUDGET),
+	memory_usage(0),
+	end_tick(0)
+{}
+
+void SimulationHistory::clear()
+{
+	checkpoints.clear();
+	stimuli.clear();
+	last_state.clear();
+
+	last_valid     = false;
+	since_keyframe = 0;
+	rewound        = false;
+	memory_usage   = 0;
+	end_tick       = 0;
+}
+
+void SimulationHistory::setInterval(uint64_t interval)
+{
+	this->interval = std::max<uint64_t>(interval, 1);
+}
+
+void SimulationHistory::setMemoryBudget(size_t budget)
+{
+	this->budget = budget;
+	evict();
+}
+
+void SimulationHistory::addStimulus(uint64_t tick, net_id_t net, LogicValue value)
+{
+	assert(stimuli.empty() || stimuli.back().tick <= tick);
+
+	stimuli.push_back({ tick, net, value });
+}
+
+void SimulationHistory::resume(uint64_t tick)
+{
+	if (!rewound) return;
+
+	rewound = false;
+
+	auto stimulus = std::lower_bound(stimuli.begin(), stimuli.end(), tick,
+		[](const Stimulus& stimulus, uint64_t tick) { return stimulus.tick < tick; });
+
+	stimuli.erase(stimulus, stimuli.end());
+
+	auto count = checkpoints.size();
+
+	while (!checkpoints.empty() && checkpoints.back().tick > tick) {
+		memory_usage -= checkpoints.back().delta.size();
+		checkpoints.pop_back();
+	}
+
+	if (checkpoints.size() == count) return;
+
+	since_keyframe = 0;
+
+	for (auto iter = checkpoints.rbegin(); iter != checkpoints.rend() && !iter->keyframe; ++iter)
+		++since_keyframe;
+
+	last_valid = false;
+}
+
+uint64_t SimulationHistory::getNextCheckpoint() const
+{
+	return checkpoints.empty() ? 0 : checkpoints.back().tick + interval;
+}
+
+uint64_t SimulationHistory::getFirstTick() const
+{
+	return checkpoints.empty() ? 0 : checkpoints.front().tick;
+}
+
+uint64_t SimulationHistory::getEndTick() const
+{
+	return end_tick;
+}
+
+bool SimulationHistory::isRewound() const
+{
+	return rewound;
+}
+
+size_t SimulationHistory::getCheckpointCount() const
+{
+	return checkpoints.size();
+}
+
+size_t SimulationHistory::getMemoryUsage() const
+{
+	return memory_usage + stimuli.size() * sizeof(Stimulus) + last_state.size();
+}
+
+void SimulationHistory::store(uint64_t tick, const std::vector<uint8_t>& state)
+{
+	if (!checkpoints.empty() && tick <= checkpoints.back().tick) return;
+
+	// the base was dropped by a resume
+	if (!last_valid && !checkpoints.empty() && !decode(checkpoints.size() - 1, last_state))
+		since_keyframe = CHECKPOINT_KEYFRAME_INTERVAL;
+
+	auto keyframe = checkpoints.empty() || since_keyframe + 1 >= CHECKPOINT_KEYFRAME_INTERVAL;
+
+	if (keyframe)
+		last_state.clear();
+
+	auto& checkpoint = checkpoints.emplace_back();
+	checkpoint.tick       = tick;
+	checkpoint.state_size = state.size();
+	checkpoint.keyframe   = keyframe;
+
+	encode_delta(last_state, state, checkpoint.delta);
+	checkpoint.delta.shrink_to_fit();
+
+	memory_usage  += checkpoint.delta.size();
+	since_keyframe = keyframe ? 0 : since_keyframe + 1;
+
+	last_state = state;
+	last_valid = true;
+
+	evict();
+}
+
+// drops the oldest keyframe and its deltas while there is more than one keyframe
+void SimulationHistory::evict()
+{
+	size_t begin = 0;
+
+	while (getMemoryUsage() > budget) {
+		auto end = begin + 1;
+
+		while (end < checkpoints.size() && !checkpoints[end].keyframe)
+			++end;
+
+		if (end == checkpoints.size()) break;
+
+		for (auto i = begin; i < end; ++i)
+			memory_usage -= checkpoints[i].delta.size();
+
+		begin = end;
+	}
+
+	if (!begin) return;
+
+	checkpoints.erase(checkpoints.begin(), checkpoints.begin() + begin);
+
+	auto stimulus = std::lower_bound(stimuli.begin(), stimuli.end(), checkpoints.front().tick,
+		[](const Stimulus& stimulus, uint64_t tick) { return stimulus.tick < tick; });
+
+	stimuli.erase(stimuli.begin(), stimulus);
+}
+
+size_t SimulationHistory::findCheckpoint(uint64_t tick) const
+{
+	auto iter = std::upper_bound(checkpoints.begin(), checkpoints.end(), tick,
+		[](uint64_t tick, const Checkpoint& checkpoint) { return tick < checkpoint.tick; });
+
+	return iter == checkpoints.begin() ? checkpoints.size() : iter - checkpoints.begin() - 1;
+}
+
+bool SimulationHistory::decode(size_t idx, std::vector<uint8_t>& state) const
+{
+	auto first = idx;
+
+	while (!checkpoints[first].keyframe)
+		--first;
+
+	state.clear();
+
+	for (auto i = first; i <= idx; ++i)
+		if (!apply_delta(checkpoints[i].delta, checkpoints[i].state_size, state)) return false;
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "logic_value.h"
+#include "../net.h"
+#include <algorithm>
+#include <vector>
+
+#define DEFAULT_CHECKPOINT_INTERVAL  256 // ticks between checkpoints, bounds the ticks replayed by a rewind
+#define CHECKPOINT_KEYFRAME_INTERVAL 32  // checkpoints per full state, the rest are deltas
+#define DEFAULT_HISTORY_BUDGET       (256ull << 20)
+
+// periodic checkpoints of an engine's state and the nets set between them, so the
+// simulation can go back to any tick since the oldest checkpoint. a checkpoint is
+// stored as the xor with the one before it with the runs of zero words left out,
+// every CHECKPOINT_KEYFRAME_INTERVAL one is against an empty state. the oldest run
+// of checkpoints is dropped once they take more than the budget.
+// the engine needs saveState, loadState, setNet, advance, getTick and setRecorder
+class SimulationHistory {
+public:
+	SimulationHistory();
+
+	void clear();
+
+	void setInterval(uint64_t interval);
+	void setMemoryBudget(size_t budget);
+
+	// the state at a tick is the one before the nets set at that tick
+	template <class Sim>
+	void checkpoint(const Sim& sim) {
+		sim.saveState(scratch);
+		store(sim.getTick(), scratch);
+	}
+
+	void addStimulus(uint64_t tick, net_id_t net, LogicValue value);
+
+	// called before the simulation steps or a net is set. after a rewind the checkpoints
+	// and nets recorded past tick are kept for scrubbing forward until then
+	void resume(uint64_t tick);
+
+	// restores the checkpoint at or before tick and replays the nets set since then
+	template <class Sim>
+	bool rewind(Sim& sim, uint64_t tick) {
+		auto end = rewound ? end_tick : sim.getTick();
+		auto idx = findCheckpoint(tick);
+
+		if (tick > end || idx == checkpoints.size() || !decode(idx, scratch) || !sim.loadState(scratch))
+			return false;
+
+		auto stimulus = std::lower_bound(stimuli.begin(), stimuli.end(), checkpoints[idx].tick,
+			[](const Stimulus& stimulus, uint64_t tick) { return stimulus.tick < tick; });
+
+		while (sim.getTick() < tick) {
+			for (; stimulus != stimuli.end() && stimulus->tick == sim.getTick(); ++stimulus)
+				sim.setNet(stimulus->net, stimulus->value);
+
+			auto next = stimulus != stimuli.end() ? std::min(stimulus->tick, tick) : tick;
+			sim.advance(next - sim.getTick());
+		}
+
+		end_tick = end;
+		rewound  = true;
+		return true;
+	}
+
+	uint64_t getNextCheckpoint() const;
+	uint64_t getFirstTick() const;
+	uint64_t getEndTick() const;
+	bool isRewound() const;
+	size_t getCheckpointCount() const;
+	size_t getMemoryUsage() const;
+
+private:
+	struct Checkpoint {
+		uint64_t             tick;
+		size_t               state_size; // bytes
+		bool                 keyframe;
+		std::vector<uint8_t> delta;
+	};
+
+	struct Stimulus {
+		uint64_t   tick;
+		net_id_t   net;
+		LogicValue value;
+	};
+
+	void store(uint64_t tick, const std::vector<uint8_t>& state);
+	void evict();
+	size_t findCheckpoint(uint64_t tick) const;
+	bool decode(size_t idx, std::vector<uint8_t>& state) const;
+
+	std::vector<Checkpoint> checkpoints;   // the first one is a keyframe
+	std::vector<Stimulus>   stimuli;       // sorted by tick
+	std::vector<uint8_t>    last_state;    // state of the last checkpoint, the base of the next delta
+	bool                    last_valid;
+	std::vector<uint8_t>    scratch;
+	uint32_t                since_keyframe;
+	bool                    rewound;
+
+	uint64_t interval;
+	size_t   budget;
+	size_t   memory_usage;
+	uint64_t end_tick; // tick the simulation was at when it was first rewound
+};
\ No newline at end of file
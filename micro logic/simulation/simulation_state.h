@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// flat byte image of an engine's state. fields are written in the same order every time,
+// so two states of one circuit differ only where the circuit changed
+template <class T>
+void write_state(std::vector<uint8_t>& state, const T& value) {
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	auto size = state.size();
+	state.resize(size + sizeof(T));
+	std::memcpy(state.data() + size, &value, sizeof(T));
+}
+
+template <class T>
+void write_state_array(std::vector<uint8_t>& state, const std::vector<T>& values) {
+	static_assert(std::is_trivially_copyable_v<T>);
+
+	write_state(state, (uint64_t)values.size());
+
+	auto size = state.size();
+	state.resize(size + values.size() * sizeof(T));
+
+	if (!values.empty())
+		std::memcpy(state.data() + size, values.data(), values.size() * sizeof(T));
+}
+
+class StateReader {
+public:
+	StateReader(const std::vector<uint8_t>& state) :
+		ptr(state.data()),
+		end(state.data() + state.size())
+	{}
+
+	template <class T>
+	bool read(T& value) {
+		static_assert(std::is_trivially_copyable_v<T>);
+
+		if ((size_t)(end - ptr) < sizeof(T)) return false;
+
+		std::memcpy(&value, ptr, sizeof(T));
+		ptr += sizeof(T);
+		return true;
+	}
+
+	// an array written by write_state_array, expected_size is checked unless it is SIZE_MAX
+	template <class T>
+	bool readArray(std::vector<T>& values, size_t expected_size = SIZE_MAX) {
+		uint64_t size;
+
+		if (!read(size)) return false;
+		if (expected_size != SIZE_MAX && size != expected_size) return false;
+		if ((size_t)(end - ptr) / sizeof(T) < size) return false;
+
+		values.resize(size);
+
+		if (size)
+			std::memcpy(values.data(), ptr, size * sizeof(T));
+
+		ptr += size * sizeof(T);
+		return true;
+	}
+
+private:
+	const uint8_t* ptr;
+	const uint8_t* end;
+};
\ No newline at end of file
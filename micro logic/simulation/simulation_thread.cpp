@@ -0,0 +1,643 @@
+#include "simulation_thread.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+
+SimulationThread::SimulationThread() :
+	parallel(false),
+	capturing(false),
+	quit(false),
+	history_memory(0),
+	consumed_sequence(0),
+	paused(false),
+	profiling(false),
+	ui_paused(false),
+	ui_profiling(false),
+	ui_tick_rate(DEFAULT_TICK_RATE),
+	ui_thread_count(1),
+	ui_breakpoint_count(0),
+	ui_settle_limit(DEFAULT_SETTLE_LIMIT),
+	sequence(0),
+	pending_base(0),
+	settle_limit(DEFAULT_SETTLE_LIMIT),
+	settle_tick(0),
+	oscillating(false)
+{}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count)
+{
+	stop();
+	endCapture();
+
+	Stimulus stimulus;
+	while (stimuli.pop(stimulus));
+
+	build(elements, buses, net_count);
+	begin();
+}
+
+void SimulationThread::restart(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count)
+{
+	if (!isRunning()) {
+		start(elements, buses, net_count);
+		return;
+	}
+
+	stop();
+	endCapture();
+
+	// the stimuli sent before the edit still go to the circuit they were meant for
+	Stimulus stimulus;
+	while (stimuli.pop(stimulus))
+		applyStimulus(stimulus);
+
+	std::vector<uint8_t> pin_values;
+	uint64_t             tick = 0;
+
+	withSimulator([&](auto& sim) {
+		const auto& values = sim.getNetValues();
+
+		for (auto net : element_nets)
+			pin_values.emplace_back(net != INVALID_NET_ID ? values[net] : (uint8_t)Logic_X);
+
+		tick = sim.getTick();
+	});
+
+	std::unordered_map<const LogicElement*, uint32_t> prev_indices;
+
+	for (uint32_t i = 0; i < carried_elements.size(); ++i)
+		prev_indices.emplace(carried_elements[i], i);
+
+	auto prev_shared  = std::move(carried_shared);
+	auto prev_offsets = std::move(element_net_offsets);
+
+	build(elements, buses, net_count);
+
+	// an element keeps the values of its pins, a net gets X where the elements on it disagree
+	// and nets only new elements are on start at X
+	std::vector<uint8_t> values(withSimulator([](auto& sim) { return sim.getNetCount(); }), UINT8_MAX);
+
+	for (uint32_t elem = 0; elem < elements.size(); ++elem) {
+		auto iter = prev_indices.find(elements[elem]);
+		if (iter == prev_indices.end()) continue;
+
+		auto prev  = iter->second;
+		auto begin = element_net_offsets[elem];
+		auto count = element_net_offsets[elem + 1] - begin;
+
+		if (prev_shared[prev] != elements[elem]->shared.get() || prev_offsets[prev + 1] - prev_offsets[prev] != count)
+			continue;
+
+		for (uint32_t i = 0; i < count; ++i) {
+			auto net = element_nets[begin + i];
+			if (net == INVALID_NET_ID) continue;
+
+			auto  value = pin_values[prev_offsets[prev] + i];
+			auto& prev_value = values[net];
+			prev_value = prev_value == UINT8_MAX || prev_value == value ? value : (uint8_t)Logic_X;
+		}
+	}
+
+	for (auto& value : values)
+		if (value == UINT8_MAX) value = Logic_X;
+
+	withSimulator([&](auto& sim) { sim.restore(values, tick); });
+	begin();
+}
+
+void SimulationThread::build(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count)
+{
+	simulator.build(elements, buses, net_count);
+	simulator.getElementGates(element_gate_offsets, element_gates);
+	simulator.getElementNets(element_net_offsets, element_nets);
+	levelization.build(simulator);
+	parallel = ui_thread_count > 1 && !simulator.hasDelays();
+
+	carried_elements.assign(elements.begin(), elements.end());
+	carried_shared.clear();
+
+	for (const auto* elem : elements)
+		carried_shared.emplace_back(elem->shared.get());
+
+	if (parallel) {
+		parallel_simulator.build(simulator, ui_thread_count);
+		simulator.clear();
+	} else
+		parallel_simulator.clear();
+
+	withSimulator([&](auto& sim) {
+		changes.resize(sim.getNetCount());
+		pending_changes.resize(sim.getNetCount());
+
+		sim.setTickRate(ui_tick_rate);
+		sim.setCountingActivity(ui_profiling);
+		sim.setChangeSet(&changes);
+	});
+}
+
+void SimulationThread::begin()
+{
+	activity     = {};
+	profiling    = ui_profiling;
+	paused       = ui_paused;
+	settle_limit = ui_settle_limit;
+	settle_tick  = withSimulator([](auto& sim) { return sim.getTick(); });
+	oscillating  = false;
+	oscillating_nets.clear();
+
+	history.clear();
+	checkpoint();
+
+	breakpoints.clear();
+	ui_breakpoint_count = 0;
+
+	snapshots.back() = {};
+	publishSnapshot();
+	snapshots.update();
+
+	launch();
+}
+
+void SimulationThread::stop()
+{
+	if (!thread.joinable()) return;
+
+	quit.store(true, std::memory_order_release);
+	thread.join();
+}
+
+bool SimulationThread::isRunning() const
+{
+	return thread.joinable();
+}
+
+bool SimulationThread::pushStimulus(const Stimulus& stimulus)
+{
+	return stimuli.push(stimulus);
+}
+
+void SimulationThread::setNet(net_id_t net, LogicValue value)
+{
+	pushStimulus({ Stimulus::SetNet, net, (float)value, 0 });
+}
+
+void SimulationThread::reset()
+{
+	pushStimulus({ Stimulus::Reset, INVALID_NET_ID, 0.f, 0 });
+}
+
+void SimulationThread::setTickRate(float tick_rate)
+{
+	ui_tick_rate = tick_rate;
+	pushStimulus({ Stimulus::SetTickRate, INVALID_NET_ID, tick_rate, 0 });
+}
+
+void SimulationThread::setPaused(bool paused)
+{
+	ui_paused = paused;
+	pushStimulus({ paused ? Stimulus::Pause : Stimulus::Resume, INVALID_NET_ID, 0.f, 0 });
+}
+
+bool SimulationThread::isPaused() const
+{
+	return ui_paused;
+}
+
+void SimulationThread::setProfiling(bool profiling)
+{
+	ui_profiling = profiling;
+	pushStimulus({ Stimulus::SetProfiling, INVALID_NET_ID, profiling ? 1.f : 0.f, 0 });
+}
+
+bool SimulationThread::isProfiling() const
+{
+	return ui_profiling;
+}
+
+void SimulationThread::resetActivity()
+{
+	pushStimulus({ Stimulus::ResetActivity, INVALID_NET_ID, 0.f, 0 });
+}
+
+float SimulationThread::getTickRate() const
+{
+	return ui_tick_rate;
+}
+
+void SimulationThread::rewind(uint64_t tick)
+{
+	ui_paused = true;
+	pushStimulus({ Stimulus::Pause, INVALID_NET_ID, 0.f, 0 });
+	pushStimulus({ Stimulus::Rewind, INVALID_NET_ID, 0.f, tick });
+}
+
+size_t SimulationThread::getHistoryMemory() const
+{
+	return history_memory.load(std::memory_order_relaxed);
+}
+
+void SimulationThread::setSettleLimit(uint64_t settle_limit)
+{
+	ui_settle_limit = settle_limit;
+	pushStimulus({ Stimulus::SetSettleLimit, INVALID_NET_ID, 0.f, settle_limit });
+}
+
+uint64_t SimulationThread::getSettleLimit() const
+{
+	return ui_settle_limit;
+}
+
+uint32_t SimulationThread::getLoopCount() const
+{
+	return levelization.loop_count;
+}
+
+bool SimulationThread::startCapture(const std::vector<net_id_t>& nets, const std::string& vcd_path)
+{
+	if (!isRunning()) return false;
+
+	stop();
+	endCapture();
+
+	auto net_count = withSimulator([](auto& sim) { return sim.getNetCount(); });
+
+	recorder.probe(nets, net_count);
+
+	if (!vcd_path.empty()) {
+		std::vector<std::string> names;
+
+		for (uint32_t probe = 0; probe < recorder.getProbeCount(); ++probe)
+			names.emplace_back("net" + std::to_string(recorder.getProbeNet(probe)));
+
+		if (!vcd_writer.open(vcd_path, names)) {
+			recorder.clear();
+			launch();
+			return false;
+		}
+
+		recorder.setWriter(&vcd_writer);
+	}
+
+	withSimulator([&](auto& sim) {
+		recorder.captureAll(sim.getTick(), sim.getNetValues());
+		sim.setRecorder(&recorder);
+	});
+
+	capturing = true;
+
+	launch();
+	return true;
+}
+
+void SimulationThread::stopCapture()
+{
+	auto running = isRunning();
+
+	stop();
+	endCapture();
+
+	if (running)
+		launch();
+}
+
+bool SimulationThread::isCapturing() const
+{
+	return capturing;
+}
+
+uint64_t SimulationThread::getCaptureBytes() const
+{
+	return vcd_writer.getBytesWritten();
+}
+
+bool SimulationThread::addBreakpoint(const Breakpoints::Breakpoint& breakpoint)
+{
+	if (!isRunning()) return false;
+
+	stop();
+
+	auto added = withSimulator([&](auto& sim) {
+		if (!breakpoints.add(breakpoint)) return false;
+
+		breakpoints.sync(sim.getNetValues());
+		sim.setBreakpoints(&breakpoints);
+		return true;
+	});
+
+	ui_breakpoint_count = breakpoints.getCount();
+
+	launch();
+	return added;
+}
+
+void SimulationThread::clearBreakpoints()
+{
+	auto running = isRunning();
+
+	stop();
+
+	breakpoints.clear();
+	simulator.setBreakpoints(nullptr);
+	parallel_simulator.setBreakpoints(nullptr);
+	ui_breakpoint_count = 0;
+
+	if (running)
+		launch();
+}
+
+size_t SimulationThread::getBreakpointCount() const
+{
+	return ui_breakpoint_count;
+}
+
+void SimulationThread::setThreadCount(uint32_t thread_count)
+{
+	ui_thread_count = std::max(thread_count, 1u);
+}
+
+uint32_t SimulationThread::getThreadCount() const
+{
+	return ui_thread_count;
+}
+
+bool SimulationThread::updateSnapshot()
+{
+	if (!snapshots.update()) return false;
+
+	consumed_sequence.store(snapshots.front().sequence, std::memory_order_release);
+	return true;
+}
+
+const SimulationThread::Snapshot& SimulationThread::getSnapshot() const
+{
+	return snapshots.front();
+}
+
+void SimulationThread::launch()
+{
+	quit.store(false, std::memory_order_release);
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+// worker must be stopped, the kept transitions stay in the recorder
+void SimulationThread::endCapture()
+{
+	if (!capturing) return;
+
+	simulator.setRecorder(nullptr);
+	parallel_simulator.setRecorder(nullptr);
+	recorder.setWriter(nullptr);
+	vcd_writer.close();
+
+	capturing = false;
+}
+
+void SimulationThread::run()
+{
+	using clock_t = std::chrono::steady_clock;
+
+	auto last_time     = clock_t::now();
+	auto last_snapshot = last_time;
+
+	while (!quit.load(std::memory_order_acquire)) {
+		Stimulus stimulus;
+		while (stimuli.pop(stimulus))
+			applyStimulus(stimulus);
+
+		checkBreakpoints();
+
+		auto now = clock_t::now();
+		auto dt  = std::chrono::duration<float>(now - last_time).count();
+		last_time = now;
+
+		uint64_t ticks = 0;
+
+		if (!paused && !oscillating) {
+			withSimulator([&](auto& sim) { history.resume(sim.getTick()); });
+			checkpoint();
+
+			ticks = withSimulator([&](auto& sim) { return sim.update(dt, history.getNextCheckpoint() - sim.getTick()); });
+			checkSettling();
+			checkpoint();
+			checkBreakpoints();
+		}
+
+		if (std::chrono::duration<float>(now - last_snapshot).count() >= SNAPSHOT_INTERVAL) {
+			publishSnapshot();
+			last_snapshot = now;
+		}
+
+		if (paused || oscillating || ticks == 0 || withSimulator([](auto& sim) { return sim.isStable(); }))
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	publishSnapshot();
+}
+
+void SimulationThread::applyStimulus(const Stimulus& stimulus)
+{
+	switch (stimulus.type) {
+	case Stimulus::SetNet:
+		withSimulator([&](auto& sim) {
+			if (stimulus.net < sim.getNetCount()) {
+				history.resume(sim.getTick());
+				history.addStimulus(sim.getTick(), stimulus.net, (LogicValue)(uint8_t)stimulus.value);
+				sim.setNet(stimulus.net, (LogicValue)(uint8_t)stimulus.value);
+			}
+
+			settle_tick = sim.getTick();
+		});
+		oscillating = false;
+		break;
+	case Stimulus::Reset:
+		withSimulator([&](auto& sim) {
+			sim.reset();
+			sim.collectActivity(activity);
+		});
+		activity.clear();
+		settle_tick = 0;
+		oscillating = false;
+		history.clear();
+		checkpoint();
+		break;
+	case Stimulus::SetTickRate:
+		withSimulator([&](auto& sim) { sim.setTickRate(stimulus.value); });
+		break;
+	case Stimulus::Pause:
+		paused = true;
+		break;
+	case Stimulus::Resume:
+		paused = false;
+		breakpoints.clearHit();
+		break;
+	case Stimulus::SetSettleLimit:
+		settle_limit = stimulus.tick;
+		break;
+	case Stimulus::Rewind:
+		// the replayed ticks are not captured, the recorder continues from the restored values
+		withSimulator([&](auto& sim) {
+			sim.setRecorder(nullptr);
+			sim.setBreakpoints(nullptr);
+			history.rewind(sim, stimulus.tick);
+
+			if (capturing) {
+				recorder.captureAll(sim.getTick(), sim.getNetValues());
+				sim.setRecorder(&recorder);
+			}
+
+			if (breakpoints.getCount()) {
+				breakpoints.sync(sim.getNetValues());
+				sim.setBreakpoints(&breakpoints);
+			}
+
+			settle_tick = sim.getTick();
+		});
+		oscillating = false;
+		break;
+	case Stimulus::SetProfiling:
+		profiling = stimulus.value != 0.f;
+		withSimulator([&](auto& sim) { sim.setCountingActivity(profiling); });
+		activity = {};
+		break;
+	case Stimulus::ResetActivity:
+		withSimulator([&](auto& sim) { sim.collectActivity(activity); });
+		activity.clear();
+		break;
+	}
+}
+
+// a checkpoint every interval ticks, the updates stop at the next one
+void SimulationThread::checkpoint()
+{
+	withSimulator([&](auto& sim) {
+		if (sim.getTick() >= history.getNextCheckpoint() && !history.isRewound())
+			history.checkpoint(sim);
+	});
+
+	history_memory.store(history.getMemoryUsage(), std::memory_order_relaxed);
+}
+
+// the updates stop at the tick a breakpoint hit, the simulation waits there for a resume
+void SimulationThread::checkBreakpoints()
+{
+	if (breakpoints.isHit() && !paused) {
+		paused = true;
+		publishSnapshot();
+	}
+}
+
+void SimulationThread::checkSettling()
+{
+	withSimulator([&](auto& sim) {
+		if (sim.isStable()) {
+			settle_tick = sim.getTick();
+			return;
+		}
+
+		if (settle_limit && sim.getTick() - settle_tick > settle_limit)
+			findOscillation(sim);
+	});
+}
+
+// steps a short window to see which nets keep switching, the ones on combinational loops
+// are reported. a circuit that settles within the window was only slow
+template <class Sim>
+void SimulationThread::findOscillation(Sim& sim)
+{
+	// the change set collects the nets switching in the window, what it held before is put
+	// back for the next snapshot. the window is ordinary ticks, checkpointed like the ones of
+	// update so a rewind replays them
+	std::vector<net_id_t> prev_changes;
+	std::vector<net_id_t> window_changes;
+
+	changes.take(prev_changes);
+
+	for (uint32_t i = 0; i < OSCILLATION_WINDOW && !sim.isStable(); ++i) {
+		sim.step();
+		checkpoint();
+	}
+
+	changes.take(window_changes);
+	changes.add(window_changes);
+	changes.add(prev_changes);
+
+	if (sim.isStable()) {
+		settle_tick = sim.getTick();
+		return;
+	}
+
+	std::sort(window_changes.begin(), window_changes.end());
+
+	oscillating_nets.clear();
+
+	for (auto net : levelization.loop_nets)
+		if (std::binary_search(window_changes.begin(), window_changes.end(), net))
+			oscillating_nets.emplace_back(net);
+
+	if (oscillating_nets.empty())
+		oscillating_nets = window_changes;
+
+	oscillating = true;
+}
+
+void SimulationThread::publishSnapshot()
+{
+	auto& snapshot = snapshots.back();
+
+	withSimulator([&](auto& sim) {
+		snapshot.net_values = sim.getNetValues();
+		snapshot.tick       = sim.getTick();
+		snapshot.stable     = sim.isStable();
+	});
+
+	snapshot.history_begin = history.getFirstTick();
+	snapshot.history_end   = history.isRewound() ? history.getEndTick() : snapshot.tick;
+	snapshot.breakpoint    = breakpoints.getHit();
+
+	snapshot.oscillating      = oscillating;
+	snapshot.oscillating_nets = oscillating_nets;
+
+	// the ui only redraws the wires of these. snapshots the ui skipped are not acknowledged,
+	// their changes stay pending so the next delta still starts at one the ui has
+	changes.take(tick_changes);
+
+	if (consumed_sequence.load(std::memory_order_acquire) == sequence) {
+		pending_changes.clear();
+		pending_base = sequence;
+	}
+
+	pending_changes.add(tick_changes);
+	pending_changes.copy(snapshot.changed_nets);
+
+	snapshot.base_sequence = pending_base;
+	snapshot.sequence = ++sequence;
+
+	publishActivity(snapshot);
+
+	snapshots.publish();
+}
+
+// the counts of the engine are merged once per snapshot, the gates are summed per element
+void SimulationThread::publishActivity(Snapshot& snapshot)
+{
+	if (!profiling) {
+		snapshot.net_activity.clear();
+		snapshot.element_activity.clear();
+		return;
+	}
+
+	withSimulator([&](auto& sim) { sim.collectActivity(activity); });
+
+	snapshot.net_activity = activity.net_toggles;
+	snapshot.element_activity.assign(element_gate_offsets.size() - 1, 0);
+
+	for (size_t elem = 0; elem + 1 < element_gate_offsets.size(); ++elem)
+		for (auto i = element_gate_offsets[elem]; i < element_gate_offsets[elem + 1]; ++i)
+			snapshot.element_activity[elem] += activity.gate_evaluations[element_gates[i]];
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "parallel_simulator.h"
+#include "levelization.h"
+#include "simulation_history.h"
+#include "../util/triple_buffer.hpp"
+#include "../util/spsc_queue.hpp"
+#include <thread>
+
+#define STIMULUS_QUEUE_SIZE 1024
+#define SNAPSHOT_INTERVAL   (1.f / 240.f)
+#define DEFAULT_SETTLE_LIMIT 100000
+#define OSCILLATION_WINDOW   64
+
+class SimulationThread {
+public:
+	struct Stimulus {
+		enum Type {
+			SetNet,
+			Reset,
+			SetTickRate,
+			Pause,
+			Resume,
+			SetSettleLimit,
+			Rewind,
+			SetProfiling,
+			ResetActivity
+		};
+
+		Type     type;
+		net_id_t net;
+		float    value; // LogicValue for SetNet
+		uint64_t tick;  // for Rewind, the limit for SetSettleLimit
+	};
+
+	struct Snapshot {
+		std::vector<uint8_t>  net_values;
+		std::vector<net_id_t> changed_nets;  // nets changed since the base snapshot, every net after a start or reset
+		uint64_t              base_sequence; // the oldest snapshot changed_nets is a delta of, later ones are covered too
+		std::vector<net_id_t> oscillating_nets;
+		std::vector<uint64_t> net_activity;     // toggles of each net, empty unless profiling
+		std::vector<uint64_t> element_activity; // gate evaluations of each element the simulation was started with
+		uint64_t              sequence; // counts the published snapshots, not reset by a start
+		uint64_t              tick;
+		uint64_t              history_begin; // ticks the simulation can be rewound to
+		uint64_t              history_end;
+		uint32_t              breakpoint; // the one the simulation stopped at, NO_BREAKPOINT if none
+		bool                  stable;
+		bool                  oscillating;
+	};
+
+	SimulationThread();
+	~SimulationThread();
+
+	void start(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count);
+	// a start on an edited circuit that goes on from the tick and the values of the running one,
+	// elements that were there before keep the values of their pins. history and captures still end
+	void restart(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count);
+	void stop();
+	bool isRunning() const;
+
+	// ui thread only
+	bool pushStimulus(const Stimulus& stimulus);
+	void setNet(net_id_t net, LogicValue value);
+	void reset();
+	void setTickRate(float tick_rate);
+	void setPaused(bool paused);
+	bool isPaused() const;
+	float getTickRate() const;
+
+	// pauses and goes back to a tick in [history_begin, history_end] of the snapshot, a rewound
+	// simulation can be moved forward again until it is resumed or a net is set
+	void rewind(uint64_t tick);
+	size_t getHistoryMemory() const;
+
+	// ticks the circuit may stay unstable without a stimulus before it is halted, 0 never halts
+	void setSettleLimit(uint64_t settle_limit);
+	uint64_t getSettleLimit() const;
+	uint32_t getLoopCount() const;
+
+	// records the transitions of nets, streamed to a VCD file too unless vcd_path is empty.
+	// a restart renumbers the nets so it ends the capture
+	bool startCapture(const std::vector<net_id_t>& nets, const std::string& vcd_path);
+	void stopCapture();
+	bool isCapturing() const;
+	uint64_t getCaptureBytes() const;
+
+	// pauses the simulation when one of them hits, resuming goes on from there.
+	// a restart renumbers the nets so it clears them
+	bool addBreakpoint(const Breakpoints::Breakpoint& breakpoint);
+	void clearBreakpoints();
+	size_t getBreakpointCount() const;
+
+	// counts net toggles and gate evaluations from the reset or the last resetActivity,
+	// published with the snapshots. a simulation that is not profiled does not count
+	void setProfiling(bool profiling);
+	bool isProfiling() const;
+	void resetActivity();
+
+	// takes effect on the next start, more than one thread runs ParallelSimulator unless the circuit has delays
+	void setThreadCount(uint32_t thread_count);
+	uint32_t getThreadCount() const;
+
+	// the picked up snapshot is acknowledged, the changed nets of the next ones start from it
+	bool updateSnapshot();
+	const Snapshot& getSnapshot() const;
+
+private:
+	void build(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count);
+	void begin();
+	void launch();
+	void endCapture();
+	void run();
+	void applyStimulus(const Stimulus& stimulus);
+	void publishSnapshot();
+	void checkSettling();
+	void checkpoint();
+	void checkBreakpoints();
+	void publishActivity(Snapshot& snapshot);
+
+	template <class Sim>
+	void findOscillation(Sim& sim);
+
+	template <class Func>
+	decltype(auto) withSimulator(Func&& func) {
+		return parallel ? func(parallel_simulator) : func(simulator);
+	}
+
+	Simulator         simulator;
+	ParallelSimulator parallel_simulator;
+	Levelization      levelization;
+	SimulationHistory history;
+	Breakpoints       breakpoints;
+	ActivityCounters  activity;
+	NetChangeSet      changes;
+	NetChangeSet      pending_changes; // since pending_base, kept until the ui picked up a snapshot
+	WaveformRecorder  recorder;
+	VcdWriter         vcd_writer;
+	bool              parallel;
+	bool              capturing;
+	std::thread       thread;
+
+	std::atomic<bool>                         quit;
+	std::atomic<size_t>                       history_memory;
+	std::atomic<uint64_t>                     consumed_sequence;
+	SPSCQueue<Stimulus, STIMULUS_QUEUE_SIZE> stimuli;
+	TripleBuffer<Snapshot>                    snapshots;
+
+	bool     paused;    // worker side
+	bool     profiling;
+	bool     ui_paused; // ui side
+	bool     ui_profiling;
+	float    ui_tick_rate;
+	uint32_t ui_thread_count;
+	size_t   ui_breakpoint_count;
+	uint64_t ui_settle_limit;
+
+	uint64_t              sequence;
+	uint64_t              pending_base;
+	std::vector<net_id_t> tick_changes;
+
+	uint64_t              settle_limit;
+	uint64_t              settle_tick; // last tick the circuit was stable or stimulated
+	bool                  oscillating;
+	std::vector<net_id_t> oscillating_nets;
+
+	std::vector<uint32_t> element_gate_offsets; // CSR, gates of element n are element_gates[element_gate_offsets[n]..]
+	std::vector<uint32_t> element_gates;
+	std::vector<uint32_t> element_net_offsets; // CSR, nets of the gate pins of element n, see Simulator::getElementNets
+	std::vector<net_id_t> element_nets;
+
+	// the elements of the last start by address, only compared, a restart looks up its elements in them
+	std::vector<const LogicElement*>         carried_elements;
+	std::vector<const LogicElement::Shared*> carried_shared;
+};
\ No newline at end of file
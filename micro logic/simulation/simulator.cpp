@@ -0,0 +1,889 @@
+#include "simulator.h"
+
+#include "simulation_state.h"
+#include "../util/bit_utils.h"
+#include <algorithm>
+
+Simulator::Simulator() :
+	tick_rate(DEFAULT_TICK_RATE),
+	tick_accum(0.f),
+	tick(0),
+	evaluations(0),
+	net_changes(0),
+	counting_activity(false),
+	recorder(nullptr),
+	breakpoints(nullptr),
+	changes(nullptr)
+{}
+
+void Simulator::build(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count)
+{
+	clear();
+
+	std::string error;
+
+	top = std::make_shared<UnitModule>();
+	top->build(elements, buses, net_count, false, error);
+
+	instances.push_back({ top.get(), 0, 0, 0, 0, 0 });
+
+	// the sheet nets are the nets of the top instance
+	net_instances.resize(net_count, 0);
+	net_locals.resize(net_count);
+
+	for (net_id_t net = 0; net < net_count; ++net)
+		net_locals[net] = net;
+
+	uint32_t gate_count = 0;
+	uint32_t word_count = 0;
+
+	// breadth first, so the children of an instance are contiguous
+	for (uint32_t inst_idx = 0; inst_idx < instances.size(); ++inst_idx) {
+		auto& module = *instances[inst_idx].module;
+
+		instances[inst_idx].gate_base  = gate_count;
+		instances[inst_idx].child_base = (uint32_t)instances.size();
+		instances[inst_idx].word_base  = word_count;
+		gate_count += (uint32_t)module.gates.size();
+		word_count += (uint32_t)module.getWordCount();
+
+		for (const auto& child : module.children) {
+			auto& sub       = *child.module;
+			auto child_idx  = (uint32_t)instances.size();
+			auto port_base  = (uint32_t)port_nets.size();
+
+			for (uint32_t port = 0; port < sub.port_count; ++port) {
+				auto net = toGlobal(instances[inst_idx], module.child_ports[child.port_begin + port]);
+
+				// an unconnected pin still needs a net inside the unit
+				if (net == INVALID_NET_ID) {
+					net = (net_id_t)net_instances.size();
+					net_instances.emplace_back(child_idx);
+					net_locals.emplace_back(port);
+				}
+
+				port_nets.emplace_back(net);
+			}
+
+			auto net_base = (net_id_t)net_instances.size();
+
+			for (auto local = (net_id_t)sub.port_count; local < sub.getNetCount(); ++local) {
+				net_instances.emplace_back(child_idx);
+				net_locals.emplace_back(local);
+			}
+
+			instances.push_back({ &sub, 0, net_base, port_base, 0, 0 });
+		}
+	}
+
+	gates.reserve(gate_count);
+
+	for (uint32_t inst_idx = 0; inst_idx < instances.size(); ++inst_idx)
+		for (const auto& gate : instances[inst_idx].module->gates)
+			gates.push_back({ gate.shared, 0, 0, gate.net_begin, inst_idx });
+
+	auto total_nets = net_instances.size();
+
+	constant_counts.resize(total_nets, {});
+
+	for (const auto& inst : instances) {
+		auto& module = *inst.module;
+
+		for (net_id_t local = 0; local < module.getNetCount(); ++local) {
+			auto& counts = constant_counts[toGlobal(inst, local)].counts;
+
+			counts[Logic_0] += module.constant_counts[local].counts[Logic_0];
+			counts[Logic_1] += module.constant_counts[local].counts[Logic_1];
+		}
+	}
+
+	net_words.resize(total_nets, INVALID_WORD_ID);
+	net_word_bits.resize(total_nets, 0);
+	word_instances.resize(word_count);
+
+	for (uint32_t inst_idx = 0; inst_idx < instances.size(); ++inst_idx) {
+		const auto& inst   = instances[inst_idx];
+		const auto& module = *inst.module;
+
+		for (uint32_t word = 0; word < module.getWordCount(); ++word) {
+			word_instances[inst.word_base + word] = inst_idx;
+
+			for (auto i = module.word_offsets[word]; i < module.word_offsets[word + 1]; ++i) {
+				auto net = toGlobal(inst, module.word_nets[i]);
+
+				net_words[net]     = inst.word_base + word;
+				net_word_bits[net] = (uint8_t)(i - module.word_offsets[word]);
+			}
+		}
+	}
+
+	word_values.resize(word_count);
+	word_known.resize(word_count);
+	word_changed.resize(word_count);
+
+	net_values.resize(total_nets);
+	net_pushed.resize(total_nets);
+	net_prev.resize(total_nets);
+	gate_pushed.resize(gates.size());
+	driver_counts.resize(total_nets);
+
+	reset();
+}
+
+void Simulator::clear()
+{
+	top.reset();
+	instances.clear();
+	port_nets.clear();
+	net_instances.clear();
+	net_locals.clear();
+	net_words.clear();
+	net_word_bits.clear();
+	word_instances.clear();
+	gates.clear();
+	net_values.clear();
+	net_pushed.clear();
+	net_prev.clear();
+	gate_pushed.clear();
+	driver_counts.clear();
+	constant_counts.clear();
+	curr_nets.clear();
+	active_gates.clear();
+	word_values.clear();
+	word_known.clear();
+	word_changed.clear();
+	curr_words.clear();
+	pending_events.clear();
+	toggle_counts.clear();
+	evaluation_counts.clear();
+
+	tick_accum        = 0.f;
+	tick              = 0;
+	evaluations       = 0;
+	net_changes       = 0;
+	counting_activity = false;
+}
+
+void Simulator::reset()
+{
+	restore({}, 0);
+}
+
+void Simulator::restore(const std::vector<uint8_t>& values, uint64_t start_tick)
+{
+	auto value_of = [&](net_id_t net) {
+		return net < values.size() ? (LogicValue)values[net] : Logic_X;
+	};
+
+	std::copy(constant_counts.begin(), constant_counts.end(), driver_counts.begin());
+	std::fill(net_pushed.begin(), net_pushed.end(), 0);
+	std::fill(gate_pushed.begin(), gate_pushed.end(), 0);
+
+	curr_nets.clear();
+	active_gates.clear();
+	pending_events.clear();
+
+	// gate outputs start at the value of their net, unknown without one
+	for (auto& gate : gates) {
+		gate.pins  = 0;
+		gate.known = 0;
+
+		for (auto bits = gate.shared->output_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto net = getGateNet(gate, pin);
+
+			if (net == INVALID_NET_ID) continue;
+
+			auto value = value_of(net);
+
+			if (value == Logic_Z)
+				value = Logic_X;
+
+			++driver_counts[net].counts[value];
+			gate.pins  |= (uint64_t)(value & 1) << pin;
+			gate.known |= (uint64_t)(value >> 1) << pin;
+		}
+	}
+
+	// nets nobody drives float unless they were set
+	for (net_id_t net = 0; net < net_values.size(); ++net) {
+		net_values[net] = driver_counts[net].resolve();
+
+		if (net_values[net] == Logic_Z && value_of(net) != Logic_X)
+			net_values[net] = value_of(net);
+	}
+
+	syncWords();
+
+	for (uint32_t gate_idx = 0; gate_idx < gates.size(); ++gate_idx) {
+		auto& gate = gates[gate_idx];
+
+		for (auto bits = gate.shared->input_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto net = getGateNet(gate, pin);
+
+			if (net == INVALID_NET_ID) continue;
+
+			gate.pins  |= (uint64_t)(net_values[net] & 1) << pin;
+			gate.known |= (uint64_t)(net_values[net] >> 1) << pin;
+		}
+
+		pushGate(gate_idx);
+	}
+
+	tick_accum  = 0.f;
+	tick        = start_tick;
+	evaluations = 0;
+	net_changes = 0;
+
+	if (recorder)
+		recorder->captureAll(tick, net_values);
+
+	if (breakpoints)
+		breakpoints->sync(net_values);
+
+	if (changes)
+		changes->addAll();
+}
+
+void Simulator::step()
+{
+	// the nets changed since the last step, set ones included
+	if (counting_activity)
+		for (auto net : curr_nets)
+			++toggle_counts[net];
+
+	for (auto net : curr_nets) {
+		uint64_t value = net_values[net] & 1;
+		uint64_t known = net_values[net] >> 1;
+		net_pushed[net] = false;
+
+		// the bits of a word are fanned out with it
+		if (net_words[net] == INVALID_WORD_ID)
+			fanoutNet(net_instances[net], net_locals[net], value, known);
+	}
+
+	for (auto word_idx : curr_words)
+		fanoutWord(word_idx);
+
+	curr_nets.clear();
+	curr_words.clear();
+
+	for (auto gate_idx : active_gates) {
+		gate_pushed[gate_idx] = false;
+		evaluateGate(gate_idx);
+	}
+
+	if (counting_activity)
+		for (auto gate_idx : active_gates)
+			++evaluation_counts[gate_idx];
+
+	evaluations += active_gates.size();
+	active_gates.clear();
+
+	++tick;
+
+	pending_events.advance(tick, [this](const NetEvent& event) {
+		moveDriver(event.net, event.from, event.to);
+	});
+
+	// a net whose drivers moved away and back within the tick did not change
+	curr_nets.erase(std::remove_if(curr_nets.begin(), curr_nets.end(), [&](net_id_t net) {
+		if (net_values[net] != net_prev[net]) return false;
+
+		net_pushed[net] = false;
+
+		if (net_words[net] != INVALID_WORD_ID)
+			word_changed[net_words[net]] &= ~(1ull << net_word_bits[net]);
+
+		return true;
+	}), curr_nets.end());
+
+	curr_words.erase(std::remove_if(curr_words.begin(), curr_words.end(), [&](uint32_t word_idx) {
+		return !word_changed[word_idx];
+	}), curr_words.end());
+
+	net_changes += curr_nets.size();
+
+	// nets changed this tick, a net toggled back and forth is dropped by the recorder
+	if (recorder)
+		recorder->capture(tick, curr_nets, net_values);
+
+	if (breakpoints)
+		breakpoints->check(tick, curr_nets, net_values);
+
+	if (changes)
+		changes->add(curr_nets);
+}
+
+// steps ticks ticks, the time jumps ahead once the circuit is stable
+void Simulator::advance(uint64_t ticks)
+{
+	for (uint64_t i = 0; i < ticks; ++i) {
+		if (isStable()) {
+			tick += ticks - i;
+			pending_events.clear(tick);
+			break;
+		}
+
+		step();
+
+		if (breakpoints && breakpoints->isHit()) break;
+	}
+}
+
+uint64_t Simulator::update(float dt, uint64_t max_ticks)
+{
+	tick_accum += dt * tick_rate;
+
+	auto count = (uint64_t)tick_accum;
+
+	if (count > MAX_TICKS_PER_UPDATE) {
+		count      = MAX_TICKS_PER_UPDATE;
+		tick_accum = 0.f;
+	} else {
+		tick_accum -= (float)count;
+	}
+
+	// the rest is left for the next update
+	if (count > max_ticks) {
+		tick_accum += (float)(count - max_ticks);
+		count       = max_ticks;
+	}
+
+	advance(count);
+
+	return count;
+}
+
+void Simulator::setCountingActivity(bool counting)
+{
+	counting_activity = counting;
+
+	toggle_counts.assign(counting ? net_values.size() : 0, 0);
+	evaluation_counts.assign(counting ? gates.size() : 0, 0);
+}
+
+bool Simulator::isCountingActivity() const
+{
+	return counting_activity;
+}
+
+void Simulator::collectActivity(ActivityCounters& counters)
+{
+	counters.net_toggles.resize(net_values.size(), 0);
+	counters.gate_evaluations.resize(gates.size(), 0);
+
+	if (!counting_activity) return;
+
+	for (size_t net = 0; net < toggle_counts.size(); ++net) {
+		counters.net_toggles[net] += toggle_counts[net];
+		toggle_counts[net] = 0;
+	}
+
+	for (size_t gate_idx = 0; gate_idx < evaluation_counts.size(); ++gate_idx) {
+		counters.gate_evaluations[gate_idx] += evaluation_counts[gate_idx];
+		evaluation_counts[gate_idx] = 0;
+	}
+}
+
+void Simulator::getElementGates(std::vector<uint32_t>& offsets, std::vector<uint32_t>& element_gates) const
+{
+	offsets.assign(1, 0);
+	element_gates.clear();
+
+	if (!top) return;
+
+	std::vector<uint32_t> stack;
+
+	for (const auto& ref : top->element_refs) {
+		if (ref.gate != UINT32_MAX)
+			element_gates.emplace_back(instances[0].gate_base + ref.gate);
+
+		if (ref.child != UINT32_MAX)
+			stack.emplace_back(instances[0].child_base + ref.child);
+
+		while (!stack.empty()) {
+			auto inst_idx = stack.back();
+			stack.pop_back();
+
+			const auto& inst = instances[inst_idx];
+
+			for (uint32_t gate = 0; gate < inst.module->gates.size(); ++gate)
+				element_gates.emplace_back(inst.gate_base + gate);
+
+			for (uint32_t child = 0; child < inst.module->children.size(); ++child)
+				stack.emplace_back(inst.child_base + child);
+		}
+
+		offsets.emplace_back((uint32_t)element_gates.size());
+	}
+}
+
+void Simulator::getElementNets(std::vector<uint32_t>& offsets, std::vector<net_id_t>& element_nets) const
+{
+	std::vector<uint32_t> gate_offsets;
+	std::vector<uint32_t> element_gates;
+
+	getElementGates(gate_offsets, element_gates);
+
+	offsets.assign(1, 0);
+	element_nets.clear();
+
+	for (size_t elem = 0; elem + 1 < gate_offsets.size(); ++elem) {
+		for (auto i = gate_offsets[elem]; i < gate_offsets[elem + 1]; ++i) {
+			const auto& gate = gates[element_gates[i]];
+
+			for (auto bits = gate.shared->input_mask | gate.shared->output_mask; bits; bits &= bits - 1)
+				element_nets.emplace_back(getGateNet(gate, count_trailing_zeros(bits)));
+		}
+
+		offsets.emplace_back((uint32_t)element_nets.size());
+	}
+}
+
+void Simulator::setTickRate(float tick_rate)
+{
+	this->tick_rate = std::max(tick_rate, 0.f);
+}
+
+float Simulator::getTickRate() const
+{
+	return tick_rate;
+}
+
+void Simulator::setRecorder(WaveformRecorder* recorder)
+{
+	this->recorder = recorder;
+}
+
+void Simulator::setBreakpoints(Breakpoints* breakpoints)
+{
+	this->breakpoints = breakpoints;
+}
+
+void Simulator::setChangeSet(NetChangeSet* changes)
+{
+	this->changes = changes;
+}
+
+void Simulator::saveState(std::vector<uint8_t>& state) const
+{
+	state.clear();
+
+	write_state(state, (uint64_t)gates.size());
+	write_state(state, (uint64_t)net_values.size());
+	write_state(state, tick);
+
+	for (const auto& gate : gates) {
+		write_state(state, gate.pins);
+		write_state(state, gate.known);
+	}
+
+	write_state_array(state, net_values);
+	write_state_array(state, driver_counts);
+	write_state_array(state, curr_nets);
+	write_state_array(state, active_gates);
+
+	write_state(state, (uint64_t)pending_events.size());
+
+	pending_events.forEach([&](uint64_t time, const NetEvent& event) {
+		write_state(state, time);
+		write_state(state, event.net);
+		write_state(state, event.from);
+		write_state(state, event.to);
+	});
+}
+
+bool Simulator::loadState(const std::vector<uint8_t>& state)
+{
+	StateReader reader(state);
+
+	uint64_t gate_count, net_count;
+
+	if (!reader.read(gate_count) || gate_count != gates.size()) return false;
+	if (!reader.read(net_count) || net_count != net_values.size()) return false;
+
+	auto load = [&]() {
+		if (!reader.read(tick)) return false;
+
+		for (auto& gate : gates)
+			if (!reader.read(gate.pins) || !reader.read(gate.known)) return false;
+
+		if (!reader.readArray(net_values, net_count)) return false;
+		if (!reader.readArray(driver_counts, net_count)) return false;
+		if (!reader.readArray(curr_nets) || !reader.readArray(active_gates)) return false;
+
+		std::fill(net_pushed.begin(), net_pushed.end(), 0);
+		std::fill(gate_pushed.begin(), gate_pushed.end(), 0);
+
+		syncWords();
+
+		for (auto net : curr_nets) {
+			if (net >= net_count) return false;
+			net_pushed[net] = true;
+
+			if (net_words[net] != INVALID_WORD_ID)
+				setWordBit(net, (LogicValue)net_values[net]);
+		}
+
+		for (auto gate_idx : active_gates) {
+			if (gate_idx >= gate_count) return false;
+			gate_pushed[gate_idx] = true;
+		}
+
+		uint64_t event_count;
+
+		if (!reader.read(event_count)) return false;
+
+		pending_events.clear(tick);
+
+		for (uint64_t i = 0; i < event_count; ++i) {
+			uint64_t time;
+			NetEvent event;
+
+			if (!reader.read(time) || !reader.read(event.net) || !reader.read(event.from) || !reader.read(event.to))
+				return false;
+
+			if (time <= tick || event.net >= net_count) return false;
+
+			pending_events.schedule(time, event);
+		}
+
+		return true;
+	};
+
+	tick_accum = 0.f;
+
+	if (load()) {
+		if (changes)
+			changes->addAll();
+
+		return true;
+	}
+
+	reset();
+	return false;
+}
+
+void Simulator::setNet(net_id_t net, LogicValue value)
+{
+	driveNet(net, value);
+
+	if (recorder)
+		recorder->capture(tick, net, value);
+
+	if (breakpoints)
+		breakpoints->check(tick, net, net_values);
+
+	if (changes)
+		changes->add(net);
+}
+
+LogicValue Simulator::getNet(net_id_t net) const
+{
+	return (LogicValue)net_values[net];
+}
+
+const std::vector<uint8_t>& Simulator::getNetValues() const
+{
+	return net_values;
+}
+
+bool Simulator::isStable() const
+{
+	return curr_nets.empty() && active_gates.empty() && pending_events.empty();
+}
+
+bool Simulator::hasDelays() const
+{
+	return top && top->delays;
+}
+
+uint64_t Simulator::getTick() const
+{
+	return tick;
+}
+
+uint64_t Simulator::getEventCount() const
+{
+	return evaluations;
+}
+
+uint64_t Simulator::getNetChangeCount() const
+{
+	return net_changes;
+}
+
+size_t Simulator::getGateCount() const
+{
+	return gates.size();
+}
+
+size_t Simulator::getNetCount() const
+{
+	return net_values.size();
+}
+
+size_t Simulator::getWordCount() const
+{
+	return word_values.size();
+}
+
+void Simulator::flatten(
+	std::vector<Gate>& flat_gates,
+	std::vector<net_id_t>& flat_gate_nets,
+	std::vector<uint32_t>& flat_fanout_offsets,
+	std::vector<Fanout>& flat_fanouts) const
+{
+	flat_gates.clear();
+	flat_gate_nets.clear();
+	flat_fanout_offsets.assign(getNetCount() + 1, 0);
+
+	for (uint32_t gate_idx = 0; gate_idx < gates.size(); ++gate_idx) {
+		const auto& src    = gates[gate_idx];
+		const auto& inst   = instances[src.instance];
+		const auto& module = *inst.module;
+
+		auto local_idx = gate_idx - inst.gate_base;
+		auto net_end   = local_idx + 1 < module.gates.size() ?
+			module.gates[local_idx + 1].net_begin : (uint32_t)module.gate_nets.size();
+
+		auto& gate = flat_gates.emplace_back(src);
+		gate.net_begin = (uint32_t)flat_gate_nets.size();
+		gate.instance  = 0;
+
+		for (auto i = src.net_begin; i < net_end; ++i) {
+			auto net = toGlobal(inst, module.gate_nets[i]);
+			auto pin = i - src.net_begin;
+
+			flat_gate_nets.emplace_back(net);
+
+			if (net != INVALID_NET_ID && ((src.shared->input_mask >> pin) & 1))
+				++flat_fanout_offsets[net + 1];
+		}
+	}
+
+	for (size_t i = 0; i < getNetCount(); ++i)
+		flat_fanout_offsets[i + 1] += flat_fanout_offsets[i];
+
+	flat_fanouts.resize(flat_fanout_offsets.back());
+
+	std::vector<uint32_t> cursor(flat_fanout_offsets.begin(), flat_fanout_offsets.end() - 1);
+
+	for (uint32_t gate_idx = 0; gate_idx < flat_gates.size(); ++gate_idx) {
+		auto& gate = flat_gates[gate_idx];
+
+		for (auto bits = gate.shared->input_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto net = flat_gate_nets[gate.net_begin + pin];
+
+			if (net != INVALID_NET_ID)
+				flat_fanouts[cursor[net]++] = { gate_idx, pin };
+		}
+	}
+}
+
+void Simulator::flattenWords(std::vector<uint32_t>& flat_word_offsets, std::vector<net_id_t>& flat_word_nets) const
+{
+	flat_word_offsets.assign(1, 0);
+	flat_word_nets.clear();
+
+	for (const auto& inst : instances) {
+		const auto& module = *inst.module;
+
+		for (uint32_t word = 0; word < module.getWordCount(); ++word) {
+			for (auto i = module.word_offsets[word]; i < module.word_offsets[word + 1]; ++i)
+				flat_word_nets.emplace_back(toGlobal(inst, module.word_nets[i]));
+
+			flat_word_offsets.emplace_back((uint32_t)flat_word_nets.size());
+		}
+	}
+}
+
+net_id_t Simulator::toGlobal(const Instance& inst, net_id_t local) const
+{
+	if (local == INVALID_NET_ID) return INVALID_NET_ID;
+
+	auto port_count = inst.module->port_count;
+
+	return local < port_count ? port_nets[inst.port_base + local] : inst.net_base + local - port_count;
+}
+
+net_id_t Simulator::getGateNet(const Gate& gate, uint32_t pin) const
+{
+	const auto& inst = instances[gate.instance];
+	return toGlobal(inst, inst.module->gate_nets[gate.net_begin + pin]);
+}
+
+// pushes the gates reading a net, through the pins of the units it is connected to
+void Simulator::fanoutNet(uint32_t inst_idx, net_id_t local, uint64_t value, uint64_t known)
+{
+	const auto& inst   = instances[inst_idx];
+	const auto& module = *inst.module;
+
+	for (auto i = module.fanout_offsets[local]; i < module.fanout_offsets[local + 1]; ++i) {
+		auto [gate_idx, pin] = module.fanouts[i];
+		gate_idx += inst.gate_base;
+
+		auto& gate = gates[gate_idx];
+		gate.pins  = (gate.pins & ~(1ull << pin)) | (value << pin);
+		gate.known = (gate.known & ~(1ull << pin)) | (known << pin);
+		pushGate(gate_idx);
+	}
+
+	fanoutPorts(inst_idx, local, value, known);
+}
+
+void Simulator::fanoutPorts(uint32_t inst_idx, net_id_t local, uint64_t value, uint64_t known)
+{
+	const auto& inst   = instances[inst_idx];
+	const auto& module = *inst.module;
+
+	for (auto i = module.child_port_offsets[local]; i < module.child_port_offsets[local + 1]; ++i) {
+		auto [child, port] = module.child_port_refs[i];
+		fanoutNet(inst.child_base + child, port, value, known);
+	}
+}
+
+// one update per run of pins reading changed bits, units on its bits through their ports
+void Simulator::fanoutWord(uint32_t word_idx)
+{
+	auto inst_idx      = word_instances[word_idx];
+	const auto& inst   = instances[inst_idx];
+	const auto& module = *inst.module;
+
+	auto local   = word_idx - inst.word_base;
+	auto changed = std::exchange(word_changed[word_idx], 0);
+	auto value   = word_values[word_idx];
+	auto known   = word_known[word_idx];
+
+	for (auto i = module.word_fanout_offsets[local]; i < module.word_fanout_offsets[local + 1]; ++i) {
+		const auto& fanout = module.word_fanouts[i];
+
+		if (!((changed >> fanout.bit) & fanout.mask)) continue;
+
+		auto gate_idx = inst.gate_base + fanout.gate;
+		auto pins     = fanout.mask << fanout.pin;
+
+		auto& gate = gates[gate_idx];
+		gate.pins  = (gate.pins & ~pins) | (((value >> fanout.bit) & fanout.mask) << fanout.pin);
+		gate.known = (gate.known & ~pins) | (((known >> fanout.bit) & fanout.mask) << fanout.pin);
+		pushGate(gate_idx);
+	}
+
+	if (module.children.empty()) return;
+
+	for (auto bits = changed; bits; bits &= bits - 1) {
+		auto bit = count_trailing_zeros(bits);
+		fanoutPorts(inst_idx, module.word_nets[module.word_offsets[local] + bit], (value >> bit) & 1, (known >> bit) & 1);
+	}
+}
+
+void Simulator::pushNet(net_id_t net)
+{
+	if (net_pushed[net]) return;
+
+	net_pushed[net] = true;
+	net_prev[net]   = net_values[net];
+	curr_nets.emplace_back(net);
+}
+
+void Simulator::pushGate(uint32_t gate_idx)
+{
+	if (gate_pushed[gate_idx]) return;
+
+	gate_pushed[gate_idx] = true;
+	active_gates.emplace_back(gate_idx);
+}
+
+void Simulator::evaluateGate(uint32_t gate_idx)
+{
+	auto& gate   = gates[gate_idx];
+	auto& shared = *gate.shared;
+
+	uint64_t outputs;
+	uint64_t known = gate.known;
+
+	if (!(~gate.known & (shared.input_mask | shared.output_mask))) {
+		outputs = shared.evaluate(shared, gate.pins);
+		known   = ~0ull;
+	} else {
+		outputs = shared.logic.evaluateUnknown(gate.pins, known);
+	}
+
+	outputs &= known;
+
+	auto changed = ((outputs ^ gate.pins) | (known ^ gate.known)) & shared.output_mask;
+
+	const auto& pin_delays = instances[gate.instance].module->pin_delays;
+
+	for (auto bits = changed; bits; bits &= bits - 1) {
+		auto pin = count_trailing_zeros(bits);
+		auto net = getGateNet(gate, pin);
+
+		if (net == INVALID_NET_ID) continue;
+
+		auto from = get_logic_value(gate.pins, gate.known, pin);
+		auto to   = get_logic_value(outputs, known, pin);
+
+		// transport delay, every scheduled change is applied so glitches propagate
+		if (!pin_delays.empty() && pin_delays[gate.net_begin + pin] > 1)
+			pending_events.schedule(tick + pin_delays[gate.net_begin + pin], { net, from, to });
+		else
+			moveDriver(net, from, to);
+	}
+
+	gate.pins  ^= (outputs ^ gate.pins) & shared.output_mask;
+	gate.known ^= (known ^ gate.known) & shared.output_mask;
+}
+
+void Simulator::moveDriver(net_id_t net, LogicValue from, LogicValue to)
+{
+	auto& counts = driver_counts[net];
+	counts.move(from, to);
+
+	driveNet(net, counts.resolve());
+}
+
+void Simulator::driveNet(net_id_t net, LogicValue value)
+{
+	if (net_values[net] == value) return;
+
+	pushNet(net);
+	net_values[net] = value;
+
+	if (net_words[net] != INVALID_WORD_ID)
+		setWordBit(net, value);
+}
+
+void Simulator::setWordBit(net_id_t net, LogicValue value)
+{
+	auto word_idx = net_words[net];
+	auto bit      = 1ull << net_word_bits[net];
+
+	if (!word_changed[word_idx])
+		curr_words.emplace_back(word_idx);
+
+	word_changed[word_idx] |= bit;
+	word_values[word_idx]   = (value & 1) ? word_values[word_idx] | bit : word_values[word_idx] & ~bit;
+	word_known[word_idx]    = (value >> 1) ? word_known[word_idx] | bit : word_known[word_idx] & ~bit;
+}
+
+// the planes of every word from its bit nets, none of them changed
+void Simulator::syncWords()
+{
+	std::fill(word_values.begin(), word_values.end(), 0);
+	std::fill(word_known.begin(), word_known.end(), 0);
+	std::fill(word_changed.begin(), word_changed.end(), 0);
+	curr_words.clear();
+
+	for (net_id_t net = 0; net < net_words.size(); ++net) {
+		auto word_idx = net_words[net];
+
+		if (word_idx == INVALID_WORD_ID) continue;
+
+		word_values[word_idx] |= (uint64_t)(net_values[net] & 1) << net_word_bits[net];
+		word_known[word_idx]  |= (uint64_t)(net_values[net] >> 1) << net_word_bits[net];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "logic_value.h"
+#include "activity_counters.h"
+#include "unit_module.h"
+#include "breakpoints.h"
+#include "waveform_recorder.h"
+#include "net_change_set.h"
+#include "../circuit_element.h"
+#include "../util/timing_wheel.hpp"
+#include <memory>
+#include <vector>
+
+#define DEFAULT_TICK_RATE 1000.f
+#define MAX_TICKS_PER_UPDATE 100000
+
+// units are elaborated into instances of their shared UnitModule, only the gate and net
+// state is per instance. nets of the sheet keep their ids, the private nets of each
+// instance are numbered after them. the bit nets of a word still change one by one, but a
+// tick fans the word out once with every bit that changed
+class Simulator {
+public:
+	Simulator();
+
+	void build(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count);
+	void clear();
+	void reset();
+	// a reset that starts from the values of a rebuilt circuit instead of X, gate outputs take the
+	// value of their net and a net nobody drives keeps it. nets past the end of values start at X
+	void restore(const std::vector<uint8_t>& values, uint64_t start_tick);
+
+	void step();
+	void advance(uint64_t ticks);
+	uint64_t update(float dt, uint64_t max_ticks = MAX_TICKS_PER_UPDATE);
+
+	void setTickRate(float tick_rate);
+	float getTickRate() const;
+
+	void setRecorder(WaveformRecorder* recorder);
+	void setBreakpoints(Breakpoints* breakpoints);
+	void setChangeSet(NetChangeSet* changes);
+
+	// counts net toggles and gate evaluations until it is turned off again, collectActivity
+	// adds the counts since the last collect to counters
+	void setCountingActivity(bool counting);
+	bool isCountingActivity() const;
+	void collectActivity(ActivityCounters& counters);
+
+	// gates of each element build was given as CSR, a unit has every gate of its instance
+	void getElementGates(std::vector<uint32_t>& offsets, std::vector<uint32_t>& element_gates) const;
+	// nets of the pins of those gates in the same order, INVALID_NET_ID for unconnected ones
+	void getElementNets(std::vector<uint32_t>& offsets, std::vector<net_id_t>& element_nets) const;
+
+	// everything that changes while simulating, loadState fails on a state of another circuit
+	void saveState(std::vector<uint8_t>& state) const;
+	bool loadState(const std::vector<uint8_t>& state);
+
+	void setNet(net_id_t net, LogicValue value);
+	LogicValue getNet(net_id_t net) const;
+	const std::vector<uint8_t>& getNetValues() const;
+
+	bool isStable() const;
+	bool hasDelays() const;
+	uint64_t getTick() const;
+	uint64_t getEventCount() const;     // gate evaluations since the reset
+	uint64_t getNetChangeCount() const; // net value changes since the reset
+	size_t getGateCount() const;
+	size_t getNetCount() const;
+	size_t getWordCount() const;
+
+private:
+	friend class PatternSimulator;
+	friend class ParallelSimulator;
+	friend class Levelization;
+
+	using Fanout     = UnitModule::Fanout;
+	using WordFanout = UnitModule::WordFanout;
+
+	struct Gate {
+		const LogicElement::Shared* shared;
+		uint64_t                    pins;  // value plane
+		uint64_t                    known; // known plane
+		uint32_t                    net_begin;
+		uint32_t                    instance;
+	};
+
+	struct Instance {
+		const UnitModule* module;
+		uint32_t          gate_base;
+		net_id_t          net_base;   // first private net
+		uint32_t          port_base;  // nets of its pins are port_nets[port_base..port_base + module->port_count]
+		uint32_t          child_base; // first instance of its children
+		uint32_t          word_base;
+	};
+
+	struct NetEvent {
+		net_id_t   net;
+		LogicValue from;
+		LogicValue to;
+	};
+
+	// flat netlist with global net ids for the engines that don't elaborate units
+	void flatten(
+		std::vector<Gate>& flat_gates,
+		std::vector<net_id_t>& flat_gate_nets,
+		std::vector<uint32_t>& flat_fanout_offsets,
+		std::vector<Fanout>& flat_fanouts) const;
+
+	// global bit nets of each word, in word order
+	void flattenWords(std::vector<uint32_t>& flat_word_offsets, std::vector<net_id_t>& flat_word_nets) const;
+
+	net_id_t toGlobal(const Instance& inst, net_id_t local) const;
+	net_id_t getGateNet(const Gate& gate, uint32_t pin) const;
+	void fanoutNet(uint32_t inst_idx, net_id_t local, uint64_t value, uint64_t known);
+	void fanoutPorts(uint32_t inst_idx, net_id_t local, uint64_t value, uint64_t known);
+	void fanoutWord(uint32_t word_idx);
+
+	void pushNet(net_id_t net);
+	void pushGate(uint32_t gate_idx);
+	void setWordBit(net_id_t net, LogicValue value);
+	void syncWords();
+	void evaluateGate(uint32_t gate_idx);
+	void moveDriver(net_id_t net, LogicValue from, LogicValue to);
+	void driveNet(net_id_t net, LogicValue value);
+
+	std::shared_ptr<UnitModule> top;
+	std::vector<Instance>       instances;
+	std::vector<net_id_t>       port_nets;
+	std::vector<uint32_t>       net_instances; // instance that owns each net
+	std::vector<net_id_t>       net_locals;    // local id of each net in its owner
+	std::vector<uint32_t>       net_words;     // word of each net, INVALID_WORD_ID if it has none
+	std::vector<uint8_t>        net_word_bits; // bit of each net in its word
+	std::vector<uint32_t>       word_instances;
+
+	std::vector<Gate>     gates;
+
+	std::vector<uint8_t>      net_values; // LogicValue
+	std::vector<DriverCounts> driver_counts;
+	std::vector<DriverCounts> constant_counts; // VCC and GND pins
+	std::vector<uint8_t>  net_pushed;
+	std::vector<uint8_t>  net_prev; // value of each net in curr_nets before it was pushed
+	std::vector<uint8_t>  gate_pushed;
+	std::vector<net_id_t> curr_nets;
+	std::vector<uint32_t> active_gates;
+
+	std::vector<uint64_t> word_values; // value plane
+	std::vector<uint64_t> word_known;  // known plane
+	std::vector<uint64_t> word_changed; // bits changed since the word was fanned out, the word is in curr_words if any
+	std::vector<uint32_t> curr_words;
+
+	TimingWheel<NetEvent> pending_events;
+
+	float    tick_rate;
+	float    tick_accum;
+	uint64_t tick;
+	uint64_t evaluations;
+	uint64_t net_changes;
+
+	std::vector<uint32_t> toggle_counts;
+	std::vector<uint32_t> evaluation_counts;
+	bool                  counting_activity;
+
+	WaveformRecorder* recorder;
+	Breakpoints*      breakpoints;
+	NetChangeSet*     changes;
+};
@@ -0,0 +1,338 @@
+#include "unit_module.h"
+
+#include "../util/bit_utils.h"
+#include <algorithm>
+
+UnitModule::UnitModule() :
+	port_count(0),
+	input_mask(0),
+	output_mask(0),
+	delays(false),
+	net_count(0),
+	instance_gate_count(0),
+	instance_net_count(0)
+{}
+
+bool UnitModule::build(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count, bool with_ports, std::string& error)
+{
+	using Port_t = LogicElement::Shared::Port;
+
+	std::vector<net_id_t> local_ids(net_count, INVALID_NET_ID);
+
+	if (with_ports) {
+		for (auto* elem : elements) {
+			auto kind = elem->shared->port;
+
+			if (kind == Port_t::None) continue;
+
+			if (elem->pins.empty() || !elem->pins[0].net) {
+				error = "unit port is not connected";
+				return false;
+			}
+
+			ports.push_back({ kind, elem->pos, elem->pins[0].net->id });
+		}
+
+		if (ports.empty()) {
+			error = "sheet has no unit ports";
+			return false;
+		}
+
+		if (ports.size() > MAX_UNIT_PORTS) {
+			error = "unit has more than " + std::to_string(MAX_UNIT_PORTS) + " ports";
+			return false;
+		}
+
+		// inputs first, then top to bottom and left to right as placed on the sheet
+		std::sort(ports.begin(), ports.end(), [](const Port& lhs, const Port& rhs) {
+			if (lhs.kind != rhs.kind) return lhs.kind == Port_t::Input;
+			if (lhs.pos.y != rhs.pos.y) return lhs.pos.y < rhs.pos.y;
+			return lhs.pos.x < rhs.pos.x;
+		});
+
+		for (const auto& port : ports) {
+			if (local_ids[port.net] != INVALID_NET_ID) {
+				error = "two unit ports are connected to the same net";
+				return false;
+			}
+
+			if (port.kind == Port_t::Input)
+				input_mask |= 1ull << port_count;
+			else
+				output_mask |= 1ull << port_count;
+
+			local_ids[port.net] = port_count++;
+		}
+	}
+
+	auto next_id = (net_id_t)port_count;
+
+	for (auto& id : local_ids)
+		if (id == INVALID_NET_ID)
+			id = next_id++;
+
+	auto to_local = [&](const Pin& pin) {
+		return pin.net ? local_ids[pin.net->id] : INVALID_NET_ID;
+	};
+
+	this->net_count     = net_count;
+	instance_gate_count = 0;
+	instance_net_count  = net_count - port_count;
+
+	fanout_offsets.resize(net_count + 1, 0);
+	child_port_offsets.resize(net_count + 1, 0);
+	constant_counts.resize(net_count, {});
+
+	for (auto* elem : elements) {
+		auto& shared = *elem->shared;
+
+		for (auto bits = shared.vcc_mask | shared.gnd_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto id  = pin < elem->pins.size() ? to_local(elem->pins[pin]) : INVALID_NET_ID;
+
+			if (id != INVALID_NET_ID)
+				++constant_counts[id].counts[((shared.vcc_mask >> pin) & 1) ? Logic_1 : Logic_0];
+		}
+
+		auto& ref = element_refs.emplace_back();
+		ref.gate  = UINT32_MAX;
+		ref.child = UINT32_MAX;
+
+		if (shared.module) {
+			ref.child = (uint32_t)children.size();
+
+			auto& child = children.emplace_back();
+			child.module     = shared.module.get();
+			child.port_begin = (uint32_t)child_ports.size();
+
+			for (uint32_t port = 0; port < child.module->port_count; ++port) {
+				auto id = port < elem->pins.size() ? to_local(elem->pins[port]) : INVALID_NET_ID;
+
+				child_ports.emplace_back(id);
+
+				if (id != INVALID_NET_ID)
+					++child_port_offsets[id + 1];
+			}
+
+			instance_gate_count += child.module->instance_gate_count;
+			instance_net_count  += child.module->instance_net_count;
+			delays              |= child.module->delays;
+			continue;
+		}
+
+		if (!shared.evaluate) continue;
+
+		ref.gate = (uint32_t)gates.size();
+
+		auto& gate = gates.emplace_back();
+		gate.shared    = &shared;
+		gate.net_begin = (uint32_t)gate_nets.size();
+
+		for (uint32_t pin = 0; pin < elem->pins.size(); ++pin) {
+			auto id = to_local(elem->pins[pin]);
+
+			gate_nets.emplace_back(id);
+
+			if (id != INVALID_NET_ID && ((shared.input_mask >> pin) & 1))
+				++fanout_offsets[id + 1];
+		}
+
+		for (const auto& layout : shared.pin_layouts) {
+			auto pin   = layout.pinout - 1u;
+			auto delay = layout.delay ? layout.delay : shared.delay;
+
+			if (layout.io != PinLayout::Output || pin >= elem->pins.size() || delay <= 1) continue;
+
+			if (pin_delays.empty())
+				pin_delays.resize(gate_nets.size() - elem->pins.size(), 1);
+
+			pin_delays.resize(gate_nets.size(), 1);
+			pin_delays[gate.net_begin + pin] = delay;
+		}
+	}
+
+	if (!pin_delays.empty()) {
+		pin_delays.resize(gate_nets.size(), 1);
+		delays = true;
+	}
+
+	instance_gate_count += gates.size();
+
+	for (size_t i = 0; i < net_count; ++i) {
+		fanout_offsets[i + 1]     += fanout_offsets[i];
+		child_port_offsets[i + 1] += child_port_offsets[i];
+	}
+
+	fanouts.resize(fanout_offsets.back());
+	child_port_refs.resize(child_port_offsets.back());
+
+	std::vector<uint32_t> cursor(fanout_offsets.begin(), fanout_offsets.end() - 1);
+
+	for (uint32_t gate_idx = 0; gate_idx < gates.size(); ++gate_idx) {
+		auto& gate = gates[gate_idx];
+
+		for (auto bits = gate.shared->input_mask; bits; bits &= bits - 1) {
+			auto pin = count_trailing_zeros(bits);
+			auto id  = gate_nets[gate.net_begin + pin];
+
+			if (id != INVALID_NET_ID)
+				fanouts[cursor[id]++] = { gate_idx, pin };
+		}
+	}
+
+	// the widest bus gets a net shared by several, a bus left with less than two private nets
+	// is not worth a word
+	std::vector<Bus*> sorted_buses(buses);
+
+	std::stable_sort(sorted_buses.begin(), sorted_buses.end(), [](const Bus* lhs, const Bus* rhs) {
+		return lhs->width > rhs->width;
+	});
+
+	std::vector<uint8_t> word_bits(net_count, 0);
+
+	word_offsets.assign(1, 0);
+
+	for (auto* bus : sorted_buses) {
+		auto begin = word_nets.size();
+
+		for (auto* net : bus->nets) {
+			if (!net) continue;
+
+			auto id = local_ids[net->id];
+
+			if (id < port_count || word_bits[id]) continue;
+
+			word_bits[id] = true;
+			word_nets.emplace_back(id);
+		}
+
+		if (word_nets.size() - begin < 2) {
+			for (auto i = begin; i < word_nets.size(); ++i)
+				word_bits[word_nets[i]] = false;
+
+			word_nets.resize(begin);
+			continue;
+		}
+
+		word_offsets.emplace_back((uint32_t)word_nets.size());
+	}
+
+	build_word_fanouts(word_offsets, word_nets, fanout_offsets, fanouts, word_fanout_offsets, word_fanouts);
+
+	cursor.assign(child_port_offsets.begin(), child_port_offsets.end() - 1);
+
+	for (uint32_t child_idx = 0; child_idx < children.size(); ++child_idx) {
+		auto& child = children[child_idx];
+
+		for (uint32_t port = 0; port < child.module->port_count; ++port) {
+			auto id = child_ports[child.port_begin + port];
+
+			if (id != INVALID_NET_ID)
+				child_port_refs[cursor[id]++] = { child_idx, port };
+		}
+	}
+
+	return true;
+}
+
+size_t UnitModule::getNetCount() const
+{
+	return net_count;
+}
+
+size_t UnitModule::getWordCount() const
+{
+	return word_offsets.empty() ? 0 : word_offsets.size() - 1;
+}
+
+size_t UnitModule::getInstanceGateCount() const
+{
+	return instance_gate_count;
+}
+
+size_t UnitModule::getInstanceNetCount() const
+{
+	return instance_net_count;
+}
+
+void build_word_fanouts(
+	const std::vector<uint32_t>& word_offsets,
+	const std::vector<net_id_t>& word_nets,
+	const std::vector<uint32_t>& fanout_offsets,
+	const std::vector<UnitModule::Fanout>& fanouts,
+	std::vector<uint32_t>& word_fanout_offsets,
+	std::vector<UnitModule::WordFanout>& word_fanouts)
+{
+	using WordFanout = UnitModule::WordFanout;
+
+	word_fanout_offsets.assign(1, 0);
+	word_fanouts.clear();
+
+	std::vector<WordFanout> reads;
+
+	for (size_t word = 0; word + 1 < word_offsets.size(); ++word) {
+		reads.clear();
+
+		for (auto i = word_offsets[word]; i < word_offsets[word + 1]; ++i) {
+			auto net = word_nets[i];
+			auto bit = (uint16_t)(i - word_offsets[word]);
+
+			for (auto j = fanout_offsets[net]; j < fanout_offsets[net + 1]; ++j)
+				reads.push_back({ fanouts[j].gate, (uint16_t)fanouts[j].pin, bit, 1 });
+		}
+
+		std::sort(reads.begin(), reads.end(), [](const WordFanout& lhs, const WordFanout& rhs) {
+			return lhs.gate != rhs.gate ? lhs.gate < rhs.gate : lhs.pin < rhs.pin;
+		});
+
+		auto begin = word_fanouts.size();
+
+		for (const auto& read : reads) {
+			if (word_fanouts.size() > begin) {
+				auto& last  = word_fanouts.back();
+				auto  width = count_bits(last.mask);
+
+				if (last.gate == read.gate && last.pin + width == read.pin && last.bit + width == read.bit) {
+					last.mask = (last.mask << 1) | 1;
+					continue;
+				}
+			}
+
+			word_fanouts.emplace_back(read);
+		}
+
+		word_fanout_offsets.emplace_back((uint32_t)word_fanouts.size());
+	}
+}
+
+std::shared_ptr<LogicElement::Shared> create_unit_shared(std::shared_ptr<UnitModule> module, const std::string& name, uint64_t shared_id)
+{
+	auto shared  = std::make_shared<LogicElement::Shared>();
+	auto in_row  = 0.f;
+	auto out_row = 0.f;
+	auto rows    = std::max(count_bits(module->input_mask), count_bits(module->output_mask));
+
+	shared->name        = name;
+	shared->category    = "unit";
+	shared->shared_id   = shared_id;
+	shared->element_id  = shared_id;
+	shared->extent      = Rect(-2.f, -0.5f, 4.f, (float)rows);
+	shared->input_mask  = module->input_mask;
+	shared->output_mask = module->output_mask;
+	shared->delay       = 1;
+
+	// one grid apart in port order
+	for (uint32_t port = 0; port < module->port_count; ++port) {
+		auto& layout = shared->pin_layouts.emplace_back();
+		bool input   = (module->input_mask >> port) & 1;
+
+		layout.io     = input ? PinLayout::Input : PinLayout::Output;
+		layout.pinout = port + 1;
+		layout.pos    = input ? vec2(-2.f, in_row++) : vec2(2.f, out_row++);
+		layout.delay  = 0;
+	}
+
+	shared->module = std::move(module);
+
+	return shared;
+}
\ No newline at end of file
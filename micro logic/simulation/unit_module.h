@@ -0,0 +1,111 @@
+#pragma once
+
+#include "logic_value.h"
+#include "../circuit_element.h"
+#include <string>
+#include <vector>
+
+#define MAX_UNIT_PORTS 64
+#define INVALID_WORD_ID UINT32_MAX
+
+// a schematic sheet compiled once and shared by every instance of its unit.
+// net ids are local to the module, the ports come first so nets [0, port_count) are
+// the nets of the instance's pins (bit n is port n) and the rest are private to each instance.
+// the private bit nets of a bus are packed into a word, the engines propagate a change of
+// any of its bits as one value through the word fanouts
+class UnitModule {
+public:
+	struct Gate {
+		const LogicElement::Shared* shared;
+		uint32_t                    net_begin;
+	};
+
+	struct Fanout {
+		uint32_t gate;
+		uint32_t pin;
+	};
+
+	// pins [pin, pin + width) of a gate reading bits [bit, bit + width) of a word, mask has width bits
+	struct WordFanout {
+		uint32_t gate;
+		uint16_t pin;
+		uint16_t bit;
+		uint64_t mask;
+	};
+
+	struct Child {
+		const UnitModule* module;
+		uint32_t          port_begin; // local nets of its pins are child_ports[port_begin..port_begin + module->port_count]
+	};
+
+	struct ChildPort {
+		uint32_t child;
+		uint32_t port;
+	};
+
+	struct Port {
+		LogicElement::Shared::Port kind;
+		vec2                       pos;
+		net_id_t                   net;
+	};
+
+	// what each element given to build became, UINT32_MAX if it has no gate or child
+	struct ElementRef {
+		uint32_t gate;
+		uint32_t child;
+	};
+
+	UnitModule();
+
+	bool build(const std::vector<LogicElement*>& elements, const std::vector<Bus*>& buses, size_t net_count, bool with_ports, std::string& error);
+
+	size_t getNetCount() const;
+	size_t getWordCount() const;
+	size_t getInstanceGateCount() const;
+	size_t getInstanceNetCount() const;
+
+public:
+	std::vector<Gate>     gates;
+	std::vector<net_id_t> gate_nets;
+	std::vector<uint32_t> fanout_offsets; // CSR, fanouts of local net n are fanouts[fanout_offsets[n]..fanout_offsets[n + 1]]
+	std::vector<Fanout>   fanouts;
+
+	std::vector<uint32_t>   word_offsets; // CSR, bit n of word w is local net word_nets[word_offsets[w] + n]
+	std::vector<net_id_t>   word_nets;
+	std::vector<uint32_t>   word_fanout_offsets; // CSR, like fanout_offsets for the words
+	std::vector<WordFanout> word_fanouts;
+
+	std::vector<Child>     children;
+	std::vector<net_id_t>  child_ports;
+	std::vector<uint32_t>  child_port_offsets; // CSR, child pins on local net n
+	std::vector<ChildPort> child_port_refs;
+
+	std::vector<DriverCounts> constant_counts; // VCC and GND pins
+	std::vector<uint32_t>     pin_delays;      // indexed like gate_nets, empty if every delay is 1
+
+	std::vector<ElementRef> element_refs;
+
+	std::vector<Port> ports;
+	uint32_t          port_count;
+	uint64_t          input_mask;  // bit n is port n
+	uint64_t          output_mask;
+	bool              delays;      // this module or any child has delays
+
+private:
+	size_t net_count;
+	size_t instance_gate_count; // gates of one instance including its children
+	size_t instance_net_count;  // private nets of one instance including its children
+};
+
+// the fanouts of the bit nets of each word merged into runs of pins reading consecutive bits,
+// sorted by gate
+void build_word_fanouts(
+	const std::vector<uint32_t>& word_offsets,
+	const std::vector<net_id_t>& word_nets,
+	const std::vector<uint32_t>& fanout_offsets,
+	const std::vector<UnitModule::Fanout>& fanouts,
+	std::vector<uint32_t>& word_fanout_offsets,
+	std::vector<UnitModule::WordFanout>& word_fanouts);
+
+// shared data of a unit element, inputs on the left and outputs on the right in port order
+std::shared_ptr<LogicElement::Shared> create_unit_shared(std::shared_ptr<UnitModule> module, const std::string& name, uint64_t shared_id);
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include "vcd_writer.h"
+
+static std::string make_vcd_id(uint32_t index)
+{
+	// printable characters '!' to '~', shortest codes first
+	std::string id;
+
+	do {
+		id.push_back((char)('!' + index % 94));
+		index /= 94;
+	} while (index--);
+
+	return id;
+}
+
+static char to_vcd_char(LogicValue value)
+{
+	switch (value) {
+	case Logic_0: return '0';
+	case Logic_1: return '1';
+	case Logic_Z: return 'z';
+	default:      return 'x';
+	}
+}
+
+VcdWriter::VcdWriter() :
+	file(nullptr),
+	quit(false),
+	last_tick(0),
+	has_tick(false),
+	bytes_written(0)
+{}
+
+VcdWriter::~VcdWriter()
+{
+	close();
+}
+
+bool VcdWriter::open(const std::string& path, const std::vector<std::string>& names, const char* timescale)
+{
+	std::vector<uint32_t> vars(names.size());
+
+	for (uint32_t i = 0; i < names.size(); ++i)
+		vars[i] = i;
+
+	return open(path, names, vars, timescale);
+}
+
+bool VcdWriter::open(const std::string& path, const std::vector<std::string>& names, const std::vector<uint32_t>& vars, const char* timescale)
+{
+	close();
+
+	file = std::fopen(path.c_str(), "wb");
+
+	if (!file) return false;
+
+	ids.clear();
+
+	for (auto var : vars)
+		while (ids.size() <= var)
+			ids.emplace_back(make_vcd_id((uint32_t)ids.size()));
+
+	buffer.clear();
+	buffer += "$timescale ";
+	buffer += timescale;
+	buffer += " $end\n";
+	buffer += "$scope module micro_logic $end\n";
+
+	for (uint32_t i = 0; i < names.size(); ++i) {
+		buffer += "$var wire 1 ";
+		buffer += ids[vars[i]];
+		buffer += ' ';
+		buffer += names[i];
+		buffer += " $end\n";
+	}
+
+	buffer += "$upscope $end\n";
+	buffer += "$enddefinitions $end\n";
+
+	bytes_written = 0;
+	last_tick     = 0;
+	has_tick      = false;
+	quit          = false;
+
+	writeBuffer();
+
+	chunk.reserve(VCD_CHUNK_SIZE);
+	thread = std::thread(&VcdWriter::writerMain, this);
+
+	return true;
+}
+
+void VcdWriter::close()
+{
+	if (!file) return;
+
+	flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+
+	cv.notify_one();
+	thread.join();
+
+	std::fclose(file);
+	file = nullptr;
+
+	chunk.clear();
+	free_chunks.clear();
+}
+
+bool VcdWriter::isOpen() const
+{
+	return file != nullptr;
+}
+
+void VcdWriter::change(uint64_t tick, uint32_t var, LogicValue value)
+{
+	chunk.push_back({ tick, var, value });
+
+	if (chunk.size() >= VCD_CHUNK_SIZE)
+		flush();
+}
+
+void VcdWriter::flush()
+{
+	if (chunk.empty()) return;
+
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+
+		// back pressure, the simulation waits for the disk instead of growing the queue
+		cv_space.wait(lock, [this] { return queue.size() < VCD_MAX_CHUNKS; });
+
+		queue.emplace_back(std::move(chunk));
+
+		if (free_chunks.empty()) {
+			chunk = std::vector<Change>();
+		} else {
+			chunk = std::move(free_chunks.back());
+			free_chunks.pop_back();
+		}
+	}
+
+	cv.notify_one();
+	chunk.reserve(VCD_CHUNK_SIZE);
+}
+
+uint64_t VcdWriter::getBytesWritten() const
+{
+	return bytes_written;
+}
+
+void VcdWriter::writerMain()
+{
+	std::vector<Change> changes;
+
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+
+			if (!changes.empty()) {
+				changes.clear();
+				free_chunks.emplace_back(std::move(changes));
+			}
+
+			cv.wait(lock, [this] { return quit || !queue.empty(); });
+
+			if (queue.empty()) break;
+
+			changes = std::move(queue.front());
+			queue.pop_front();
+		}
+
+		cv_space.notify_one();
+		writeChunk(changes);
+	}
+
+	writeBuffer();
+	std::fflush(file);
+}
+
+void VcdWriter::writeChunk(const std::vector<Change>& changes)
+{
+	for (const auto& change : changes) {
+		if (!has_tick || change.tick != last_tick) {
+			buffer += '#';
+			buffer += std::to_string(change.tick);
+			buffer += '\n';
+
+			last_tick = change.tick;
+			has_tick  = true;
+		}
+
+		buffer += to_vcd_char(change.value);
+		buffer += ids[change.var];
+		buffer += '\n';
+	}
+
+	if (buffer.size() >= VCD_BUFFER_SIZE)
+		writeBuffer();
+}
+
+void VcdWriter::writeBuffer()
+{
+	bytes_written += std::fwrite(buffer.data(), 1, buffer.size(), file);
+	buffer.clear();
+}
\ No newline at end of file
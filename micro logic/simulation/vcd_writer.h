@@ -0,0 +1,65 @@
+#pragma once
+
+#include "logic_value.h"
+#include "../net.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define VCD_CHUNK_SIZE  (1 << 16) // changes handed to the writer thread at once
+#define VCD_MAX_CHUNKS  16        // chunks waiting to be written before the producer blocks
+#define VCD_BUFFER_SIZE (1 << 20)
+
+// streams value changes to a VCD file. changes are batched into chunks that a background
+// thread formats and writes, so memory stays bounded by VCD_MAX_CHUNKS chunks however long the trace is
+class VcdWriter {
+public:
+	VcdWriter();
+	~VcdWriter();
+
+	bool open(const std::string& path, const std::vector<std::string>& names, const char* timescale = "1ns");
+	// names[i] is declared for variable vars[i], names of one variable are aliases of one signal
+	bool open(const std::string& path, const std::vector<std::string>& names, const std::vector<uint32_t>& vars, const char* timescale = "1ns");
+	void close();
+	bool isOpen() const;
+
+	// producer side, ticks must not decrease
+	void change(uint64_t tick, uint32_t var, LogicValue value);
+	void flush();
+
+	uint64_t getBytesWritten() const;
+
+private:
+	struct Change {
+		uint64_t   tick;
+		uint32_t   var;
+		LogicValue value;
+	};
+
+	void writerMain();
+	void writeChunk(const std::vector<Change>& changes);
+	void writeBuffer();
+
+	std::FILE*               file;
+	std::vector<std::string> ids;
+	std::vector<Change>      chunk;
+
+	std::thread                     thread;
+	std::mutex                      mutex;
+	std::condition_variable         cv;       // writer waits for chunks
+	std::condition_variable         cv_space; // producer waits for room
+	std::deque<std::vector<Change>> queue;
+	std::vector<std::vector<Change>> free_chunks;
+	bool                            quit;
+
+	// writer side
+	std::string           buffer;
+	uint64_t              last_tick;
+	bool                  has_tick;
+	std::atomic<uint64_t> bytes_written;
+};
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "waveform_recorder.h"
+
+#include <algorithm>
+
+WaveformRecorder::WaveformRecorder() :
+	writer(nullptr),
+	last_tick(0),
+	tick_offset(0),
+	transition_count(0)
+{}
+
+void WaveformRecorder::probe(const std::vector<net_id_t>& nets, size_t net_count)
+{
+	clear();
+
+	probe_ids.resize(net_count, NO_PROBE);
+
+	for (auto net : nets) {
+		if (net >= net_count || probe_ids[net] != NO_PROBE) continue;
+
+		probe_ids[net] = (uint32_t)probe_nets.size();
+		probe_nets.emplace_back(net);
+	}
+
+	last_values.resize(probe_nets.size(), 0xff);
+	counts.resize(probe_nets.size(), 0);
+	ring_ticks.resize(probe_nets.size() * WAVEFORM_RING_SIZE);
+	ring_values.resize(probe_nets.size() * WAVEFORM_RING_SIZE);
+}
+
+// the probed nets that differ from their last transition, all of them the first time
+void WaveformRecorder::captureAll(uint64_t tick, const std::vector<uint8_t>& net_values)
+{
+	for (auto net : probe_nets)
+		capture(tick, net, (LogicValue)net_values[net]);
+}
+
+void WaveformRecorder::clear()
+{
+	probe_ids.clear();
+	probe_nets.clear();
+	last_values.clear();
+	counts.clear();
+	ring_ticks.clear();
+	ring_values.clear();
+
+	last_tick        = 0;
+	tick_offset      = 0;
+	transition_count = 0;
+}
+
+void WaveformRecorder::setWriter(VcdWriter* writer)
+{
+	this->writer = writer;
+}
+
+size_t WaveformRecorder::getProbeCount() const
+{
+	return probe_nets.size();
+}
+
+net_id_t WaveformRecorder::getProbeNet(uint32_t probe) const
+{
+	return probe_nets[probe];
+}
+
+uint32_t WaveformRecorder::getProbe(net_id_t net) const
+{
+	return net < probe_ids.size() ? probe_ids[net] : NO_PROBE;
+}
+
+uint64_t WaveformRecorder::getTransitionCount() const
+{
+	return transition_count;
+}
+
+void WaveformRecorder::record(uint32_t probe, uint64_t tick, LogicValue value)
+{
+	if (tick + tick_offset < last_tick)
+		tick_offset = last_tick - tick;
+
+	tick += tick_offset;
+	last_tick = tick;
+
+	auto slot = (size_t)probe * WAVEFORM_RING_SIZE + counts[probe]++ % WAVEFORM_RING_SIZE;
+
+	ring_ticks[slot]   = tick;
+	ring_values[slot]  = value;
+	last_values[probe] = value;
+
+	++transition_count;
+
+	if (writer)
+		writer->change(tick, probe, value);
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "logic_value.h"
+#include "vcd_writer.h"
+#include "../net.h"
+#include <algorithm>
+#include <vector>
+
+#define WAVEFORM_RING_SIZE 256 // transitions kept per probed net
+#define NO_PROBE           UINT32_MAX
+
+// last WAVEFORM_RING_SIZE transitions of each probed net, oldest overwritten first.
+// the engines hand over the nets changed in a tick, so the cost is per transition of
+// a probed net and not per probe per tick. transitions can be streamed to a VcdWriter too
+class WaveformRecorder {
+public:
+	WaveformRecorder();
+
+	void probe(const std::vector<net_id_t>& nets, size_t net_count);
+	void captureAll(uint64_t tick, const std::vector<uint8_t>& net_values);
+	void clear();
+
+	void setWriter(VcdWriter* writer);
+
+	inline void capture(uint64_t tick, net_id_t net, LogicValue value) {
+		auto probe = probe_ids[net];
+
+		if (probe != NO_PROBE && last_values[probe] != value)
+			record(probe, tick, value);
+	}
+
+	template <class NetList>
+	inline void capture(uint64_t tick, const NetList& nets, const std::vector<uint8_t>& net_values) {
+		for (auto net : nets)
+			capture(tick, net, (LogicValue)net_values[net]);
+	}
+
+	// calls func(tick, value) for the kept transitions of a probe, oldest first
+	template <class Func>
+	void forEachTransition(uint32_t probe, Func&& func) const {
+		auto count = (uint32_t)std::min<uint64_t>(counts[probe], WAVEFORM_RING_SIZE);
+		auto first = (uint32_t)(counts[probe] - count);
+		auto base  = (size_t)probe * WAVEFORM_RING_SIZE;
+
+		for (auto i = first; i < first + count; ++i)
+			func(ring_ticks[base + i % WAVEFORM_RING_SIZE], (LogicValue)ring_values[base + i % WAVEFORM_RING_SIZE]);
+	}
+
+	size_t getProbeCount() const;
+	net_id_t getProbeNet(uint32_t probe) const;
+	uint32_t getProbe(net_id_t net) const; // NO_PROBE if not probed, a net probed twice is one probe
+	uint64_t getTransitionCount() const;
+
+private:
+	void record(uint32_t probe, uint64_t tick, LogicValue value);
+
+	std::vector<uint32_t> probe_ids;   // per net
+	std::vector<net_id_t> probe_nets;
+	std::vector<uint8_t>  last_values; // per probe
+	std::vector<uint64_t> counts;      // transitions ever recorded per probe
+	std::vector<uint64_t> ring_ticks;  // WAVEFORM_RING_SIZE per probe
+	std::vector<uint8_t>  ring_values;
+
+	VcdWriter* writer;
+	uint64_t   last_tick;
+	uint64_t   tick_offset; // keeps recorded time increasing over a reset
+	uint64_t   transition_count;
+};
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+inline uint32_t count_trailing_zeros(uint64_t bits) {
+#ifdef _MSC_VER
+	unsigned long idx;
+	_BitScanForward64(&idx, bits);
+	return (uint32_t)idx;
+#else
+	return (uint32_t)__builtin_ctzll(bits);
+#endif
+}
+
+inline uint32_t count_bits(uint64_t bits) {
+#ifdef _MSC_VER
+	return (uint32_t)__popcnt64(bits);
+#else
+	return (uint32_t)__builtin_popcountll(bits);
+#endif
+}
\ No newline at end of file
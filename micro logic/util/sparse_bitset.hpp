@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#define SPARSE_BITSET_PAGE_BITS 12
+#define SPARSE_BITSET_PAGE_SIZE (1 << SPARSE_BITSET_PAGE_BITS)
+#define SPARSE_BITSET_PAGE_WORDS (SPARSE_BITSET_PAGE_SIZE / 64)
+
+// bitset over a large index space with few bits set. the bits live in 4096 bit pages that are
+// allocated when a bit in them is set, so a test is a page lookup and a word load
+class SparseBitset {
+public:
+	void set(size_t idx) {
+		auto page_idx = idx >> SPARSE_BITSET_PAGE_BITS;
+
+		if (page_idx >= pages.size())
+			pages.resize(page_idx + 1);
+
+		auto& page = pages[page_idx];
+
+		if (!page)
+			page = std::make_unique<uint64_t[]>(SPARSE_BITSET_PAGE_WORDS);
+
+		auto bit = idx & (SPARSE_BITSET_PAGE_SIZE - 1);
+		page[bit >> 6] |= 1ull << (bit & 63);
+	}
+
+	void clear() {
+		pages.clear();
+	}
+
+	inline bool test(size_t idx) const {
+		auto page_idx = idx >> SPARSE_BITSET_PAGE_BITS;
+
+		if (page_idx >= pages.size() || !pages[page_idx]) return false;
+
+		auto bit = idx & (SPARSE_BITSET_PAGE_SIZE - 1);
+		return (pages[page_idx][bit >> 6] >> (bit & 63)) & 1;
+	}
+
+	bool empty() const {
+		return pages.empty();
+	}
+
+private:
+	std::vector<std::unique_ptr<uint64_t[]>> pages;
+};
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// bounded lock free queue for exactly one producer and one consumer thread
+template <class Ty, size_t Capacity>
+class SPSCQueue {
+	static_assert(Capacity && !(Capacity & (Capacity - 1)), "capacity must be power of 2");
+
+public:
+	SPSCQueue() :
+		head(0),
+		tail(0)
+	{}
+
+	SPSCQueue(const SPSCQueue&) = delete;
+	SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+	bool push(const Ty& value) {
+		auto t = tail.load(std::memory_order_relaxed);
+
+		if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+
+		items[t & (Capacity - 1)] = value;
+		tail.store(t + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(Ty& value) {
+		auto h = head.load(std::memory_order_relaxed);
+
+		if (h == tail.load(std::memory_order_acquire)) return false;
+
+		value = items[h & (Capacity - 1)];
+		head.store(h + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const {
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+	Ty items[Capacity];
+
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+};
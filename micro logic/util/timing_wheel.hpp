@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#define TIMING_WHEEL_BITS   8
+#define TIMING_WHEEL_SLOTS  (1 << TIMING_WHEEL_BITS)
+#define TIMING_WHEEL_LEVELS 4
+
+// hierarchical calendar queue. level n holds events that are less than 2^(8(n + 1)) ticks away,
+// a level n slot is cascaded into lower levels when the time reaches it, so schedule and
+// fire are O(1) per event. events beyond the last level wait in the overflow list
+template <class Ty>
+class TimingWheel {
+	struct Event {
+		uint64_t time;
+		Ty       value;
+	};
+
+public:
+	TimingWheel() :
+		now(0),
+		count(0)
+	{}
+
+	void clear(uint64_t time = 0) {
+		if (count) {
+			for (auto& level : slots)
+				for (auto& slot : level)
+					slot.clear();
+
+			overflow.clear();
+		}
+
+		now   = time;
+		count = 0;
+	}
+
+	void schedule(uint64_t time, const Ty& value) {
+		assert(time > now);
+
+		place({ time, value });
+		++count;
+	}
+
+	// moves the time forward and calls func with every event that comes due, in time order
+	template <class Func>
+	void advance(uint64_t time, Func&& func) {
+		while (now < time) {
+			if (!count) {
+				now = time;
+				return;
+			}
+
+			++now;
+			cascade();
+
+			auto& slot = slots[0][now & (TIMING_WHEEL_SLOTS - 1)];
+
+			for (size_t i = 0; i < slot.size(); ++i) {
+				assert(slot[i].time == now);
+				func(slot[i].value);
+			}
+
+			count -= slot.size();
+			slot.clear();
+		}
+	}
+
+	// calls func(time, value) with every pending event, in no particular order
+	template <class Func>
+	void forEach(Func&& func) const {
+		for (const auto& level : slots)
+			for (const auto& slot : level)
+				for (const auto& event : slot)
+					func(event.time, event.value);
+
+		for (const auto& event : overflow)
+			func(event.time, event.value);
+	}
+
+	uint64_t getTime() const {
+		return now;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	bool empty() const {
+		return !count;
+	}
+
+private:
+	void place(const Event& event) {
+		auto diff = event.time ^ now;
+
+		for (uint32_t level = 0; level < TIMING_WHEEL_LEVELS; ++level) {
+			if (diff < (1ull << (TIMING_WHEEL_BITS * (level + 1)))) {
+				auto idx = (event.time >> (TIMING_WHEEL_BITS * level)) & (TIMING_WHEEL_SLOTS - 1);
+				slots[level][idx].emplace_back(event);
+				return;
+			}
+		}
+
+		overflow.emplace_back(event);
+	}
+
+	// redistributes the higher level slots that start at now, highest first
+	void cascade() {
+		uint32_t top = 0;
+
+		while (top < TIMING_WHEEL_LEVELS && !(now & ((1ull << (TIMING_WHEEL_BITS * (top + 1))) - 1)))
+			++top;
+
+		if (top == TIMING_WHEEL_LEVELS) {
+			redistribute(overflow);
+			--top;
+		}
+
+		for (uint32_t level = top; level > 0; --level)
+			redistribute(slots[level][(now >> (TIMING_WHEEL_BITS * level)) & (TIMING_WHEEL_SLOTS - 1)]);
+	}
+
+	void redistribute(std::vector<Event>& events) {
+		if (events.empty()) return;
+
+		scratch.swap(events);
+
+		for (const auto& event : scratch)
+			place(event);
+
+		scratch.clear();
+	}
+
+	std::vector<Event> slots[TIMING_WHEEL_LEVELS][TIMING_WHEEL_SLOTS];
+	std::vector<Event> overflow;
+	std::vector<Event> scratch;
+	uint64_t           now;
+	size_t             count;
+};
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// single producer, single consumer. the producer fills back() and publishes it,
+// the consumer picks up the latest published buffer with update() and reads front()
+template <class Ty>
+class TripleBuffer {
+	static constexpr uint32_t FRESH_BIT  = 1 << 2;
+	static constexpr uint32_t INDEX_MASK = FRESH_BIT - 1;
+
+public:
+	TripleBuffer() :
+		buffers(),
+		middle(1),
+		back_idx(0),
+		front_idx(2)
+	{}
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+	Ty& back() {
+		return buffers[back_idx];
+	}
+
+	void publish() {
+		auto prev = middle.exchange(back_idx | FRESH_BIT, std::memory_order_acq_rel);
+		back_idx  = prev & INDEX_MASK;
+	}
+
+	bool update() {
+		if (!(middle.load(std::memory_order_relaxed) & FRESH_BIT)) return false;
+
+		auto prev = middle.exchange(front_idx, std::memory_order_acq_rel);
+		front_idx = prev & INDEX_MASK;
+		return true;
+	}
+
+	const Ty& front() const {
+		return buffers[front_idx];
+	}
+
+	Ty& front() {
+		return buffers[front_idx];
+	}
+
+private:
+	Ty                    buffers[3];
+	std::atomic<uint32_t> middle;
+	uint32_t              back_idx;
+	uint32_t              front_idx;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <numeric>
+
+class UnionFind {
+public:
+	UnionFind() = default;
+
+	UnionFind(uint32_t size) {
+		reset(size);
+	}
+
+	inline void reset(uint32_t size) {
+		parents.resize(size);
+		sizes.assign(size, 1);
+		std::iota(parents.begin(), parents.end(), 0);
+	}
+
+	inline uint32_t find(uint32_t x) {
+		while (parents[x] != x) {
+			parents[x] = parents[parents[x]];
+			x          = parents[x];
+		}
+
+		return x;
+	}
+
+	inline bool unite(uint32_t a, uint32_t b) {
+		a = find(a);
+		b = find(b);
+
+		if (a == b) return false;
+
+		if (sizes[a] < sizes[b])
+			std::swap(a, b);
+
+		parents[b] = a;
+		sizes[a]  += sizes[b];
+		return true;
+	}
+
+	inline size_t size() const {
+		return parents.size();
+	}
+
+private:
+	std::vector<uint32_t> parents;
+	std::vector<uint32_t> sizes;
+};
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
+#ifndef MICRO_LOGIC_HEADLESS
 #include <imgui.h>
+#endif
 #include <vk2d/core/vector_type.h>
 #include <vk2d/core/rect.h>
 #include <vk2d/core/color.h>
@@ -21,6 +23,7 @@ using uRect = vk2d::uRect;
 
 using Color = vk2d::Color;
 
+#ifndef MICRO_LOGIC_HEADLESS
 static inline ImVec2 to_ImVec2(const vec2& v) {
 	return { v.x, v.y };
 }
@@ -48,6 +51,7 @@ static inline uvec2 to_uvec2(const ImVec2& v) {
 static inline ImColor to_ImColor(const vk2d::Color& color) {
 	return { color.r, color.g, color.b, color.a };
 }
+#endif
 
 static inline Rect scale_rect(const Rect& rect, float scale) {
 	return { rect.left * scale, rect.top * scale, rect.width * scale, rect.height * scale };
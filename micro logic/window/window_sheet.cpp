@@ -3,12 +3,16 @@
 #include <vk2d/system/clipboard.h>
 #include <imgui_internal.h>
 #include <sstream>
+#include <cmath>
+#include <algorithm>
 #include <fstream>
 #include "../main_window.h"
 #include "../base64.h"
 #include "../micro_logic_config.h"
 #include "../commands.h"
 
+#define CLICK_THRESHOLD 5 // px the cursor may move between press and release of a click
+
 static inline ImRect to_ImRect(const vk2d::Rect& rect)
 {
 	return { to_ImVec2(rect.getPosition()), to_ImVec2(rect.getSize()) };
@@ -22,8 +26,10 @@ Window_Sheet::Window_Sheet() :
 	content_center(0.f),
 	prev_position(0.f),
 	prev_scale(1.f),
+	wire_sequence(0),
 	capturing_mouse(false),
-	update_grid(true)
+	update_grid(true),
+	update_wires(true)
 {}
 
 Window_Sheet::Window_Sheet(SchematicSheet& sheet) :
@@ -71,6 +77,13 @@ void Window_Sheet::showUI()
 				main_window.setCurrentWindowSheet(this);
 			}
 		}
+
+		if (auto* menu = dynamic_cast<Menu_Unit*>(main_window.curr_menu); menu && hovered) {
+			if (menu->curr_unit != -1) {
+				ImGui::SetWindowFocus();
+				main_window.setCurrentWindowSheet(this);
+			}
+		}
 	} else {
 		capturing_mouse = false;
 	}
@@ -96,8 +109,27 @@ void Window_Sheet::showUI()
 		cmd.options.scissor   = window_rect;
 	}
 
-	for (const auto& elem : sheet->bvh)
+	bool simulating = main_window.simulation.isRunning() && main_window.simulated_sheet == sheet;
+
+	if (simulating)
+		showWires();
+	else if (!update_wires) {
+		draw_list[1].clear(false);
+		update_wires = true;
+	}
+
+	for (const auto& elem : sheet->bvh) {
+		// plain wires and buses are kept in draw_list[1] while simulating
+		auto type = elem.second->getType();
+
+		if (simulating && (type == CircuitElement::Wire || type == CircuitElement::Net) && !(elem.second->style & (CircuitElement::Selected | CircuitElement::Hovered)))
+			continue;
+
 		elem.second->draw(draw_list);
+	}
+
+	if (simulating && main_window.simulation.isProfiling())
+		showActivity();
 }
 
 void Window_Sheet::EventProc(const vk2d::Event& e, float dt)
@@ -116,6 +148,12 @@ void Window_Sheet::EventProc(const vk2d::Event& e, float dt)
 			sheet->position -= (vec2)delta / sheet->grid_pixel_size;
 		}
 	} break;
+	case Event::MouseReleased: {
+		if (main_window.curr_menu || !capturing_mouse || e.mouseButton.button != Mouse::Left) break;
+
+		if (length(getDragRect(Mouse::Left).getSize()) <= CLICK_THRESHOLD)
+			toggleInput(getCursorPlanePos());
+	} break;
 	case Event::WheelScrolled: {
 		if (!window_rect.contain(e.wheel.pos)) return;
 
@@ -157,6 +195,34 @@ void Window_Sheet::SheetRenamed()
 	window_name = sheet->name + "###" + sheet->guid;
 }
 
+// a click on a unit input while the sheet is simulated drives its net, 1 unless it is 1 already
+void Window_Sheet::toggleInput(const vec2& pos)
+{
+	auto& main_window = MainWindow::get();
+
+	if (!main_window.simulation.isRunning() || main_window.simulated_sheet != sheet) return;
+
+	// the net ids of the sheet have to be the ones simulated
+	main_window.syncSimulation();
+
+	sheet->bvh.query(pos, [&](auto iter) {
+		auto type = iter->second->getType();
+
+		if (type != CircuitElement::LogicGate && type != CircuitElement::LogicUnit) BVH_CONTINUE;
+
+		auto& elem = static_cast<LogicElement&>(*iter->second);
+
+		if (elem.shared->port != LogicElement::Shared::Port::Input || elem.pins.empty() || !elem.pins[0].net) BVH_CONTINUE;
+
+		const auto& values = main_window.simulation.getSnapshot().net_values;
+		auto net           = elem.pins[0].net->id;
+		auto value         = net < values.size() && values[net] == Logic_1 ? Logic_0 : Logic_1;
+
+		main_window.simulation.setNet(net, value);
+		BVH_BREAK;
+	});
+}
+
 void Window_Sheet::bindSchematicSheet(SchematicSheet& sheet)
 {
 	auto& main_window = MainWindow::get();
@@ -171,10 +237,11 @@ void Window_Sheet::bindSchematicSheet(SchematicSheet& sheet)
 	prev_position = sheet.position;
 	prev_scale    = sheet.scale;
 	update_grid   = true;
+	update_wires  = true;
 	show          = true;
 
 	draw_list.clear();
-	draw_list.resize(2);
+	draw_list.resize(3);
 	for (auto& texture : main_window.gate_textures) {
 		auto& cmd = draw_list.commands.emplace_back();
 
@@ -265,8 +332,10 @@ void Window_Sheet::pushCommand(std::unique_ptr<Command>&& cmd, bool skip_redo)
 
 	if (!skip_redo) 
 		cmd->redo(*sheet);
-	if (cmd->isModifying())
+	if (cmd->isModifying()) {
 		MainWindow::get().updateThumbnail(*sheet);
+		update_wires = true;
+	}
 
 	command_stack.push_back(std::move(cmd));
 
@@ -292,8 +361,10 @@ void Window_Sheet::setCurrCommandTo(int64_t next_cmd)
 		modified |= cmd->isModifying();
 	}
 
-	if (modified)
+	if (modified) {
 		MainWindow::get().updateThumbnail(*sheet);
+		update_wires = true;
+	}
 
 	sheet->is_up_to_date = isCommandInSavedRange(curr_command);
 }
@@ -305,8 +376,10 @@ void Window_Sheet::redo()
 	auto& cmd = command_stack[++curr_command];
 
 	cmd->redo(*sheet);
-	if (cmd->isModifying())
+	if (cmd->isModifying()) {
 		MainWindow::get().updateThumbnail(*sheet);
+		update_wires = true;
+	}
 
 	sheet->is_up_to_date = isCommandInSavedRange(curr_command);
 }
@@ -318,8 +391,10 @@ void Window_Sheet::undo()
 	auto& cmd = command_stack[curr_command--];
 
 	cmd->undo(*sheet);
-	if (cmd->isModifying())
+	if (cmd->isModifying()) {
 		MainWindow::get().updateThumbnail(*sheet);
+		update_wires = true;
+	}
 
 	sheet->is_up_to_date = isCommandInSavedRange(curr_command);
 }
@@ -373,7 +448,7 @@ void Window_Sheet::draw()
 	if (!window || !visible) return;
 	window->draw(draw_list);
 
-	for (size_t i = 1; i < draw_list.commands.size(); ++i)
+	for (size_t i = 2; i < draw_list.commands.size(); ++i)
 		draw_list[i].clear(false);
 }
 
@@ -444,6 +519,235 @@ void Window_Sheet::showBVH()
 	});
 }
 
+void Window_Sheet::showWires()
+{
+	// indexed by LogicValue
+	static const vk2d::Color colors[] = {
+		vk2d::Color(222, 62, 62),
+		vk2d::Color(72, 122, 222),
+		vk2d::Color(30, 90, 54),
+		vk2d::Color(96, 232, 120)
+	};
+
+	// a bus is colored by its bits: all known, any X, else any Z
+	static const vk2d::Color bus_colors[] = {
+		vk2d::Color(226, 190, 72),
+		vk2d::Color(222, 62, 62),
+		vk2d::Color(72, 122, 222)
+	};
+
+	const auto& snapshot = MainWindow::get().simulation.getSnapshot();
+	auto& cmd            = draw_list[1];
+
+	// rebuilt after every edit of the sheet and when a start renumbers the nets
+	if (update_wires) {
+		std::vector<const WireElement*> wires;
+
+		wire_buses.clear();
+
+		for (const auto& [aabb, elem] : sheet->bvh) {
+			if (elem->getType() == CircuitElement::Net) {
+				wire_buses.emplace_back(static_cast<const Bus*>(elem.get()));
+				continue;
+			}
+
+			if (elem->getType() != CircuitElement::Wire) continue;
+
+			auto& wire = static_cast<const WireElement&>(*elem);
+
+			if (wire.net) wires.emplace_back(&wire);
+		}
+
+		std::sort(wires.begin(), wires.end(), [](const WireElement* lhs, const WireElement* rhs) {
+			return lhs->net->id < rhs->net->id;
+		});
+
+		cmd.clear(false);
+		wire_vertex_offsets.assign(sheet->netlist.getNetCount() + 1, 0);
+
+		for (auto* wire : wires) {
+			cmd.addFilledCapsule(wire->p0, wire->p1, 4 / DEFAULT_GRID_SIZE, colors[Logic_X]);
+
+			if (wire->dot0) cmd.addFilledCircle(wire->p0, 6 / DEFAULT_GRID_SIZE, colors[Logic_X]);
+			if (wire->dot1) cmd.addFilledCircle(wire->p1, 6 / DEFAULT_GRID_SIZE, colors[Logic_X]);
+
+			wire_vertex_offsets[wire->net->id + 1] = (uint32_t)cmd.vertices.size();
+		}
+
+		for (size_t i = 1; i < wire_vertex_offsets.size(); ++i)
+			wire_vertex_offsets[i] = std::max(wire_vertex_offsets[i], wire_vertex_offsets[i - 1]);
+
+		bus_vertex_offsets.assign(1, (uint32_t)cmd.vertices.size());
+		net_bus_offsets.assign(sheet->netlist.getNetCount() + 1, 0);
+
+		for (auto* bus : wire_buses) {
+			cmd.addFilledCapsule(bus->p0, bus->p1, 8 / DEFAULT_GRID_SIZE, bus_colors[1]);
+
+			if (bus->dot0) cmd.addFilledCircle(bus->p0, 10 / DEFAULT_GRID_SIZE, bus_colors[1]);
+			if (bus->dot1) cmd.addFilledCircle(bus->p1, 10 / DEFAULT_GRID_SIZE, bus_colors[1]);
+
+			bus_vertex_offsets.emplace_back((uint32_t)cmd.vertices.size());
+
+			for (auto* net : bus->nets)
+				if (net) ++net_bus_offsets[net->id + 1];
+		}
+
+		for (size_t i = 1; i < net_bus_offsets.size(); ++i)
+			net_bus_offsets[i] += net_bus_offsets[i - 1];
+
+		net_buses.resize(net_bus_offsets.back());
+
+		auto heads = net_bus_offsets;
+
+		for (uint32_t i = 0; i < wire_buses.size(); ++i)
+			for (auto* net : wire_buses[i]->nets)
+				if (net) net_buses[heads[net->id]++] = i;
+
+		bus_marks.assign(wire_buses.size(), 0);
+
+		wire_sequence = 0;
+		update_wires  = false;
+	}
+
+	if (snapshot.sequence == wire_sequence) return;
+
+	auto recolor = [&](net_id_t net) {
+		if (net + 1 >= wire_vertex_offsets.size()) return;
+
+		auto color = colors[snapshot.net_values[net] & 3];
+
+		for (auto i = wire_vertex_offsets[net]; i < wire_vertex_offsets[net + 1]; ++i)
+			cmd.vertices[i].color = color;
+	};
+
+	auto recolor_bus = [&](uint32_t bus) {
+		uint32_t summary = 0;
+
+		for (auto* net : wire_buses[bus]->nets) {
+			if (!net || net->id >= snapshot.net_values.size()) continue;
+
+			auto value = snapshot.net_values[net->id] & 3;
+
+			if (value == Logic_X) {
+				summary = 1;
+				break;
+			}
+
+			if (value == Logic_Z) summary = 2;
+		}
+
+		for (auto i = bus_vertex_offsets[bus]; i < bus_vertex_offsets[bus + 1]; ++i)
+			cmd.vertices[i].color = bus_colors[summary];
+	};
+
+	// the changed nets cover every snapshot since the base, the colors are of one of them unless
+	// they were just rebuilt or the window was not shown while the ui picked up the base
+	auto delta = wire_sequence && snapshot.base_sequence <= wire_sequence;
+
+	if (delta) {
+		std::vector<uint32_t> buses;
+
+		for (auto net : snapshot.changed_nets) {
+			recolor(net);
+
+			if (net + 1 >= net_bus_offsets.size()) continue;
+
+			for (auto i = net_bus_offsets[net]; i < net_bus_offsets[net + 1]; ++i) {
+				if (bus_marks[net_buses[i]]) continue;
+
+				bus_marks[net_buses[i]] = true;
+				buses.emplace_back(net_buses[i]);
+			}
+		}
+
+		for (auto bus : buses) {
+			recolor_bus(bus);
+			bus_marks[bus] = false;
+		}
+	} else {
+		for (net_id_t net = 0; net < snapshot.net_values.size(); ++net)
+			recolor(net);
+
+		for (uint32_t bus = 0; bus < wire_buses.size(); ++bus)
+			recolor_bus(bus);
+	}
+
+	wire_sequence = snapshot.sequence;
+
+	if (!delta || !snapshot.changed_nets.empty())
+		cmd.update();
+}
+
+// log scale from blue for idle to red for the most active
+static vk2d::Color heat_color(uint64_t count, uint64_t max_count)
+{
+	static const vec3 colors[] = {
+		vec3(0.f, 0.f, 255.f),
+		vec3(0.f, 255.f, 0.f),
+		vec3(255.f, 255.f, 0.f),
+		vec3(255.f, 0.f, 0.f)
+	};
+
+	auto t   = max_count ? std::log1p((float)count) / std::log1p((float)max_count) * 3.f : 0.f;
+	auto idx = std::min((int)t, 2);
+	auto col = colors[idx] + (colors[idx + 1] - colors[idx]) * (t - idx);
+
+	return vk2d::Color((uint8_t)col.x, (uint8_t)col.y, (uint8_t)col.z, 160);
+}
+
+void Window_Sheet::showActivity()
+{
+	auto& main_window    = MainWindow::get();
+	const auto& snapshot = main_window.simulation.getSnapshot();
+	const auto& elements = sheet->netlist.elements;
+
+	// published for another netlist, the simulation restarts once the edits settle
+	if (snapshot.element_activity.size() != elements.size()) return;
+
+	auto& cmd = draw_list.commands.back();
+
+	uint64_t max_evaluations = 0;
+	uint64_t max_toggles     = 0;
+
+	for (auto count : snapshot.element_activity)
+		max_evaluations = std::max(max_evaluations, count);
+
+	for (auto count : snapshot.net_activity)
+		max_toggles = std::max(max_toggles, count);
+
+	for (size_t i = 0; i < elements.size(); ++i) {
+		Rect rect = elements[i]->getAABB();
+
+		cmd.addFilledRect(rect.getPosition(), rect.getSize(), heat_color(snapshot.element_activity[i], max_evaluations));
+	}
+
+	for (const auto& [aabb, elem] : sheet->bvh) {
+		// a bus is as hot as its busiest bit
+		if (elem->getType() == CircuitElement::Net) {
+			if (snapshot.net_activity.empty()) continue;
+
+			auto& bus = static_cast<const Bus&>(*elem);
+
+			uint64_t toggles = 0;
+
+			for (auto* net : bus.nets)
+				if (net && net->id < snapshot.net_activity.size())
+					toggles = std::max(toggles, snapshot.net_activity[net->id]);
+
+			cmd.addFilledCapsule(bus.p0, bus.p1, 10 / DEFAULT_GRID_SIZE, heat_color(toggles, max_toggles));
+			continue;
+		}
+
+		if (elem->getType() != CircuitElement::Wire) continue;
+
+		auto& wire = static_cast<const WireElement&>(*elem);
+
+		if (!wire.net || wire.net->id >= snapshot.net_activity.size()) continue;
+
+		cmd.addFilledCapsule(wire.p0, wire.p1, 6 / DEFAULT_GRID_SIZE, heat_color(snapshot.net_activity[wire.net->id], max_toggles));
+	}
+}
+
 void Window_Sheet::showDragRect(vk2d::Mouse::Button button)
 {
 	if (!ImGui::IsMouseDragging(button)) return;
@@ -49,11 +49,14 @@ public:
 	void clearCommand();
 
 	void deleteElement(const AABB& aabb);
+	void toggleInput(const vec2& pos);
 
 public: // drawing
 	void draw();
 	void showGrid();
 	void showBVH();
+	void showWires();
+	void showActivity();
 
 	void showDragRect(vk2d::Mouse::Button button);
 
@@ -90,6 +93,19 @@ public:
 	vec2  prev_position;
 	float prev_scale;
 
+	// vertices of the wires of net n in draw_list[1] while simulating, as CSR
+	std::vector<uint32_t> wire_vertex_offsets;
+	uint64_t              wire_sequence; // snapshot the wire colors are of
+
+	// buses after the wires, vertices of wire_buses[n] start at bus_vertex_offsets[n].
+	// the buses a bit net is on are net_buses[net_bus_offsets[net]..] for recoloring them
+	std::vector<const Bus*> wire_buses;
+	std::vector<uint32_t>   bus_vertex_offsets;
+	std::vector<uint32_t>   net_bus_offsets;
+	std::vector<uint32_t>   net_buses;
+	std::vector<uint8_t>    bus_marks;
+
 	bool capturing_mouse;
 	bool update_grid;
+	bool update_wires;
 };
\ No newline at end of file
@@ -29,6 +29,9 @@ public:
 
 	uint32_t reservePrims(uint32_t vertex_count, uint32_t index_count);
 
+	// uploads the buffers again on the next draw, after vertices were written in place
+	void update();
+
 	void clear(bool clear_options = true);
 
 	std::vector<Vertex>   vertices;
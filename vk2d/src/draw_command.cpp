@@ -243,6 +243,11 @@ uint32_t DrawCommand::reservePrims(uint32_t vertex_count, uint32_t index_count)
 	return (uint32_t)vertices.size();
 }
 
+void DrawCommand::update()
+{
+	update_buffers = true;
+}
+
 void DrawCommand::clear(bool clear_options)
 {
 	vertices.clear();